@@ -8,11 +8,14 @@
 #define MATRIX_MASKED
 #define DEBOUNCE 5
 
+#define EECONFIG_KB_DATA_SIZE 16   // 拡張設定（ee_config_ext_t）の保存領域
+
 //#define SPLIT_HAND_MATRIX_GRID  GP21, GP23
 #define SPLIT_HAND_MATRIX_GRID_LOW_IS_LEFT
 #define SPLIT_MAX_CONNECTION_ERRORS 10
 #define SPLIT_CONNECTION_CHECK_TIMEOUT 500
 #define SPLIT_LAYER_STATE_ENABLE
+#define SPLIT_TRANSACTION_IDS_KB MTK_SPLIT_MOTION, MTK_SPLIT_STATE   // スレーブ側の移動量、設定と表示状態（mtk_split.c）
 
 #define USB_POLLING_INTERVAL_MS 1
 #define F_SCL 400000UL
@@ -25,7 +28,11 @@
 #    define SPI_MOSI_PIN GP15
 #    define PMW33XX_CS_PIN GP13
 #    define POINTING_DEVICE_CS_PIN GP13
+//#    define MTK_SENSOR_MOTION_PIN GP11  // センサーの MOTION 端子を配線した場合のみ（移動があるときだけ読む、この基板では未確認）
 #    define MOUSE_EXTENDED_REPORT
+#    define WHEEL_EXTENDED_REPORT
+#    define POINTING_DEVICE_HIRES_SCROLL_ENABLE
+#    define POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER 120
 
 #    define SPLIT_POINTING_ENABLE
 #    define POINTING_DEVICE_TASK_THROTTLE_MS 0
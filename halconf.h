@@ -3,8 +3,8 @@
 
 #pragma once
 
-/* OLED */
-#ifdef OLED_ENABLE
+/* OLED（OLED_TRANSPORT = custom では mtk_oled.c が I2C1 を直接操作する） */
+#if defined(OLED_ENABLE) && defined(OLED_TRANSPORT_I2C)
 #    undef HAL_USE_I2C
 #    define HAL_USE_I2C TRUE
 #endif
@@ -5,12 +5,25 @@ SPDX-License-Identifier: GPL-2.0-or-later
 
 #include "transactions.h"       // トランザクション管理用ヘッダ
 #include "split_util.h"         // 分割キーボードユーティリティ
+#include "transport.h"          // 分割キーボードの接続状態
 #include "eeprom.h"             // EEPROM操作用ヘッダ
 #include "timer.h"              // タイマー管理ヘッダ
 #include "quantum.h"            // QMK量子レイヤーヘッダ
 #include <math.h>               // 数学関数ライブラリ
+#include <string.h>             // memcpy
 #include <print.h>              // デバッグ用プリントライブラリ
 #include "../../drivers/sensors/pmw3389.h" // トラックボールセンサー用ライブラリ
+#include "mtk_trace.h"          // 移動量トレース記録
+#include "mtk_sensor.h"         // センサー読み取りの統計
+#include "mtk_split.h"          // 左右間の通信
+#include "mtk_matrix.h"         // キーマトリクスのスキャン回数
+#include "mtk_debounce.h"       // チャタリング除去の処理時間
+#include "mtk_latency.h"        // ループ時間とキー入力の遅延
+#include "mtk_oled.h"           // OLED の転送
+#include "mtk_fmt.h"            // OLED 表示用の整数の書式化
+#ifdef VIA_ENABLE
+#    include "raw_hid.h"        // raw HID 送信
+#endif
 
 #include QMK_KEYBOARD_H         // キーボード設定ヘッダ
 #ifdef CONSOLE_ENABLE
@@ -78,20 +91,27 @@ const matrix_row_t matrix_mask[MATRIX_ROWS] = {
 #    define MTK_SCROLL_DIV_MAX           32   // スクロール分割値の最大値
 #endif
 
-#ifndef MTK_SCROLLBALL_INHIVITOR
-#    define MTK_SCROLLBALL_INHIVITOR     5    // スクロールボールの動き抑制値
+#ifndef MTK_INERTIA_FRICTION
+#    define MTK_INERTIA_FRICTION         235  // 慣性スクロールの減衰率（1tickごとに速度を n/256 倍）
+#endif
+
+// トラックボールが片側だけの場合に使う側の設定
+#if defined(POINTING_DEVICE_LEFT)
+#    define MTK_SIDE_LOCAL               MTK_SIDE_LEFT
+#else
+#    define MTK_SIDE_LOCAL               MTK_SIDE_RIGHT
 #endif
 
-#ifndef MTK_SCROLLSNAP_ENABLE
-#    define MTK_SCROLLSNAP_ENABLE        1    // スクロールスナップ機能の有効化
+#ifndef MTK_REST1_TIME
+#    define MTK_REST1_TIME               10   // 最後の移動からセンサーが REST1 に入るまでの時間（100ms単位）
 #endif
 
-#ifndef MTK_SCROLLSNAP_RESET_TIMER
-#    define MTK_SCROLLSNAP_RESET_TIMER   100  // スクロールスナップのリセットタイマー値（ミリ秒）
+#ifndef MTK_REST2_TIME
+#    define MTK_REST2_TIME               10   // 最後の移動から REST2 に入るまでの時間（秒）
 #endif
 
-#ifndef MTK_SCROLLSNAP_TENSION_THRESHOLD
-#    define MTK_SCROLLSNAP_TENSION_THRESHOLD 12   // スクロールスナップの張力閾値
+#ifndef MTK_REST3_TIME
+#    define MTK_REST3_TIME               60   // 最後の移動から REST3 に入るまでの時間（秒）
 #endif
 
 #ifndef MTK_SPEED_ADJUST_DEFAULT
@@ -101,11 +121,11 @@ const matrix_row_t matrix_mask[MATRIX_ROWS] = {
 #    define MTK_SPEED_ADJUST_STEP        1    // 速度調整のステップ
 #endif
 
-#define XSCALE_FACTOR                    1.0    // X方向のスケールファクター
-#define YSCALE_FACTOR                    1.0    // Y方向のスケールファクター
-
 // メモリ変数初期化
 ee_config_t ee_config = {0};
+ee_config_ext_t ee_config_ext = {0};
+
+_Static_assert(sizeof(ee_config_ext_t) <= EECONFIG_KB_DATA_SIZE, "ee_config_ext_t does not fit in EECONFIG_KB_DATA_SIZE");
 
 // OLEDに表示するレイヤ名
 const char layer0_name[] = "Deflt";  // レイヤ0
@@ -131,6 +151,18 @@ const char *const layer_names[] = {
 // 打鍵数カウント
 static uint32_t type_count = 0;
 
+// OLEDの表示ページ（OLED_PG キーで切り替え）
+enum {
+    MTK_OLED_PAGE_MAIN,     // 通常の表示
+    MTK_OLED_PAGE_SPLIT,    // 左右間の通信の状態
+    MTK_OLED_PAGE_MATRIX,   // キーマトリクスのスキャン
+    MTK_OLED_PAGE_LATENCY,  // ループ時間とキー入力の遅延
+    MTK_OLED_PAGE_KEYLOG,   // キーログの履歴
+    MTK_OLED_PAGE_COUNT
+};
+static uint8_t oled_page = MTK_OLED_PAGE_MAIN;
+static bool    oled_redraw = true;  // 次の描画で全行を描き直す（画面を消したときに立てる）
+
 
 //////////////////////////////////////////////////////////////////////////////
 // Constants
@@ -141,39 +173,61 @@ static uint32_t type_count = 0;
  * CPI、スクロール設定、自動マウスモード、速度調整値、
  * OLED表示設定などの動作パラメータを管理。
  * ****************************************************************************/
+#define MTK_SIDE_CONFIG_DEFAULT {                          \
+    .cpi_value            = MTK_CPI_DEFAULT,              \
+    .speed_adjust_enabled = true,                         \
+    .speed_adjust_value   = MTK_SPEED_ADJUST_DEFAULT,     \
+    .scroll_snap_mode     = MTK_SCROLLSNAP_MODE_VERTICAL, \
+    .scroll_always        = false,                        \
+}
+
 mtk_config_t mtk_config = {
-    .cpi_value            = MTK_CPI_DEFAULT,              // デフォルトCPI設定
+    .side                 = {MTK_SIDE_CONFIG_DEFAULT, MTK_SIDE_CONFIG_DEFAULT}, // 左右ともデフォルトCPI・速度調整有効・垂直スナップ
+    .edit_side            = MTK_SIDE_RIGHT,               // キーで右側の設定を変更
     .cpi_changed          = false,                        // CPI変更フラグ
     .scroll_mode          = false,                        // スクロールモード無効
     .scroll_direction     = false,                        // スクロール方向（通常）
     .scroll_div           = MTK_SCROLL_DIV_DEFAULT,       // デフォルトのスクロール分割値
     .auto_mouse_mode      = true,                         // 自動マウスモード有効
     .auto_mouse_time_out  = AUTO_MOUSE_TIME,              // 自動マウスモードのタイムアウト値
-    .scroll_snap_mode     = MTK_SCROLLSNAP_MODE_VERTICAL, // 垂直スナップモード
-    .speed_adjust_enabled = true,                         // 速度調整機能有効
-    .speed_adjust_value   = MTK_SPEED_ADJUST_DEFAULT,     // デフォルトの速度調整値
-    .oled_orient          = MTK_OLED_ORIENT               // OLED表示の方向
+    .oled_orient          = MTK_OLED_ORIENT,              // OLED表示の方向
+    .scroll_hires         = true,                         // 高分解能スクロール有効
+    .inertia_enabled      = true,                         // 慣性スクロール有効
+    .inertia_friction     = MTK_INERTIA_FRICTION          // 慣性スクロールの減衰率
 };
 
 /****************************************************************************
  * remote_motion
  *
  * トラックボールのリモート側（スレーブデバイス）から送信される動作情報を保持。
- * 動作の同期やデバイス間の調整処理に利用する。
+ * mtk_split_motion_sync が移動量を足し、pointing_device_task_combined_kb が取り出す。
  * ****************************************************************************/
 mtk_motion_t remote_motion;
 
 
+/****************************************************************************
+ * split_state_changed
+ *
+ * スレーブの表示に使う設定や状態が変わったことを記録する（mtk_split.c で送る）。
+ * ****************************************************************************/
+static void split_state_changed(void) {
+#ifdef SPLIT_KEYBOARD
+    mtk_split_state_changed();
+#endif
+}
+
+
 /****************************************************************************
  * add_cpi
  *
- * トラックボールの感度（CPI: Counts Per Inch）を調整する。
+ * 設定中の側（mtk_get_edit_side）のトラックボールの感度（CPI: Counts Per Inch）を調整する。
  * 現在のCPI値にdeltaを加算または減算し、結果を設定する。
  * CPI値が1未満にならないように制限する。
  * ****************************************************************************/
 static void add_cpi(int16_t delta) {
-    int16_t v = mtk_get_cpi() + delta;
-    mtk_set_cpi(v < 1 ? 1 : v);
+    uint8_t side = mtk_get_edit_side();
+    int16_t v    = mtk_get_cpi(side) + delta;
+    mtk_set_cpi(side, v < 1 ? 1 : v);
 }
 
 
@@ -205,95 +259,6 @@ static void add_auto_mouse_time_out(int16_t delta) {
 #endif
 
 
-/****************************************************************************
- * constrain_hid
- *
- * HIDの範囲内（-127から127）に値を制限する。
- * 入力値が範囲を超える場合は、それぞれの境界値に切り詰める。
- * ****************************************************************************/
-static int8_t constrain_hid(int16_t value) {
-    if (value > 127) {
-        return 127;
-    } else if (value < -127) {
-        return -127;
-    }
-    return (int8_t)value;
-}
-
-
-/******************************************************************************
- * Function: motion_to_mouse
- * --------------------------------------------------------------------------
- * トラックボールの移動量をマウスレポートに変換
- * --------------------------------------------------------------------------
- * トラックボールから取得した移動量（delta_x, delta_y）をCPIや速度調整設定を考慮して計算し、
- * マウスレポート（x, y）に反映する。
- *
- * ■パラメータ詳細
- * 1. XSCALE_FACTOR および YSCALE_FACTOR
- *    - 説明: XSCALE_FACTOR と YSCALE_FACTOR は、カーソルの最終的な動きをスケーリング
- *            （倍率を掛ける）ためのパラメータです。これにより、トラックボールの動きが
- *            カーソルの動きにどれだけ反映されるかを調整します。
- *    - 設定方法: これらの値を「大きく」するとカーソルの移動が「遅く」なり、値を「小さく」
- *                するとカーソルの移動が「速く」なります。
- *    - 推奨設定: 非線形的な速度調整を目指す場合、1.0〜2.0 の範囲で微調整することで
- *                直感的に扱いやすい速度にします。
- *                非線形な速度を望むならば 1 前後に設定するのがよいです。過度に大きくすると
- *                全体的な動きが抑制されすぎてしまう可能性があります。
- *
- * 2. cpi（カウント・パー・インチ）
- *    - 説明: cpi は、トラックボールが動いた際に 1 インチあたりの検出される「移動単位」
- *            を表します。cpi が高い場合、カーソルは敏感に反応し、小さな動きでも速く動きます。
- *            cpi が低いと、カーソルの動きはゆっくりになります。
- *    - 設定方法: 高い cpi を設定すると、トラックボールの小さな動きでもカーソルが敏感に
- *                動きます。低い cpi を設定すると、トラックボールの動きがゆっくりと反映されます。
- *    - 推奨設定: 非線形な動きを実現するため、cpi は 200～800 程度に設定します。この範囲で
- *                トラックボールの精細な動きを反映しつつ、カーソルの過度な移動を防ぎます。
- *
- * 3. speed_adjust_value
- *    - 説明: speed_adjust_value は、トラックボールの動きに対する加速度合いを設定します。
- *            pow() 関数を使用して非線形な加速を実現するための重要なパラメータです。
- *    - 設定方法: 値が 1.0 より小さいと全体的に「緩やかな移動」となり、1.0 より大きいと
- *                「加速度的に速く」なります。
- *    - 推奨設定: speed_adjust_value を 1.5～2.0 の範囲で調整し、ゆっくりとした動きと
- *                加速的な動きのバランスを取ることが推奨されます。例えば 1.5 に設定すると
- *                非線形のスムーズな動きを得られます。
- *
- * ■推奨設定
- * - XSCALE_FACTOR および YSCALE_FACTOR: 1.0〜1.2（動きのスムーズさと制御性のバランス）
- * - cpi: 400（小さな動きにも反応しやすく、適度な移動速度を実現）
- * - speed_adjust_value: 1.5～2.0（小さな動きには細かく、大きな動きには加速度的に速くなる）
- *
- * ■戻り値
- * - なし
- *
- * ■注意点
- * トラックボールの速度調整は、パラメータの微調整に依存します。使用感に基づき、各値を試行錯誤しながら
- * 最適な設定を見つけてください。
- * ****************************************************************************/
-static void motion_to_mouse(report_mouse_t *mouse_report, float delta_x, float delta_y, uint16_t speed_adjust, uint16_t cpi) {
-    float x = delta_x;
-    float y = delta_y;
-
-    // 符号を取得
-    int sign_x = (x > 0) - (x < 0);
-    int sign_y = (y > 0) - (y < 0);
-
-
-    // スピード調整のロジックk
-    float speed_adjust_value =  (float)speed_adjust / 10.0;
-    x = pow(fabs(x), speed_adjust_value) / (pow(cpi / 20, speed_adjust_value)) * cpi / 20 * sign_x;
-    y = pow(fabs(y), speed_adjust_value) / (pow(cpi / 20, speed_adjust_value)) * cpi / 20 * sign_y;
-
-    // スケールファクター（必要なら定義）
-    x = x / XSCALE_FACTOR;
-    y = y / YSCALE_FACTOR;
-
-    // 最終値をマウスレポートに反映
-    mouse_report->x = constrain_hid(mouse_report->x + (int8_t)roundf(x));
-    mouse_report->y = constrain_hid(mouse_report->y + (int8_t)roundf(y));
-}
-
 /****************************************************************************
  * eeconfig_init_kb
  *
@@ -303,28 +268,28 @@ static void motion_to_mouse(report_mouse_t *mouse_report, float delta_x, float d
 void eeconfig_init_kb(void) {
     if (eeconfig_read_kb() == 0) {
         // mtk_config構造体の初期化: キーボード設定のデフォルト値を設定
-        mtk_config.cpi_value = MTK_CPI_DEFAULT;                            // CPI（感度）の初期値
+        for (uint8_t side = 0; side < 2; side++) {
+            mtk_config.side[side] = (mtk_side_config_t)MTK_SIDE_CONFIG_DEFAULT; // 左右のCPI・速度調整・スクロールスナップの初期値
+        }
         mtk_config.cpi_changed = false;                                    // CPI変更フラグ
         mtk_config.scroll_mode = false;                                    // スクロールモード無効
         mtk_config.scroll_direction = false;                               // スクロール方向（正方向）
         mtk_config.scroll_div = MTK_SCROLL_DIV_DEFAULT;                    // スクロール分割値のデフォルト
         mtk_config.auto_mouse_mode = true;                                 // 自動マウスモード有効
         mtk_config.auto_mouse_time_out = AUTO_MOUSE_TIME;                  // 自動マウスのタイムアウト値
-        mtk_config.scroll_snap_mode = MTK_SCROLLSNAP_MODE_VERTICAL;        // スクロールスナップモードのディフォルト
-        mtk_config.speed_adjust_value = MTK_SPEED_ADJUST_DEFAULT;          // トラックボールの速度調整倍率
         mtk_config.oled_orient = MTK_OLED_ORIENT;                          // OLED表示方向
 
         // ee_config_t構造体の作成と初期化: デフォルト値をEEPROM形式で準備
         ee_config_t c = {
-            .cpi  = mtk_config.cpi_value / PMW33XX_CPI_STEP,               // CPIをEEPROM形式に変換
+            .cpi  = mtk_get_cpi(MTK_SIDE_RIGHT) / PMW33XX_CPI_STEP,        // CPIをEEPROM形式に変換（右側）
             .sdir = mtk_config.scroll_direction,                           // スクロール方向
             .sdiv = mtk_config.scroll_div,                                 // スクロール分割値
             #ifdef POINTING_DEVICE_AUTO_MOUSE_ENABLE
               .auto_mouse = mtk_config.auto_mouse_mode,                    // 自動マウスモード
               .auto_mouse_time_out = mtk_config.auto_mouse_time_out / 100, // タイムアウト
             #endif
-            .scroll_snap_mode = mtk_get_scrollsnap_mode(),                 // スクロールスナップモード
-            .speed_adjust_value = mtk_get_speed_adjust_value(),            // トラックボール速度調整値
+            .scroll_snap_mode = mtk_get_scrollsnap_mode(MTK_SIDE_RIGHT),   // スクロールスナップモード（右側）
+            .speed_adjust_value = mtk_get_speed_adjust_value(MTK_SIDE_RIGHT), // トラックボール速度調整値（右側）
             .oled_orient = mtk_get_oled_orient_value()                     //  OLED表示方向
         };
         eeconfig_update_kb_64(c.raw);                                      // EEPROMにデフォルト値を書き込む
@@ -344,7 +309,7 @@ void load_mtk_config(void) {
     //ee_config.raw = eeconfig_read_kb();                       // EEPROMから生データを読み込み
     ee_config.raw = eeconfig_read_kb_64();                      // 64ビットのデータを読み込み
 
-    mtk_set_cpi(ee_config.cpi * PMW33XX_CPI_STEP);              // CPI設定値を復元
+    mtk_set_cpi(MTK_SIDE_RIGHT, ee_config.cpi * PMW33XX_CPI_STEP); // CPI設定値を復元（右側）
     mtk_set_scroll_direction(ee_config.sdir);                   // スクロール方向を復元
     mtk_set_scroll_div(ee_config.sdiv);                         // スクロール分割値を復元（スクロールスピード関連）
 
@@ -353,12 +318,31 @@ void load_mtk_config(void) {
       mtk_set_auto_mouse_time_out(ee_config.auto_mouse_time_out * 100);
     #endif
 
-    mtk_set_scrollsnap_mode(ee_config.scroll_snap_mode);        // スクロールスナップモード復元
-    mtk_set_speed_adjust_value(ee_config.speed_adjust_value);   // トラックボール速度調整値を復元
+    mtk_set_scrollsnap_mode(MTK_SIDE_RIGHT, ee_config.scroll_snap_mode);      // スクロールスナップモード復元（右側）
+    mtk_set_speed_adjust_value(MTK_SIDE_RIGHT, ee_config.speed_adjust_value); // トラックボール速度調整値を復元（右側）
     mtk_set_oled_orient_value(ee_config.oled_orient);           // OLED表示方向を復元
 
+    uint8_t block[EECONFIG_KB_DATA_SIZE];                       // データブロックは EECONFIG_KB_DATA_SIZE バイトをまとめて読み書きする
+    eeconfig_read_kb_datablock(block);                          // 拡張分の設定を読み込み
+    memcpy(&ee_config_ext, block, sizeof(ee_config_ext));
+    mtk_set_rest_time(1, ee_config_ext.rest1_time);             // センサーのレストモード移行時間を復元
+    mtk_set_rest_time(2, ee_config_ext.rest2_time);
+    mtk_set_rest_time(3, ee_config_ext.rest3_time);
+    mtk_apply_rest_times();
+
+    // 左側の設定を復元（0 の項目は右側と同じ）
+    mtk_set_cpi(MTK_SIDE_LEFT, ee_config_ext.cpi_l ? ee_config_ext.cpi_l * PMW33XX_CPI_STEP : mtk_get_cpi(MTK_SIDE_RIGHT));
+    mtk_set_speed_adjust_value(MTK_SIDE_LEFT, ee_config_ext.speed_adjust_value_l ? ee_config_ext.speed_adjust_value_l : mtk_get_speed_adjust_value(MTK_SIDE_RIGHT));
+    mtk_set_scrollsnap_mode(MTK_SIDE_LEFT, ee_config_ext.scroll_snap_mode_l ? ee_config_ext.scroll_snap_mode_l - 1 : mtk_get_scrollsnap_mode(MTK_SIDE_RIGHT));
+    mtk_set_scroll_always(MTK_SIDE_LEFT, ee_config_ext.side_flags & MTK_EE_SIDE_SCROLL_ALWAYS_L);
+    mtk_set_scroll_always(MTK_SIDE_RIGHT, ee_config_ext.side_flags & MTK_EE_SIDE_SCROLL_ALWAYS_R);
+    mtk_set_speed_adjust_enabled(MTK_SIDE_LEFT, !(ee_config_ext.side_flags & MTK_EE_SIDE_ADJUST_OFF_L));
+    mtk_set_speed_adjust_enabled(MTK_SIDE_RIGHT, !(ee_config_ext.side_flags & MTK_EE_SIDE_ADJUST_OFF_R));
+    mtk_set_scroll_hires(!(ee_config_ext.flags & MTK_EE_FLAG_HIRES_OFF));  // 高分解能スクロールの有効/無効を復元
+
     // OLED初期化
     oled_clear();
+    oled_redraw = true;
     oled_init(mtk_get_oled_orient_value() == 0 ? OLED_ROTATION_0 : OLED_ROTATION_270);
 }
 
@@ -370,7 +354,7 @@ void load_mtk_config(void) {
  * 各設定をee_config構造体に適切に格納し、書き込みを行う。
  * ****************************************************************************/
 void save_mtk_config(void) {
-    ee_config.cpi = mtk_config.cpi_value / PMW33XX_CPI_STEP;        // トラックボール速度調整値を復元
+    ee_config.cpi = mtk_get_cpi(MTK_SIDE_RIGHT) / PMW33XX_CPI_STEP; // CPIを保存（右側）
     ee_config.sdir = mtk_config.scroll_direction;                   // スクロール方向と分割値を保存
     ee_config.sdiv = mtk_config.scroll_div;
 
@@ -379,12 +363,27 @@ void save_mtk_config(void) {
       ee_config.auto_mouse_time_out = mtk_config.auto_mouse_time_out / 100;
     #endif
 
-    ee_config.scroll_snap_mode = mtk_get_scrollsnap_mode();         // スクロールスナップモード
-    ee_config.speed_adjust_value = mtk_get_speed_adjust_value();    // トラックボール速度調整値を保存
+    ee_config.scroll_snap_mode = mtk_get_scrollsnap_mode(MTK_SIDE_RIGHT);      // スクロールスナップモード（右側）
+    ee_config.speed_adjust_value = mtk_get_speed_adjust_value(MTK_SIDE_RIGHT); // トラックボール速度調整値を保存（右側）
     ee_config.oled_orient = mtk_get_oled_orient_value();            // OLED表示方向を保存
 
     //eeconfig_update_kb(ee_config.raw);                              // EEPROMにデータを書き込む
     eeconfig_update_kb_64(ee_config.raw);                           // 64ビットのデータを保存
+
+    ee_config_ext.rest1_time = mtk_config.rest_time[0];             // センサーのレストモード移行時間を保存
+    ee_config_ext.rest2_time = mtk_config.rest_time[1];
+    ee_config_ext.rest3_time = mtk_config.rest_time[2];
+    ee_config_ext.cpi_l = mtk_get_cpi(MTK_SIDE_LEFT) / PMW33XX_CPI_STEP;       // 左側の設定を保存
+    ee_config_ext.speed_adjust_value_l = mtk_get_speed_adjust_value(MTK_SIDE_LEFT);
+    ee_config_ext.scroll_snap_mode_l = mtk_get_scrollsnap_mode(MTK_SIDE_LEFT) + 1;
+    ee_config_ext.side_flags = (mtk_get_scroll_always(MTK_SIDE_LEFT) ? MTK_EE_SIDE_SCROLL_ALWAYS_L : 0)
+                             | (mtk_get_scroll_always(MTK_SIDE_RIGHT) ? MTK_EE_SIDE_SCROLL_ALWAYS_R : 0)
+                             | (mtk_get_speed_adjust_enabled(MTK_SIDE_LEFT) ? 0 : MTK_EE_SIDE_ADJUST_OFF_L)
+                             | (mtk_get_speed_adjust_enabled(MTK_SIDE_RIGHT) ? 0 : MTK_EE_SIDE_ADJUST_OFF_R);
+    ee_config_ext.flags = mtk_get_scroll_hires() ? 0 : MTK_EE_FLAG_HIRES_OFF;  // 高分解能スクロールの有効/無効を保存
+    uint8_t block[EECONFIG_KB_DATA_SIZE] = {0};                     // データブロックは EECONFIG_KB_DATA_SIZE バイトをまとめて読み書きする
+    memcpy(block, &ee_config_ext, sizeof(ee_config_ext));
+    eeconfig_update_kb_datablock(block);                            // 拡張分の設定を保存
 }
 
 
@@ -397,21 +396,49 @@ void save_mtk_config(void) {
 void matrix_init_kb(void) {
     load_mtk_config();
 
-    if (mtk_config.cpi_value > PMW33XX_CPI_MAX) {
+    if (mtk_config.side[MTK_SIDE_RIGHT].cpi_value > PMW33XX_CPI_MAX) {
         eeconfig_init_kb();
     }
 }
 
 
+/****************************************************************************
+ * matrix_scan_kb
+ *
+ * キーマトリクスのスキャンごとに呼ばれる。スキャン回数とループ時間を記録する。
+ * ****************************************************************************/
+void matrix_scan_kb(void) {
+    mtk_matrix_count_scan();
+    mtk_latency_scan();
+    matrix_scan_user();
+}
+
+
+/****************************************************************************
+ * keyboard_post_init_kb
+ *
+ * キーボードの初期化後の処理を実行する。
+ * 左右間の通信のトランザクションを登録する。
+ * ****************************************************************************/
+void keyboard_post_init_kb(void) {
+#ifdef SPLIT_KEYBOARD
+    mtk_split_init();
+#endif
+    keyboard_post_init_user();
+}
+
+
 /****************************************************************************
  * pointing_device_init_kb
  *
  * ポインティングデバイス（トラックボールなど）の初期化を実行する。
  * センサー設定や自動マウスモードの適用を行う。
+ * センサー本体の初期化と core 1 の起動は pointing_device_driver_init（mtk_sensor.c）で行う。
  * ****************************************************************************/
 void pointing_device_init_kb(void) {
-    pmw33xx_init(0);                                // index 1 is the second device.
-    pmw33xx_set_cpi(0, mtk_config.cpi_value);       // applies to first sensor
+    mtk_set_cpi(MTK_SIDE_LEFT, mtk_get_cpi(MTK_SIDE_LEFT));   // センサーは mtk_sensor.c のドライバで初期化済み
+    mtk_set_cpi(MTK_SIDE_RIGHT, mtk_get_cpi(MTK_SIDE_RIGHT));
+    mtk_apply_rest_times();
 #ifdef POINTING_DEVICE_AUTO_MOUSE_ENABLE
     set_auto_mouse_enable(mtk_config.auto_mouse_mode);
     set_auto_mouse_timeout(mtk_config.auto_mouse_time_out);
@@ -419,104 +446,45 @@ void pointing_device_init_kb(void) {
 }
 
 
+static mtk_pointer_t mtk_pointer[2];         // ポインタ処理の状態（左右別）
+
+
 /****************************************************************************
- * pointing_device_task_kb
+ * side_pointer_config
  *
- * ポインティングデバイスの動作タスクを実行する。
- * マウスレポートに基づいてスクロールや移動処理を適用し、
- * 状況に応じて速度調整やモーション蓄積を管理する。
+ * 左右それぞれの設定と共通の設定（スクロール方向・分割値・慣性など）から、
+ * 片側のポインタ処理の設定を作る。常にスクロールする側はスクロールモードとして扱う。
  * ****************************************************************************/
-static int16_t scroll_h;
-static int16_t scroll_v;
-
-report_mouse_t pointing_device_task_kb(report_mouse_t mouse_report) {
-    // スクロールモードの有効状態をキャッシュ
-    bool is_scroll_mode = mtk_get_scroll_mode();
-    int16_t scroll_div = mtk_get_scroll_div() * 8;      // スクロール分解能
-    uint8_t snap_mode = mtk_config.scroll_snap_mode;
-    bool scroll_direction = mtk_get_scroll_direction();
-
-    //X軸とY軸を反転させます（X軸→Y軸、Y軸→X軸）
-    int16_t x_rev =  mouse_report.y * -1;
-    int16_t y_rev =  mouse_report.x * -1;
-
-    // スクロールモードが有効な場合
-    if (is_scroll_mode) {
-        // X軸とY軸を反転してスクロール量に加算
-        scroll_h += x_rev;
-        scroll_v += y_rev;
-
-        // スケーリングされたスクロール量を計算
-        int8_t scaled_scroll_h = scroll_h / scroll_div;
-        int8_t scaled_scroll_v = scroll_v / scroll_div;
-
-        // 水平方向のスクロール処理
-        if (scaled_scroll_h != 0) {
-            switch (snap_mode) {
-                case MTK_SCROLLSNAP_MODE_VERTICAL:
-                    mouse_report.h = 0;
-                    break;
-                case MTK_SCROLLSNAP_MODE_HORIZONTAL:
-                case MTK_SCROLLSNAP_MODE_FREE:
-                    mouse_report.h = scaled_scroll_h;
-                    break;
-                default:
-                    break;
-            }
-            scroll_h = 0; // 水平方向のスクロール量をリセット
-        }
-
-        // 垂直方向のスクロール処理
-        if (scaled_scroll_v != 0) {
-            int8_t adjusted_v = (scroll_direction) ? scaled_scroll_v : -scaled_scroll_v;
-            switch (snap_mode) {
-                case MTK_SCROLLSNAP_MODE_VERTICAL:
-                    mouse_report.v = adjusted_v;
-                    break;
-                case MTK_SCROLLSNAP_MODE_HORIZONTAL:
-                    mouse_report.v = 0;
-                    break;
-                case MTK_SCROLLSNAP_MODE_FREE:
-                    mouse_report.v = adjusted_v;
-                    break;
-                default:
-                    break;
-            }
-            scroll_v = 0; // 垂直方向のスクロール量をリセット
-        }
-
-        // 通常の移動量を無効化
-        mouse_report.x = 0;
-        mouse_report.y = 0;
-    } else {
-        // スクロールモードが無効な場合
-        if (mtk_get_speed_adjust_enabled()) {
-            uint16_t cpi = mtk_get_cpi();
-            motion_to_mouse(&mouse_report, mouse_report.x, mouse_report.y, mtk_get_speed_adjust_value(), cpi);
-
-            // motion_to_mouse後のmouse_reportの向きを修正
-            int16_t temp_x = mouse_report.x;
-            mouse_report.x = mouse_report.y;
-            mouse_report.y = temp_x;
+static mtk_pointer_config_t side_pointer_config(uint8_t side) {
+    return (mtk_pointer_config_t){
+        .cpi                  = mtk_get_cpi(side),
+        .speed_adjust_enabled = mtk_get_speed_adjust_enabled(side),
+        .speed_adjust_value   = mtk_get_speed_adjust_value(side),
+        .scroll_mode          = mtk_get_scroll_mode() || mtk_get_scroll_always(side),
+        .scroll_direction     = mtk_get_scroll_direction(),
+        .scroll_div           = mtk_get_scroll_div(),
+        .scroll_snap_mode     = mtk_get_scrollsnap_mode(side),
+        .scroll_resolution    = mtk_get_scroll_resolution(),
+        .inertia_enabled      = mtk_get_inertia_enabled(),
+        .inertia_friction     = mtk_get_inertia_friction(),
+    };
+}
 
-            // 向きを反転させる場合
-            mouse_report.x *= -1;
-            mouse_report.y *= -1;
 
-        } else {
-            // 速度調整が無効な場合のみCPI反転値を適用
-            mouse_report.x = x_rev;
-            mouse_report.y = y_rev;
-        }
-        mouse_report.h = 0;
-        mouse_report.v = 0;
-    }
-
-    // 一定時間動作がない場合、累積されたモーションをリセット
+/****************************************************************************
+ * motion_update
+ *
+ * 変換後のマウスレポート（左右の合計）でモーションの累積とタイマーを更新する。
+ * 一定時間動作がない場合は、累積されたモーションと端数の繰り越しをリセットする。
+ * ****************************************************************************/
+static void motion_update(report_mouse_t mouse_report) {
+    // 一定時間動作がない場合、累積されたモーションと端数の繰り越しをリセット
     uint16_t elapsed_time = timer_elapsed(mtk_config.motion.active_time);
     if (elapsed_time > 300) {
         mtk_config.motion.x = 0;
         mtk_config.motion.y = 0;
+        mtk_pointer_carry_reset(&mtk_pointer[MTK_SIDE_LEFT]);
+        mtk_pointer_carry_reset(&mtk_pointer[MTK_SIDE_RIGHT]);
         mtk_config.motion.active_time = timer_read(); // タイマーをリセット
     }
 
@@ -524,15 +492,75 @@ report_mouse_t pointing_device_task_kb(report_mouse_t mouse_report) {
     // マウスが動作している場合、アクティブなタイマーを更新
     if (mouse_report.x || mouse_report.y || mouse_report.h || mouse_report.v) {
         mtk_config.motion.active_time = timer_read();
+        mtk_config.motion.last_motion = timer_read32();
     }
 
     // モーションを累積し、後続の処理で利用可能にする
     mtk_config.motion.x += mouse_report.x;
     mtk_config.motion.y += mouse_report.y;
+}
 
-    // 最終的なマウスレポートを返す
-    return pointing_device_task_user(mouse_report);
+
+#if defined(SPLIT_POINTING_ENABLE) && defined(POINTING_DEVICE_COMBINED)
+/****************************************************************************
+ * pointing_device_task_combined_kb
+ *
+ * 左右のトラックボールをそれぞれの設定（CPI・速度調整・スクロール・スナップ）で
+ * マウスレポートに変換してから合成する。
+ * 例えば左を常にスクロール、右をポインタとして同時に使える。
+ * ****************************************************************************/
+report_mouse_t pointing_device_task_combined_kb(report_mouse_t left_report, report_mouse_t right_report) {
+    // スレーブ側の移動量は専用のトランザクションで受け取り、スレーブ側のレポートに足す
+    mtk_split_motion_sync();
+    report_mouse_t *remote_report = is_keyboard_left() ? &right_report : &left_report;
+    remote_report->x += remote_motion.x;
+    remote_report->y += remote_motion.y;
+    remote_motion.x = 0;
+    remote_motion.y = 0;
+
+    // トレース記録用にセンサーの生の移動量を保持
+    int16_t raw_x = left_report.x + right_report.x;
+    int16_t raw_y = left_report.y + right_report.y;
+
+    // 左右それぞれの設定でセンサーの移動量をマウスレポートに変換
+    const mtk_pointer_config_t left_config  = side_pointer_config(MTK_SIDE_LEFT);
+    const mtk_pointer_config_t right_config = side_pointer_config(MTK_SIDE_RIGHT);
+    left_report  = mtk_pointer_task(&mtk_pointer[MTK_SIDE_LEFT], &left_config, left_report);
+    right_report = mtk_pointer_task(&mtk_pointer[MTK_SIDE_RIGHT], &right_config, right_report);
+
+    motion_update(pointing_device_combine_reports(left_report, right_report));
+
+    // 合成した最終的なマウスレポートを返す（記録中はトレースに残す）
+    report_mouse_t mouse_report = pointing_device_task_combined_user(left_report, right_report);
+    bool           scroll       = left_config.scroll_mode || right_config.scroll_mode;
+    mtk_trace_record(raw_x, raw_y, &mouse_report, scroll ? MTK_TRACE_FLAG_SCROLL : 0);
+    return mouse_report;
+}
+#else
+/****************************************************************************
+ * pointing_device_task_kb
+ *
+ * ポインティングデバイスの動作タスクを実行する（トラックボールが片側だけの場合）。
+ * マウスレポートに基づいてスクロールや移動処理を適用し、
+ * 状況に応じて速度調整やモーション蓄積を管理する。
+ * ****************************************************************************/
+report_mouse_t pointing_device_task_kb(report_mouse_t mouse_report) {
+    // トレース記録用にセンサーの生の移動量を保持
+    int16_t raw_x = mouse_report.x;
+    int16_t raw_y = mouse_report.y;
+
+    // 現在の設定でセンサーの移動量をマウスレポートに変換
+    const mtk_pointer_config_t config = side_pointer_config(MTK_SIDE_LOCAL);
+    mouse_report = mtk_pointer_task(&mtk_pointer[MTK_SIDE_LOCAL], &config, mouse_report);
+
+    motion_update(mouse_report);
+
+    // 最終的なマウスレポートを返す（記録中はトレースに残す）
+    mouse_report = pointing_device_task_user(mouse_report);
+    mtk_trace_record(raw_x, raw_y, &mouse_report, config.scroll_mode ? MTK_TRACE_FLAG_SCROLL : 0);
+    return mouse_report;
 }
+#endif
 
 /****************************************************************************
  * layer_state_set_kb
@@ -618,6 +646,7 @@ bool oled_task_user(void) {
         if (anim_step >= total_frames) {
             anim_running = false;
             oled_clear();
+            oled_redraw = true;
             return false;
         }
 
@@ -638,16 +667,43 @@ bool oled_task_user(void) {
 }
 
 
+/****************************************************************************
+ * rest_governor_task
+ *
+ * センサーのレストモードを管理する。マウスレイヤ（AUTO_MOUSE_DEFAULT_LAYER）が有効な間と、
+ * 最後の移動から REST1 の時間が経つまでは最大フレームレートに固定する。
+ * それ以降はレストモードを有効にし、REST1 → REST2 → REST3 への移行はセンサーに任せる。
+ * 移動があるとセンサーはすぐに RUN に戻り、ここでも次の周期でレストモードを無効にする。
+ * スレーブ側は移動を知らないため、レイヤ（SPLIT_LAYER_STATE_ENABLE で同期）だけで判断する。
+ * センサーの初期化前で書き込めなかった場合は設定済みとせず、次の周期で書き直す。
+ * ****************************************************************************/
+static void rest_governor_task(void) {
+    static int8_t rest = -1;  // センサーに設定済みの状態（-1: 未設定）
+
+    bool active = layer_state_is(AUTO_MOUSE_DEFAULT_LAYER)
+               || timer_elapsed32(mtk_config.motion.last_motion) < mtk_get_rest_time(1);
+    if (rest != !active && mtk_sensor_set_rest(!active)) {
+        rest = !active;
+    }
+}
+
+
  /****************************************************************************
  * housekeeping_task_kb
  *
  * 主にOLEDアニメーションのタイミング管理を行う定期タスク。
+ * センサーのレストモードの管理、左右間の設定と表示状態の同期、OLED の転送の開始も行う。
  * スプリットキーボードのレイヤ状態が有効な場合にのみ動作。
  * ****************************************************************************/
 #ifdef SPLIT_LAYER_STATE_ENABLE
 static int oled_anim_elapsed = 0;
 void housekeeping_task_kb(void) {
     housekeeping_task_user();
+    rest_governor_task();
+#ifdef SPLIT_KEYBOARD
+    mtk_split_task();
+#endif
+    mtk_oled_task();
 
     // OLEDアニメーションタイマーの更新
     if (get_highest_layer(layer_state) != 0) {
@@ -689,6 +745,8 @@ bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
     }
 
     if (record->event.pressed) {
+        mtk_pointer_inertia_stop(&mtk_pointer[MTK_SIDE_LEFT]);  // キー入力で慣性スクロールを止める
+        mtk_pointer_inertia_stop(&mtk_pointer[MTK_SIDE_RIGHT]);
 #ifdef OLED_ENABLE
         set_keylog(keycode, record);
 #endif
@@ -742,28 +800,22 @@ bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
                 break;
 #endif
             case SSNP_VRT:
-                mtk_set_scrollsnap_mode(MTK_SCROLLSNAP_MODE_VERTICAL);
+                mtk_set_scrollsnap_mode(mtk_get_edit_side(), MTK_SCROLLSNAP_MODE_VERTICAL);
                 break;
             case SSNP_HOR:
-                mtk_set_scrollsnap_mode(MTK_SCROLLSNAP_MODE_HORIZONTAL);
+                mtk_set_scrollsnap_mode(mtk_get_edit_side(), MTK_SCROLLSNAP_MODE_HORIZONTAL);
                 break;
             case SSNP_FRE:
-                mtk_set_scrollsnap_mode(MTK_SCROLLSNAP_MODE_FREE);
+                mtk_set_scrollsnap_mode(mtk_get_edit_side(), MTK_SCROLLSNAP_MODE_FREE);
                 break;
             case ADJMS_TG:
-                mtk_set_speed_adjust_enabled(!mtk_config.speed_adjust_enabled);
+                mtk_set_speed_adjust_enabled(mtk_get_edit_side(), !mtk_get_speed_adjust_enabled(mtk_get_edit_side()));
                 break;
-            case ADJMS_SPD_INC:  // 調整値を増やすキー
-                mtk_config.speed_adjust_value += MTK_SPEED_ADJUST_STEP;  // 増加量（例：1）
-                if (mtk_config.speed_adjust_value > MTK_SPEED_ADJUST_MAX) {
-                    mtk_config.speed_adjust_value = MTK_SPEED_ADJUST_MAX;  // 上限値
-                }
+            case ADJMS_SPD_INC:  // 調整値を増やすキー（上限は mtk_set_speed_adjust_value で制限）
+                mtk_set_speed_adjust_value(mtk_get_edit_side(), mtk_get_speed_adjust_value(mtk_get_edit_side()) + MTK_SPEED_ADJUST_STEP);
                 break;
-            case ADJMS_SPD_DEC:  // 調整値を減らすキー
-                mtk_config.speed_adjust_value -= MTK_SPEED_ADJUST_STEP;  // 減少量（例：1）
-                if (mtk_config.speed_adjust_value <= MTK_SPEED_ADJUST_MIN) {
-                    mtk_config.speed_adjust_value = MTK_SPEED_ADJUST_MIN;  // 下限値
-                }
+            case ADJMS_SPD_DEC:  // 調整値を減らすキー（下限は mtk_set_speed_adjust_value で制限）
+                mtk_set_speed_adjust_value(mtk_get_edit_side(), mtk_get_speed_adjust_value(mtk_get_edit_side()) - MTK_SPEED_ADJUST_STEP);
                 break;
             case OLED_ORI_TG:
                 start_oled_animation(); // トグルボタンでアニメーションを開始
@@ -773,8 +825,33 @@ bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
 
                 // 新しい方向に応じた初期化を実行
                 oled_clear();
+                oled_redraw = true;
                 oled_init(mtk_get_oled_orient_value() == 0 ? OLED_ROTATION_0 : OLED_ROTATION_270);
                 break;
+            case SCRL_HRS:
+                mtk_set_scroll_hires(!mtk_get_scroll_hires());
+                break;
+            case INRT_TG:
+                mtk_set_inertia_enabled(!mtk_get_inertia_enabled());
+                break;
+            case TRC_TG:
+                if (mtk_trace_is_armed()) {
+                    mtk_trace_disarm();
+                } else {
+                    mtk_trace_arm();
+                }
+                break;
+            case SIDE_TG:
+                mtk_set_edit_side(mtk_get_edit_side() == MTK_SIDE_LEFT ? MTK_SIDE_RIGHT : MTK_SIDE_LEFT);
+                break;
+            case SCRL_LCK:
+                mtk_set_scroll_always(mtk_get_edit_side(), !mtk_get_scroll_always(mtk_get_edit_side()));
+                break;
+            case OLED_PG:
+                oled_page = (oled_page + 1) % MTK_OLED_PAGE_COUNT;
+                oled_clear();
+                oled_redraw = true;
+                break;
             default:
                 return true;
         }
@@ -784,8 +861,76 @@ bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
 }
 
 
+/****************************************************************************
+ * post_process_record_kb
+ *
+ * キー入力の処理（レポートの送信）が終わった後に呼ばれる。
+ * スキャンからレポートまでの時間を記録する。
+ * ****************************************************************************/
+void post_process_record_kb(uint16_t keycode, keyrecord_t *record) {
+    mtk_latency_record(record);
+    post_process_record_user(keycode, record);
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 // configration function
+#ifdef VIA_ENABLE
+/****************************************************************************
+ * config_hid_command
+ *
+ * raw HID で拡張設定（EEPROM のデータブロックに保存する設定）を読み書きする。
+ *   data[1] = 0x00: 取得 → data[2..4]: REST1/2/3 に入るまでの時間（ee_config_ext_t の単位）
+ *   data[1] = 0x01: 設定 data[2..4] を反映して EEPROM に保存
+ * ****************************************************************************/
+static bool config_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 5 || data[0] != MTK_CONFIG_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case 0x00:
+            memcpy(&data[2], mtk_config.rest_time, sizeof(mtk_config.rest_time));
+            break;
+        case 0x01:
+            for (uint8_t i = 0; i < sizeof(mtk_config.rest_time); i++) {
+                mtk_set_rest_time(i + 1, data[2 + i]);
+            }
+            mtk_apply_rest_times();
+            save_mtk_config();
+            break;
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
+
+
+/****************************************************************************
+ * via_command_kb
+ *
+ * raw HID のキーボード独自コマンドを処理する。
+ * トレース（MTK_TRACE_HID_ID）・センサー統計（MTK_SENSOR_HID_ID）・
+ * 拡張設定（MTK_CONFIG_HID_ID）・通信統計（MTK_SPLIT_HID_ID）・
+ * ループ時間とキー入力の遅延（MTK_LATENCY_HID_ID）・OLED の転送と描画内容（MTK_OLED_HID_ID）のコマンドを
+ * 処理した場合は応答を返して true を返す。
+ * ****************************************************************************/
+bool via_command_kb(uint8_t *data, uint8_t length) {
+    if (mtk_trace_hid_command(data, length) || mtk_sensor_hid_command(data, length) || config_hid_command(data, length)
+        || mtk_latency_hid_command(data, length) || mtk_oled_hid_command(data, length)
+#ifdef SPLIT_KEYBOARD
+        || mtk_split_hid_command(data, length)
+#endif
+    ) {
+        raw_hid_send(data, length);
+        return true;
+    }
+    return false;
+}
+#endif
+
+
 /****************************************************************************
  * mtk_get_scroll_mode
  *
@@ -802,7 +947,10 @@ bool mtk_get_scroll_mode(void) {
  * スクロールモードを設定する。
  * ****************************************************************************/
 void mtk_set_scroll_mode(bool mode) {
-    mtk_config.scroll_mode = mode;
+    if (mtk_config.scroll_mode != mode) {
+        mtk_config.scroll_mode = mode;
+        split_state_changed();
+    }
 }
 
 
@@ -845,37 +993,100 @@ uint8_t mtk_get_scroll_div(void) {
  * 最大値に丸めて設定する。
  * ****************************************************************************/
 void mtk_set_scroll_div(uint8_t div) {
-    mtk_config.scroll_div = div > MTK_SCROLL_DIV_MAX ? MTK_SCROLL_DIV_MAX : div;
+    div = div > MTK_SCROLL_DIV_MAX ? MTK_SCROLL_DIV_MAX : div;
+    if (mtk_config.scroll_div != div) {
+        mtk_config.scroll_div = div;
+        split_state_changed();
+    }
 }
 
 
 /****************************************************************************
  * mtk_get_cpi
  *
- * 現在のCPI（カウントパーインチ）を取得する。
+ * 左右どちらか（side）の現在のCPI（カウントパーインチ）を取得する。
  * 設定が無効な場合はデフォルト値（MTK_CPI_DEFAULT）を返す。
  * ****************************************************************************/
-uint16_t mtk_get_cpi(void) {
-    return mtk_config.cpi_value == 0 ? MTK_CPI_DEFAULT : mtk_config.cpi_value;
+uint16_t mtk_get_cpi(uint8_t side) {
+    uint16_t cpi = mtk_config.side[side].cpi_value;
+    return cpi == 0 ? MTK_CPI_DEFAULT : cpi;
 }
 
 
 /****************************************************************************
  * mtk_set_cpi
  *
- * CPI（カウントパーインチ）の値を設定する。
+ * 左右どちらか（side）のCPI（カウントパーインチ）の値を設定する。
  * 値が範囲外の場合、最小値または最大値に丸めて設定する。
- * 設定後、CPI変更フラグを立て、ポインティングデバイスに適用する。
+ * 設定後、CPI変更フラグを立て、その側のセンサーに適用する。
  * ****************************************************************************/
-void mtk_set_cpi(uint16_t cpi) {
+void mtk_set_cpi(uint8_t side, uint16_t cpi) {
     if (cpi > PMW33XX_CPI_MAX) {
        cpi = PMW33XX_CPI_MAX;
     } else if (cpi < PMW33XX_CPI_MIN * 2) {
        cpi = PMW33XX_CPI_MIN * 2;
     }
-    mtk_config.cpi_value   = cpi;
+    if (mtk_config.side[side].cpi_value != cpi) {
+        mtk_config.side[side].cpi_value = cpi;
+        split_state_changed();
+    }
     mtk_config.cpi_changed = true;
-    pointing_device_set_cpi(cpi == 0 ? MTK_CPI_DEFAULT - 1 : cpi - 1);
+#if defined(SPLIT_POINTING_ENABLE) && defined(POINTING_DEVICE_COMBINED)
+    pointing_device_set_cpi_on_side(side == MTK_SIDE_LEFT, cpi == 0 ? MTK_CPI_DEFAULT - 1 : cpi - 1);
+#else
+    if (side == MTK_SIDE_LOCAL) {
+        pointing_device_set_cpi(cpi == 0 ? MTK_CPI_DEFAULT - 1 : cpi - 1);
+    }
+#endif
+}
+
+
+/****************************************************************************
+ * mtk_get_edit_side
+ *
+ * キーで設定を変更する側（MTK_SIDE_LEFT/RIGHT）を取得する。
+ * ****************************************************************************/
+uint8_t mtk_get_edit_side(void) {
+    return mtk_config.edit_side;
+}
+
+
+/****************************************************************************
+ * mtk_set_edit_side
+ *
+ * キーで設定を変更する側を設定する。
+ * ****************************************************************************/
+void mtk_set_edit_side(uint8_t side) {
+    side = side == MTK_SIDE_LEFT ? MTK_SIDE_LEFT : MTK_SIDE_RIGHT;
+    if (mtk_config.edit_side != side) {
+        mtk_config.edit_side = side;
+        split_state_changed();
+    }
+}
+
+
+/****************************************************************************
+ * mtk_get_scroll_always
+ *
+ * 左右どちらか（side）が常にスクロールする設定かどうかを取得する。
+ * ****************************************************************************/
+bool mtk_get_scroll_always(uint8_t side) {
+    return mtk_config.side[side].scroll_always;
+}
+
+
+/****************************************************************************
+ * mtk_set_scroll_always
+ *
+ * 左右どちらか（side）を、スクロールモードに関係なく常にスクロールにするか設定する。
+ * 切り替えた側のスクロール状態はリセットする。
+ * ****************************************************************************/
+void mtk_set_scroll_always(uint8_t side, bool enabled) {
+    if (mtk_config.side[side].scroll_always != enabled) {
+        mtk_config.side[side].scroll_always = enabled;
+        split_state_changed();
+    }
+    mtk_pointer_scroll_reset(&mtk_pointer[side]);
 }
 
 
@@ -896,7 +1107,10 @@ bool mtk_get_auto_mouse_mode(void) {
  * 自動マウスモードの状態を設定する。
  * ****************************************************************************/
 void mtk_set_auto_mouse_mode(bool mode) {
-    mtk_config.auto_mouse_mode = mode;
+    if (mtk_config.auto_mouse_mode != mode) {
+        mtk_config.auto_mouse_mode = mode;
+        split_state_changed();
+    }
 }
 
 
@@ -917,7 +1131,10 @@ uint16_t mtk_get_auto_mouse_time_out(void) {
  * 設定後、ポインティングデバイスに適用する。
  * ****************************************************************************/
 void mtk_set_auto_mouse_time_out(uint16_t timeout) {
-    mtk_config.auto_mouse_time_out = timeout;
+    if (mtk_config.auto_mouse_time_out != timeout) {
+        mtk_config.auto_mouse_time_out = timeout;
+        split_state_changed();
+    }
     set_auto_mouse_timeout(mtk_config.auto_mouse_time_out);
 }
 #endif
@@ -925,68 +1142,213 @@ void mtk_set_auto_mouse_time_out(uint16_t timeout) {
 /****************************************************************************
  * mtk_set_scrollsnap_mode
  *
- * スクロールスナップモードを設定する。
+ * 左右どちらか（side）のスクロールスナップモードを設定する。
  * 不正なモードが指定された場合はデフォルトのモード
  * （MTK_SCROLLSNAP_MODE_VERTICAL）を設定する。
  * ****************************************************************************/
-void mtk_set_scrollsnap_mode(uint8_t mode) {
+void mtk_set_scrollsnap_mode(uint8_t side, uint8_t mode) {
     if (mode > MTK_SCROLLSNAP_MODE_FREE) {
         mode = MTK_SCROLLSNAP_MODE_VERTICAL;
     }
-    mtk_config.scroll_snap_mode = mode;
+    if (mtk_config.side[side].scroll_snap_mode != mode) {
+        mtk_config.side[side].scroll_snap_mode = mode;
+        split_state_changed();
+    }
 }
 
 
 /****************************************************************************
  * mtk_get_scrollsnap_mode
  *
- * スクロールスナップモードの現在の状態を取得する。
+ * 左右どちらか（side）のスクロールスナップモードの現在の状態を取得する。
  * ****************************************************************************/
-uint8_t mtk_get_scrollsnap_mode(void) {
-    return mtk_config.scroll_snap_mode;
+uint8_t mtk_get_scrollsnap_mode(uint8_t side) {
+    return mtk_config.side[side].scroll_snap_mode;
 }
 
 
 /****************************************************************************
  * mtk_get_speed_adjust_enabled
  *
- * 速度調整モードが有効かどうかを取得する。
+ * 左右どちらか（side）の速度調整モードが有効かどうかを取得する。
  * ****************************************************************************/
-bool mtk_get_speed_adjust_enabled(void) {
-    return mtk_config.speed_adjust_enabled;
+bool mtk_get_speed_adjust_enabled(uint8_t side) {
+    return mtk_config.side[side].speed_adjust_enabled;
 }
 
 
 /****************************************************************************
  * mtk_set_speed_adjust_enabled
  *
- * 速度調整モードを有効または無効に設定する。
+ * 左右どちらか（side）の速度調整モードを有効または無効に設定する。
  * ****************************************************************************/
-void mtk_set_speed_adjust_enabled(bool enabled) {
-    mtk_config.speed_adjust_enabled = enabled;
+void mtk_set_speed_adjust_enabled(uint8_t side, bool enabled) {
+    if (mtk_config.side[side].speed_adjust_enabled != enabled) {
+        mtk_config.side[side].speed_adjust_enabled = enabled;
+        split_state_changed();
+    }
 }
 
 
 /****************************************************************************
  * mtk_set_speed_adjust_value
  *
- * 速度調整値を設定する。設定値が最小値未満または最大値を超える場合、
+ * 左右どちらか（side）の速度調整値を設定する。設定値が最小値未満または最大値を超える場合、
  * それぞれの境界値に丸める。
  * ****************************************************************************/
-void mtk_set_speed_adjust_value(uint8_t value) {
+void mtk_set_speed_adjust_value(uint8_t side, uint8_t value) {
     if (value < MTK_SPEED_ADJUST_MIN) value = MTK_SPEED_ADJUST_MIN; // 最小値
     if (value > MTK_SPEED_ADJUST_MAX) value = MTK_SPEED_ADJUST_MAX; // 最大値
-    mtk_config.speed_adjust_value = value;
+    if (mtk_config.side[side].speed_adjust_value != value) {
+        mtk_config.side[side].speed_adjust_value = value;
+        split_state_changed();
+    }
 }
 
 
 /****************************************************************************
  * mtk_get_speed_adjust_value
  *
- * 現在の速度調整値を取得する。
+ * 左右どちらか（side）の現在の速度調整値を取得する。
  * ****************************************************************************/
-uint8_t mtk_get_speed_adjust_value(void) {
-    return mtk_config.speed_adjust_value;
+uint8_t mtk_get_speed_adjust_value(uint8_t side) {
+    return mtk_config.side[side].speed_adjust_value;
+}
+
+
+/****************************************************************************
+ * mtk_get_scroll_hires
+ *
+ * 高分解能スクロールが有効かどうかを取得する。
+ * ****************************************************************************/
+bool mtk_get_scroll_hires(void) {
+    return mtk_config.scroll_hires;
+}
+
+
+/****************************************************************************
+ * mtk_set_scroll_hires
+ *
+ * 高分解能スクロールを有効または無効に設定する。
+ * 分解能の乗数に対応していないホストでは無効にして使う。
+ * ****************************************************************************/
+void mtk_set_scroll_hires(bool enabled) {
+    mtk_config.scroll_hires = enabled;
+    mtk_pointer_scroll_reset(&mtk_pointer[MTK_SIDE_LEFT]);
+    mtk_pointer_scroll_reset(&mtk_pointer[MTK_SIDE_RIGHT]);
+}
+
+
+/****************************************************************************
+ * mtk_get_scroll_resolution
+ *
+ * 1ノッチあたりのホイール送信単位数を取得する。
+ * POINTING_DEVICE_HIRES_SCROLL_ENABLE で高分解能スクロールが有効な場合は
+ * ホストに通知した分解能の乗数、それ以外は 1 を返す。
+ * ****************************************************************************/
+uint16_t mtk_get_scroll_resolution(void) {
+#ifdef POINTING_DEVICE_HIRES_SCROLL_ENABLE
+    if (mtk_get_scroll_hires()) {
+        return pointing_device_get_hires_scroll_resolution();
+    }
+#endif
+    return 1;
+}
+
+
+/****************************************************************************
+ * mtk_get_inertia_enabled
+ *
+ * 慣性スクロールが有効かどうかを取得する。
+ * ****************************************************************************/
+bool mtk_get_inertia_enabled(void) {
+    return mtk_config.inertia_enabled;
+}
+
+
+/****************************************************************************
+ * mtk_set_inertia_enabled
+ *
+ * 慣性スクロールを有効または無効に設定する。
+ * 無効にした場合は慣性スクロール中の動きも止める。
+ * ****************************************************************************/
+void mtk_set_inertia_enabled(bool enabled) {
+    mtk_config.inertia_enabled = enabled;
+    if (!enabled) {
+        mtk_pointer_inertia_stop(&mtk_pointer[MTK_SIDE_LEFT]);
+        mtk_pointer_inertia_stop(&mtk_pointer[MTK_SIDE_RIGHT]);
+    }
+}
+
+
+/****************************************************************************
+ * mtk_get_inertia_friction
+ *
+ * 慣性スクロールの減衰率を取得する。
+ * 設定が無効な場合はデフォルト値（MTK_INERTIA_FRICTION）を返す。
+ * ****************************************************************************/
+uint8_t mtk_get_inertia_friction(void) {
+    return mtk_config.inertia_friction == 0 ? MTK_INERTIA_FRICTION : mtk_config.inertia_friction;
+}
+
+
+/****************************************************************************
+ * mtk_set_inertia_friction
+ *
+ * 慣性スクロールの減衰率を設定する（1tickごとに速度を friction / 256 倍）。
+ * ****************************************************************************/
+void mtk_set_inertia_friction(uint8_t friction) {
+    mtk_config.inertia_friction = friction;
+}
+
+
+/****************************************************************************
+ * mtk_get_rest_time
+ *
+ * 最後の移動からセンサーが REST1/2/3（level）に入るまでの時間をミリ秒で取得する。
+ * 設定が0の場合はデフォルト値（MTK_REST1_TIME など）を使う。
+ * ****************************************************************************/
+uint32_t mtk_get_rest_time(uint8_t level) {
+    switch (level) {
+        case 1:
+            return (mtk_config.rest_time[0] == 0 ? MTK_REST1_TIME : mtk_config.rest_time[0]) * 100;
+        case 2: {
+            uint32_t t = (mtk_config.rest_time[1] == 0 ? MTK_REST2_TIME : mtk_config.rest_time[1]) * 1000;
+            uint32_t t1 = mtk_get_rest_time(1);
+            return t < t1 ? t1 : t;
+        }
+        default: {
+            uint32_t t = (mtk_config.rest_time[2] == 0 ? MTK_REST3_TIME : mtk_config.rest_time[2]) * 1000;
+            uint32_t t2 = mtk_get_rest_time(2);
+            return t < t2 ? t2 : t;
+        }
+    }
+}
+
+
+/****************************************************************************
+ * mtk_set_rest_time
+ *
+ * センサーが REST1/2/3（level）に入るまでの時間を設定する。
+ * 単位は REST1 が100ms、REST2/3 が秒（0: デフォルト値）。
+ * センサーへは3つとも設定してから mtk_apply_rest_times で反映する。
+ * ****************************************************************************/
+void mtk_set_rest_time(uint8_t level, uint8_t value) {
+    if (level < 1 || level > 3) {
+        return;
+    }
+    mtk_config.rest_time[level - 1] = value;
+}
+
+
+/****************************************************************************
+ * mtk_apply_rest_times
+ *
+ * レストモードの移行時間をセンサーに反映する。
+ * レジスタの値が変わらない場合は書き込まない（mtk_sensor_set_rest_times）。
+ * ****************************************************************************/
+void mtk_apply_rest_times(void) {
+    mtk_sensor_set_rest_times(mtk_get_rest_time(2) - mtk_get_rest_time(1), mtk_get_rest_time(3) - mtk_get_rest_time(2));
 }
 
 
@@ -1359,6 +1721,27 @@ void render_image2(uint8_t col, uint8_t row, const char *bitmap, uint16_t bitmap
 }
 
 
+/****************************************************************************
+ * render_line
+ *
+ * 指定された位置に文字列を描画し、行の残りを空白で埋める。
+ * oled_write_ln は行末までちょうど書いた場合に次の行を丸ごと空白で埋めるので、
+ * その場合は埋めずに終える（部分更新で描き直さない次の行を消さないため）。
+ * @param col    カーソルの列位置
+ * @param row    カーソルの行位置
+ * @param text   描画する文字列
+ * @param invert 色反転を適用するか
+ * ****************************************************************************/
+static void render_line(uint8_t col, uint32_t row, const char *text, bool invert) {
+    oled_set_cursor(col, row);
+    if (col + strlen(text) < oled_max_chars()) {
+        oled_write_ln_P(text, invert);
+    } else {
+        oled_write_P(text, invert);
+    }
+}
+
+
 /****************************************************************************
  * render_fixed_string
  *
@@ -1368,8 +1751,7 @@ void render_image2(uint8_t col, uint8_t row, const char *bitmap, uint16_t bitmap
  * @param text 描画する文字列
  * ****************************************************************************/
 void render_fixed_string(uint8_t col, uint32_t row, const char *text) {
-    oled_set_cursor(col, row);
-    oled_write_ln_P(text, false);
+    render_line(col, row, text, false);
 }
 
 
@@ -1384,11 +1766,10 @@ void render_fixed_string(uint8_t col, uint32_t row, const char *text) {
  * ****************************************************************************/
 void render_indicator(uint8_t col, uint32_t row, uint8_t layer) {
     bool active = (layer < 8 && row <= layer);
-    oled_set_cursor(col, row);
     if (active) {
         render_image(col, row, bitmap_under, sizeof(bitmap_under));
     } else {
-        oled_write_ln_P("|", active);
+        render_line(col, row, "|", active);
     }
 }
 
@@ -1402,9 +1783,11 @@ void render_indicator(uint8_t col, uint32_t row, uint8_t layer) {
  * @param layer 現在のレイヤ
  * ****************************************************************************/
 void render_indicator2(uint8_t col, uint32_t row, uint8_t layer) {
-    // OLED描画バッファを明示的に初期化
-    oled_set_cursor(OLED_WIDTH, row);  // カーソルを移動
-    oled_write_char(' ', false);    // 描画領域を空白で初期化
+    // OLED描画バッファを明示的に初期化（縦表示では右端が1文字に満たないので、次の行にはみ出さないよう書かない）
+    if (col + OLED_WIDTH < oled_max_chars()) {
+        oled_set_cursor(col + OLED_WIDTH, row);  // カーソルを移動
+        oled_write_char(' ', false);             // 描画領域を空白で初期化
+    }
 
     // カウントに基づく表示上限を計算
     uint8_t active_indicators = type_count / 3000;
@@ -1569,17 +1952,30 @@ void render_indicator_slave2(uint8_t col, uint32_t row, uint8_t layer) {
  * @param col    カーソルの列位置
  * @param row    カーソルの行位置
  * @param key    描画するキー名
- * @param format 値のフォーマット文字列
+ * @param format 値のフォーマット（"%d"・"%3d"・"%-3d" の形だけに対応、空文字列は値を描画しない）
  * @param value  描画する値
  * @param invert 色反転を適用するか
  * ****************************************************************************/
 void render_key_value(uint8_t col, uint32_t row, const char *key, const char *format, int value, bool invert) {
-    oled_set_cursor(col, row);
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%s%s", key, format);
-    char final_buffer[16];
-    snprintf(final_buffer, sizeof(final_buffer), buffer, value);
-    oled_write_ln_P(final_buffer, invert);
+    char    buffer[16];
+    uint8_t n = mtk_fmt_str(buffer, sizeof(buffer), key);
+
+    if (format[0] == '%') {
+        const char *spec  = format + 1;
+        bool        left  = *spec == '-';
+        uint8_t     width = 0;
+        if (left) {
+            spec++;
+        }
+        while (*spec >= '0' && *spec <= '9') {
+            width = width * 10 + (*spec++ - '0');
+        }
+        n += mtk_fmt_dec(buffer + n, sizeof(buffer) - n, value, width, left);
+        if (*spec) {
+            mtk_fmt_str(buffer + n, sizeof(buffer) - n, spec + 1);  // 'd' の後ろの文字列
+        }
+    }
+    render_line(col, row, buffer, invert);
 }
 
 
@@ -1594,8 +1990,7 @@ void render_key_value(uint8_t col, uint32_t row, const char *key, const char *fo
 void render_snap_mode(uint8_t col, uint32_t row, uint8_t snap_mode) {
     static const char *snap_modes[] = {"VER", "HOR", "FRE", "UNK"};
     uint8_t index = (snap_mode > 2) ? 3 : snap_mode;
-    oled_set_cursor(col, row);
-    oled_write_ln_P(snap_modes[index], false);
+    render_line(col, row, snap_modes[index], false);
 }
 
 
@@ -1611,17 +2006,21 @@ void render_snap_mode(uint8_t col, uint32_t row, uint8_t snap_mode) {
  * @param invert          色反転を適用するか
  * ****************************************************************************/
 void render_decimal_value(uint8_t col, uint32_t row, const char *key, int integer_part, int fractional_part, bool invert) {
-    char buffer[16]; // 十分なサイズを確保
-    snprintf(buffer, sizeof(buffer), "%s%d.%d", key, integer_part, fractional_part); // 整数部と小数部を結合
-    oled_set_cursor(col, row);
-    oled_write_ln_P(buffer, invert);
+    char    buffer[16]; // 十分なサイズを確保
+    uint8_t n = mtk_fmt_str(buffer, sizeof(buffer), key);                                // 整数部と小数部を結合
+    n += mtk_fmt_dec(buffer + n, sizeof(buffer) - n, integer_part, 0, false);
+    n += mtk_fmt_str(buffer + n, sizeof(buffer) - n, ".");
+    mtk_fmt_dec(buffer + n, sizeof(buffer) - n, fractional_part, 0, false);
+    render_line(col, row, buffer, invert);
 }
 
 
 /****************************************************************************
  * set_keylog
  *
- * キーコードとそのイベント情報を記録し、キーの位置やコード、名前を格納する。
+ * 押したキー（キーコード・行・列・時刻）をキーログの履歴に積む。
+ * キー入力の処理中に呼ばれるので記録だけを行い、表示用の文字列は
+ * OLED の描画時（keylog_format）に作る。
  * @param keycode   イベント対象のキーコード
  * @param record    キーイベントの記録データ
  * ****************************************************************************/
@@ -1630,6 +2029,20 @@ static char keylog_str_h[MAX_KEYLOG_STR_LEN] = {'\0'};
 static char keylog_str_n[MAX_KEYLOG_STR_LEN] = {'\0'};
 static char keylog_str_R[MAX_KEYLOG_STR_LEN] = {'\0'};
 static char keylog_str_C[MAX_KEYLOG_STR_LEN] = {'\0'};
+
+// キーログの履歴（keylog_count - 1 が最新）
+typedef struct {
+    uint16_t keycode;  // キーコード
+    uint8_t  row;      // 行
+    uint8_t  col;      // 列
+    uint16_t time;     // 押した時刻（ミリ秒）
+} mtk_keylog_t;
+
+_Static_assert((MTK_KEYLOG_SIZE & (MTK_KEYLOG_SIZE - 1)) == 0, "MTK_KEYLOG_SIZE must be a power of two");
+
+static mtk_keylog_t keylog_ring[MTK_KEYLOG_SIZE];
+static uint32_t     keylog_count = 0;  // 記録したキーの数
+
 const char code_to_name[60] = {
     ' ', ' ', ' ', ' ', 'a', 'b', 'c', 'd', 'e', 'f',
     'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
@@ -1639,24 +2052,67 @@ const char code_to_name[60] = {
     '#', ';', '\'', '`', ',', '.', '/', ' ', ' ', ' '};
 
 void set_keylog(uint16_t keycode, keyrecord_t *record) {
-    char name = ' ';
+    keylog_ring[keylog_count & (MTK_KEYLOG_SIZE - 1)] = (mtk_keylog_t){
+        .keycode = keycode,
+        .row     = record->event.key.row,
+        .col     = record->event.key.col,
+        .time    = record->event.time,
+    };
+    keylog_count++;
+    split_state_changed();
+}
+
+
+/****************************************************************************
+ * keylog_get
+ *
+ * キーログの履歴を新しい順に取得する（index = 0 が最新）。
+ * @return 履歴がない場合は NULL
+ * ****************************************************************************/
+static const mtk_keylog_t *keylog_get(uint8_t index) {
+    if (index >= keylog_count || index >= MTK_KEYLOG_SIZE) {
+        return NULL;
+    }
+    return &keylog_ring[(keylog_count - 1 - index) & (MTK_KEYLOG_SIZE - 1)];
+}
+
+
+/****************************************************************************
+ * keylog_code / keylog_name
+ *
+ * 表示するキーコード（モッドタップ・レイヤタップは基本のキーコード）と、その1文字の名前を返す。
+ * ****************************************************************************/
+static uint16_t keylog_code(uint16_t keycode) {
     if ((keycode >= QK_MOD_TAP && keycode <= QK_MOD_TAP_MAX) ||
         (keycode >= QK_LAYER_TAP && keycode <= QK_LAYER_TAP_MAX)) {
             keycode = keycode & 0xFF;
     }
+    return keycode;
+}
 
-    if (keycode < 60) {
-        name = code_to_name[keycode];
+static char keylog_name(uint16_t keycode) {
+    return keycode < 60 ? code_to_name[keycode] : ' ';
+}
+
+
+/****************************************************************************
+ * keylog_format
+ *
+ * 最新のキーログから表示用の文字列（行・列・16進のキーコード・名前）を作る。
+ * OLED の描画時に、キーログが変わった場合だけ呼ぶ。
+ * ****************************************************************************/
+static void keylog_format(void) {
+    const mtk_keylog_t *entry = keylog_get(0);
+    if (entry == NULL) {
+        return;
     }
+    const uint16_t keycode = keylog_code(entry->keycode);
 
-  // update keylog
-  //snprintf(keylog_str, sizeof(keylog_str), "c:%-3dr:%-3dk:%04x %-c",
-  //         record->event.key.row, record->event.key.col,
-  //         keycode, name);
-  snprintf(keylog_str_R, sizeof(keylog_str_R), "%-3d"  ,record->event.key.row);
-  snprintf(keylog_str_C, sizeof(keylog_str_C), "%-3d"  ,record->event.key.col);
-  snprintf(keylog_str_h, sizeof(keylog_str_h), "%04x"  ,keycode);
-  snprintf(keylog_str_n, sizeof(keylog_str_n), "%-c"   ,name);
+    mtk_fmt_dec(keylog_str_R, sizeof(keylog_str_R), entry->row, 3, true);
+    mtk_fmt_dec(keylog_str_C, sizeof(keylog_str_C), entry->col, 3, true);
+    mtk_fmt_hex(keylog_str_h, sizeof(keylog_str_h), keycode, 4);
+    keylog_str_n[0] = keylog_name(keycode);
+    keylog_str_n[1] = '\0';
 }
 
 
@@ -1668,7 +2124,71 @@ void set_keylog(uint16_t keycode, keyrecord_t *record) {
  * ****************************************************************************/
 void count_type(void) {
     type_count++;
+    split_state_changed();
+}
+
+
+#ifdef SPLIT_KEYBOARD
+/****************************************************************************
+ * mtk_get_split_state
+ *
+ * スレーブに送る設定と表示状態のスナップショットを作る（マスター側）。
+ * format と version は mtk_split.c で設定する。
+ * ****************************************************************************/
+void mtk_get_split_state(mtk_split_state_t *state) {
+    for (uint8_t side = 0; side < 2; side++) {
+        state->cpi[side]                = mtk_get_cpi(side);
+        state->speed_adjust_value[side] = mtk_get_speed_adjust_value(side);
+        state->scroll_snap_mode[side]   = mtk_get_scrollsnap_mode(side);
+    }
+    state->scroll_div          = mtk_config.scroll_div;
+    state->auto_mouse_time_out = mtk_config.auto_mouse_time_out;
+    state->flags               = (mtk_config.scroll_mode ? MTK_SPLIT_STATE_SCROLL : 0)
+                               | (mtk_config.auto_mouse_mode ? MTK_SPLIT_STATE_AUTO_MOUSE : 0)
+                               | (mtk_get_edit_side() == MTK_SIDE_LEFT ? MTK_SPLIT_STATE_EDIT_LEFT : 0)
+                               | (mtk_get_speed_adjust_enabled(MTK_SIDE_LEFT) ? MTK_SPLIT_STATE_ADJUST_L : 0)
+                               | (mtk_get_speed_adjust_enabled(MTK_SIDE_RIGHT) ? MTK_SPLIT_STATE_ADJUST_R : 0)
+                               | (mtk_get_scroll_always(MTK_SIDE_LEFT) ? MTK_SPLIT_STATE_SCROLL_ALWAYS_L : 0)
+                               | (mtk_get_scroll_always(MTK_SIDE_RIGHT) ? MTK_SPLIT_STATE_SCROLL_ALWAYS_R : 0);
+    state->type_count          = type_count;
+
+    const mtk_keylog_t *keylog = keylog_get(0);
+    state->keylog_keycode      = keylog ? keylog->keycode : 0;
+    state->keylog_row          = keylog ? keylog->row : 0;
+    state->keylog_col          = keylog ? keylog->col : 0;
+}
+
+
+/****************************************************************************
+ * mtk_set_split_state
+ *
+ * マスターから受け取ったスナップショットを反映する（スレーブ側）。
+ * スレーブでは表示にだけ使うので、センサーなどへの適用はせず値だけを書き換える。
+ * ****************************************************************************/
+void mtk_set_split_state(const mtk_split_state_t *state) {
+    for (uint8_t side = 0; side < 2; side++) {
+        mtk_config.side[side].cpi_value            = state->cpi[side];
+        mtk_config.side[side].speed_adjust_value   = state->speed_adjust_value[side];
+        mtk_config.side[side].scroll_snap_mode     = state->scroll_snap_mode[side];
+    }
+    mtk_config.side[MTK_SIDE_LEFT].speed_adjust_enabled  = state->flags & MTK_SPLIT_STATE_ADJUST_L;
+    mtk_config.side[MTK_SIDE_RIGHT].speed_adjust_enabled = state->flags & MTK_SPLIT_STATE_ADJUST_R;
+    mtk_config.side[MTK_SIDE_LEFT].scroll_always         = state->flags & MTK_SPLIT_STATE_SCROLL_ALWAYS_L;
+    mtk_config.side[MTK_SIDE_RIGHT].scroll_always        = state->flags & MTK_SPLIT_STATE_SCROLL_ALWAYS_R;
+    mtk_config.scroll_mode         = state->flags & MTK_SPLIT_STATE_SCROLL;
+    mtk_config.auto_mouse_mode     = state->flags & MTK_SPLIT_STATE_AUTO_MOUSE;
+    mtk_config.edit_side           = state->flags & MTK_SPLIT_STATE_EDIT_LEFT ? MTK_SIDE_LEFT : MTK_SIDE_RIGHT;
+    mtk_config.scroll_div          = state->scroll_div;
+    mtk_config.auto_mouse_time_out = state->auto_mouse_time_out;
+    type_count                     = state->type_count;
+
+    // キーログはマスターの最新のキーだけを持つ（文字列は描画時にマスターと同じ処理で作る）
+    if (state->keylog_keycode != 0 || keylog_count != 0) {
+        keylog_ring[0] = (mtk_keylog_t){.keycode = state->keylog_keycode, .row = state->keylog_row, .col = state->keylog_col};
+        keylog_count   = 1;
+    }
 }
+#endif
 
 
 /****************************************************************************
@@ -1681,9 +2201,8 @@ void count_type(void) {
  * ****************************************************************************/
 void oled_write_type_count(uint8_t col, uint32_t row) {
     char type_count_str[7]; // 6桁 + 終端文字
-    snprintf(type_count_str, sizeof(type_count_str), "%5lu", type_count); // 右寄せ形式
-    oled_set_cursor(col, row);
-    oled_write_ln(type_count_str, false); // 打鍵数を右寄せで描画
+    mtk_fmt_udec(type_count_str, sizeof(type_count_str), type_count, 5, false); // 右寄せ形式
+    render_line(col, row, type_count_str, false); // 打鍵数を右寄せで描画
 }
 
 
@@ -1722,9 +2241,172 @@ void oled_write_uptime(uint8_t col, uint32_t row) {
     uptime_minutes = (timer_read32() / 1000) / 60;
 
     // 最大3桁で右詰め表示
-    snprintf(uptime_str, sizeof(uptime_str), "%3lu", uptime_minutes);
-    oled_set_cursor(col, row);
-    oled_write_ln(uptime_str, false);            // 経過時間
+    mtk_fmt_udec(uptime_str, sizeof(uptime_str), uptime_minutes, 3, false);
+    render_line(col, row, uptime_str, false);    // 経過時間
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// OLED表示 差分描画
+//
+// 行ごとに依存する状態（MTK_OLED_DEP_*）を決めておき、描画のたびに表示に使う値を集めて前回と比べ、
+// 値が変わった状態に依存する行だけを描き直す。画面を消したときは oled_redraw で全行を描き直す。
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum {
+    MTK_OLED_DEP_LAYER      = 1 << 0,  // レイヤ
+    MTK_OLED_DEP_CONFIG     = 1 << 1,  // CPI・自動マウス・速度調整・変更中の側
+    MTK_OLED_DEP_SCROLL     = 1 << 2,  // スクロールモード・分割値・スナップモード
+    MTK_OLED_DEP_KEYLOG     = 1 << 3,  // 最後に押したキー
+    MTK_OLED_DEP_COUNT      = 1 << 4,  // 打鍵数
+    MTK_OLED_DEP_TYPE_LEVEL = 1 << 5,  // 打鍵数のインジケータ（3000打鍵ごと）
+    MTK_OLED_DEP_RGB        = 1 << 6,  // RGBのモードと色
+    MTK_OLED_DEP_MOTION     = 1 << 7,  // トラックボールの移動量
+    MTK_OLED_DEP_UPTIME     = 1 << 8,  // 稼働時間（分）
+    MTK_OLED_DEP_ALL        = 0x1FF
+};
+
+// 表示に使う値（変更中の側の値は解決済みのものを持つ）
+typedef struct {
+    uint8_t  layer;
+    uint16_t cpi[2];
+    uint16_t auto_mouse_time_out;
+    uint8_t  config_flags;    // 自動マウス・速度調整・変更中の側
+    uint8_t  speed_adjust_value;
+    bool     scroll_mode;
+    uint8_t  scroll_div;
+    uint8_t  scroll_snap_mode;
+    uint32_t keylog_count;
+    uint16_t keylog_keycode;
+    uint8_t  keylog_row;
+    uint8_t  keylog_col;
+    uint32_t type_count;
+    uint8_t  rgb[4];          // モード・色相・彩度・明度
+    uint16_t motion;
+    uint32_t uptime;
+} oled_state_t;
+
+typedef struct {
+    uint8_t  row;                   // 描画する行
+    void     (*render)(uint32_t);   // 行の描画関数
+    uint16_t deps;                  // 依存する状態（MTK_OLED_DEP_*）
+} oled_row_t;
+
+static oled_state_t oled_state = {0};   // 前回の描画で使った値
+static uint16_t     oled_changed = 0;   // 今回の描画で値が変わった状態
+
+// 描画量の統計（1秒ごとに区切る）
+static uint32_t oled_stats_start = 0;   // 集計区間の開始時刻（ミリ秒）
+static uint32_t oled_rows_count  = 0;   // 集計中の区間で描画した行数
+static uint32_t oled_bytes_count = 0;   // 集計中の区間で描画したバイト数
+static uint16_t oled_rows_rate   = 0;   // 直前の1秒間の行数
+static uint32_t oled_bytes_rate  = 0;   // 直前の1秒間のバイト数
+
+
+/****************************************************************************
+ * oled_update_state
+ *
+ * 表示に使う値を集めて前回と比べ、値が変わった状態を oled_changed に設定する。
+ * レイヤはここで1回だけ求め、各行の描画関数は oled_state.layer を使う。
+ * キーログが変わった場合は表示用の文字列を作り直す。
+ * ****************************************************************************/
+static void oled_update_state(void) {
+    const uint8_t       side   = mtk_get_edit_side();
+    const mtk_keylog_t *keylog = keylog_get(0);
+    oled_state_t        now    = {
+        .layer               = get_highest_layer(layer_state),
+        .cpi                 = {mtk_get_cpi(MTK_SIDE_LEFT), mtk_get_cpi(MTK_SIDE_RIGHT)},
+        .auto_mouse_time_out = mtk_get_auto_mouse_time_out(),
+        .config_flags        = (mtk_get_auto_mouse_mode() ? 0x01 : 0) | (mtk_get_speed_adjust_enabled(side) ? 0x02 : 0) | (side == MTK_SIDE_LEFT ? 0x04 : 0),
+        .speed_adjust_value  = mtk_get_speed_adjust_value(side),
+        .scroll_mode         = mtk_get_scroll_mode(),
+        .scroll_div          = mtk_config.scroll_div,
+        .scroll_snap_mode    = mtk_get_scrollsnap_mode(side),
+        .keylog_count        = keylog_count,
+        .keylog_keycode      = keylog ? keylog->keycode : 0,
+        .keylog_row          = keylog ? keylog->row : 0,
+        .keylog_col          = keylog ? keylog->col : 0,
+        .type_count          = type_count,
+        .rgb                 = {rgblight_get_mode(), rgblight_get_hue(), rgblight_get_sat(), rgblight_get_val()},
+        .motion              = abs(mtk_config.motion.x) + abs(mtk_config.motion.y),
+        .uptime              = (timer_read32() / 1000) / 60,
+    };
+
+    uint16_t changed = 0;
+    if (now.layer != oled_state.layer) changed |= MTK_OLED_DEP_LAYER;
+    if (now.cpi[0] != oled_state.cpi[0] || now.cpi[1] != oled_state.cpi[1] || now.auto_mouse_time_out != oled_state.auto_mouse_time_out
+        || now.config_flags != oled_state.config_flags || now.speed_adjust_value != oled_state.speed_adjust_value) changed |= MTK_OLED_DEP_CONFIG;
+    if (now.scroll_mode != oled_state.scroll_mode || now.scroll_div != oled_state.scroll_div
+        || now.scroll_snap_mode != oled_state.scroll_snap_mode) changed |= MTK_OLED_DEP_SCROLL;
+    if (now.keylog_count != oled_state.keylog_count || now.keylog_keycode != oled_state.keylog_keycode
+        || now.keylog_row != oled_state.keylog_row || now.keylog_col != oled_state.keylog_col) changed |= MTK_OLED_DEP_KEYLOG;
+    if (now.type_count != oled_state.type_count) changed |= MTK_OLED_DEP_COUNT;
+    if (now.type_count / 3000 != oled_state.type_count / 3000) changed |= MTK_OLED_DEP_TYPE_LEVEL;
+    if (memcmp(now.rgb, oled_state.rgb, sizeof(now.rgb)) != 0) changed |= MTK_OLED_DEP_RGB;
+    if (now.motion != oled_state.motion) changed |= MTK_OLED_DEP_MOTION;
+    if (now.uptime != oled_state.uptime) changed |= MTK_OLED_DEP_UPTIME;
+
+    if (oled_redraw) {
+        changed     = MTK_OLED_DEP_ALL;
+        oled_redraw = false;
+    }
+    oled_state   = now;
+    oled_changed = changed;
+
+    if (changed & MTK_OLED_DEP_KEYLOG) {
+        keylog_format();
+    }
+}
+
+
+/****************************************************************************
+ * oled_count_rows
+ *
+ * 描画した行数と、その行が占める描画バッファのバイト数を数える。
+ * 1秒ごとに毎秒の値を記録する。
+ * ****************************************************************************/
+static void oled_count_rows(uint8_t rows) {
+    oled_rows_count += rows;
+    oled_bytes_count += (uint32_t)rows * oled_max_chars() * OLED_FONT_WIDTH;
+
+    if (timer_elapsed32(oled_stats_start) >= 1000) {
+        oled_rows_rate   = oled_rows_count > UINT16_MAX ? UINT16_MAX : oled_rows_count;
+        oled_bytes_rate  = oled_bytes_count;
+        oled_rows_count  = 0;
+        oled_bytes_count = 0;
+        oled_stats_start = timer_read32();
+    }
+}
+
+
+/****************************************************************************
+ * oled_render_rows
+ *
+ * 指定された行範囲のうち、依存する状態が変わった行だけを描画する。
+ * @param rows      行の定義
+ * @param num_rows  行の定義の数
+ * @param start_row 更新を開始する行番号
+ * @param end_row   更新を終了する行番号
+ * ****************************************************************************/
+static void oled_render_rows(const oled_row_t rows[], uint8_t num_rows, uint8_t start_row, uint8_t end_row) {
+    uint8_t rendered = 0;
+    for (uint8_t i = 0; i < num_rows; i++) {
+        if (rows[i].row >= start_row && rows[i].row <= end_row && (rows[i].deps & oled_changed)) {
+            rows[i].render(rows[i].row);
+            rendered++;
+        }
+    }
+    oled_count_rows(rendered);
+}
+
+
+/****************************************************************************
+ * mtk_get_oled_render_rate
+ *
+ * 直前の1秒間に描画した行数とバイト数を取得する。
+ * ****************************************************************************/
+void mtk_get_oled_render_rate(uint16_t *rows, uint32_t *bytes) {
+    *rows  = oled_rows_rate;
+    *bytes = oled_bytes_rate;
 }
 
 
@@ -1734,7 +2416,7 @@ void oled_write_uptime(uint8_t col, uint32_t row) {
 // 行単位の画面表示メソッド。横表示のため、7行分作成。
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 void oled_render_hor0(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_fixed_string(0, row, "Layer");
     render_indicator(5, row, layer);
     render_fixed_string(7, row, keylog_str_h);
@@ -1746,7 +2428,7 @@ void oled_render_hor0(uint32_t row) {
 }
 
 void oled_render_hor1(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
 
     // 現在のレイヤに対応する画像を取得
     if (layer < sizeof(bitmap_layers) / sizeof(bitmap_layers[0])) {
@@ -1758,30 +2440,31 @@ void oled_render_hor1(uint32_t row) {
     }
 
     render_indicator(5, row, layer);
-    render_key_value(7, row, "CPI:", "%-4d", mtk_config.cpi_value, false);
+    render_key_value(7, row, mtk_get_edit_side() == MTK_SIDE_LEFT ? "CPL:" : "CPR:", "%-4d", mtk_get_cpi(mtk_get_edit_side()), false);
     render_indicator(15, row, layer);
     render_key_value(17, row, "", "%-3d", mtk_get_auto_mouse_time_out(), false);
 }
 
 void oled_render_hor2(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     //render_key_value(2, row, "", "%-d", layer, false);
     render_indicator(5, row, layer);
     render_key_value(7, row, "THR:", "%-3d", AUTO_MOUSE_THRESHOLD, false);
     render_indicator(15, row, layer);
-    render_key_value(16, row, " ADJ ", "", 0, mtk_get_speed_adjust_enabled());
+    render_key_value(16, row, " ADJ ", "", 0, mtk_get_speed_adjust_enabled(mtk_get_edit_side()));
 }
 
 void oled_render_hor3(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator(5, row, layer);
     render_key_value(7, row, "MTN:", "%-3d", abs(mtk_config.motion.x) + abs(mtk_config.motion.y), false);
     render_indicator(15, row, layer);
-    render_decimal_value(17, row, "", mtk_config.speed_adjust_value / 10, mtk_config.speed_adjust_value % 10, false);
+    uint8_t speed = mtk_get_speed_adjust_value(mtk_get_edit_side());
+    render_decimal_value(17, row, "", speed / 10, speed % 10, false);
 }
 
 void oled_render_hor4(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     const uint8_t num_layers = sizeof(layer_names) / sizeof(layer_names[0]);     // 配列の長さを取得
     const char *layer_name = (layer < num_layers) ? layer_names[layer] : "UNK";  // 配列範囲内であれば描画、それ以外は "UNK" を表示
     render_fixed_string(0, row, layer_name);
@@ -1793,7 +2476,7 @@ void oled_render_hor4(uint32_t row) {
 }
 
 void oled_render_hor5(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator(5, row, layer);
     render_key_value(7, row, "HUB:", "%-3d", rgblight_get_hue(), false);
     render_indicator(15, row, layer);
@@ -1801,21 +2484,22 @@ void oled_render_hor5(uint32_t row) {
 }
 
 void oled_render_hor6(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_fixed_string(0, row, "Mtk64");
     render_indicator(5, row, layer);
     render_key_value(7, row, "SAT:", "%-3d", rgblight_get_sat(), false);
     render_indicator(15, row, layer);
-    render_key_value(16, row, " SSM ", "", 0, mtk_config.scroll_snap_mode == 0 || mtk_config.scroll_snap_mode == 1);
+    uint8_t snap_mode = mtk_get_scrollsnap_mode(mtk_get_edit_side());
+    render_key_value(16, row, " SSM ", "", 0, snap_mode == 0 || snap_mode == 1);
 }
 
 void oled_render_hor7(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_fixed_string(1, row, "erp");
     render_indicator(5, row, layer);
     render_key_value(7, row, "VAL:", "%-3d", rgblight_get_val(), false);
     render_indicator(15, row, layer);
-    render_snap_mode(17, row, mtk_config.scroll_snap_mode);
+    render_snap_mode(17, row, mtk_get_scrollsnap_mode(mtk_get_edit_side()));
 }
 
 
@@ -1848,14 +2532,15 @@ void oled_render_ver1(uint32_t row) {
 
 void oled_render_ver2(uint32_t row) {
     //render_key_value(0, row, " ADJ ", "", 0, mtk_get_speed_adjust_enabled());
-    if (mtk_get_speed_adjust_enabled()) {
+    if (mtk_get_speed_adjust_enabled(mtk_get_edit_side())) {
         render_image(0, row, bitmap_adj_on, sizeof(bitmap_adj_on));
     } else {
         render_image(0, row, bitmap_adj_off, sizeof(bitmap_adj_off));
     }
 
     //render_key_value(5, row, " SSM ", "", 0, mtk_config.scroll_snap_mode == 0 || mtk_config.scroll_snap_mode == 1);
-    if (mtk_config.scroll_snap_mode == MTK_SCROLLSNAP_MODE_VERTICAL || mtk_config.scroll_snap_mode == MTK_SCROLLSNAP_MODE_HORIZONTAL) {
+    uint8_t snap_mode = mtk_get_scrollsnap_mode(mtk_get_edit_side());
+    if (snap_mode == MTK_SCROLLSNAP_MODE_VERTICAL || snap_mode == MTK_SCROLLSNAP_MODE_HORIZONTAL) {
         render_image(5, row, bitmap_ssm_on, sizeof(bitmap_ssm_on));
     } else {
         render_image(5, row, bitmap_ssm_off, sizeof(bitmap_ssm_off));
@@ -1863,17 +2548,18 @@ void oled_render_ver2(uint32_t row) {
 }
 
 void oled_render_ver3(uint32_t row) {
-    render_decimal_value(1, row, "", mtk_config.speed_adjust_value / 10, mtk_config.speed_adjust_value % 10, false);
-    render_snap_mode(6, row, mtk_config.scroll_snap_mode);
+    uint8_t speed = mtk_get_speed_adjust_value(mtk_get_edit_side());
+    render_decimal_value(1, row, "", speed / 10, speed % 10, false);
+    render_snap_mode(6, row, mtk_get_scrollsnap_mode(mtk_get_edit_side()));
 }
 
 void oled_render_ver4(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator2(0, row, layer);
 }
 
 void oled_render_ver5(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_fixed_string(0, row, "Layer");
     //render_key_value(7, row, "", "%-d", layer, false);
     //render_fixed_string(8, row, "th");
@@ -1889,7 +2575,7 @@ void oled_render_ver5(uint32_t row) {
 }
 
 void oled_render_ver6(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     const uint8_t num_layers = sizeof(layer_names) / sizeof(layer_names[0]);     // 配列の長さを取得
     const char *layer_name = (layer < num_layers) ? layer_names[layer] : "UNK";  // 配列範囲内であれば描画、それ以外は "UNK" を表示
     render_fixed_string(0, row, layer_name);
@@ -1906,7 +2592,7 @@ void oled_render_ver6(uint32_t row) {
 }
 
 void oled_render_ver7(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator2(0, row, layer);
 }
 
@@ -1926,14 +2612,14 @@ void oled_render_ver9(uint32_t row) {
 }
 
 void oled_render_ver10(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator2(0, row, layer);
 }
 
 void oled_render_ver11(uint32_t row) {
     //render_key_value(0, row, "Ci", "", 0, true);
     render_image(0, row, bitmap_cip, sizeof(bitmap_cip));
-    render_key_value(2, row, "", "%3d", mtk_config.cpi_value, false);
+    render_key_value(2, row, "", "%3d", mtk_get_cpi(mtk_get_edit_side()), false);
     //render_key_value(5, row, "Rg", "", 0, true);
     render_image(5, row, bitmap_rgb, sizeof(bitmap_rgb));
     render_key_value(7, row, "", "%3d", rgblight_get_mode(), false);
@@ -1981,7 +2667,7 @@ void oled_render_ver15(uint32_t row) {
 // 行単位の画面表示メソッド。スレーブ側の表示部品。
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 void oled_render_slave1(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
 
     // 現在のレイヤに対応する画像を取得
     if (layer < sizeof(bitmap_layers) / sizeof(bitmap_layers[0])) {
@@ -1996,7 +2682,7 @@ void oled_render_slave1(uint32_t row) {
 }
 
 void oled_render_slave2(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
 
       // 現在のレイヤに対応する画像を取得
     if (layer < sizeof(bitmap_layers) / sizeof(bitmap_layers[0])) {
@@ -2009,10 +2695,31 @@ void oled_render_slave2(uint32_t row) {
 }
 
 void oled_render_slave3(uint32_t row) {
-    uint8_t layer = get_highest_layer(layer_state);
+    uint8_t layer = oled_state.layer;
     render_indicator_slave2(1, row, layer);
 }
 
+// 以下はマスターから同期した設定と表示状態（mtk_split.c）
+void oled_render_slave4(uint32_t row) {
+    render_key_value(0, row, "CPL:", "%-5d", mtk_get_cpi(MTK_SIDE_LEFT), mtk_get_edit_side() == MTK_SIDE_LEFT);
+    render_key_value(10, row, "CPR:", "%-5d", mtk_get_cpi(MTK_SIDE_RIGHT), mtk_get_edit_side() == MTK_SIDE_RIGHT);
+}
+
+void oled_render_slave5(uint32_t row) {
+    render_key_value(0, row, " SCR ", "", 0, mtk_get_scroll_mode());
+    render_key_value(5, row, " AML ", "", 0, mtk_get_auto_mouse_mode());
+    render_key_value(10, row, " ADJ ", "", 0, mtk_get_speed_adjust_enabled(mtk_get_edit_side()));
+    render_snap_mode(16, row, mtk_get_scrollsnap_mode(mtk_get_edit_side()));
+}
+
+void oled_render_slave6(uint32_t row) {
+    render_fixed_string(0, row, keylog_str_h);
+    render_fixed_string(4, row, "(");
+    render_fixed_string(5, row, keylog_str_n);
+    render_fixed_string(6, row, ")");
+    oled_write_type_count(10, row);
+}
+
 void oled_clear_line(uint8_t row) {
     oled_set_cursor(0, row);  // 行の先頭にカーソルを設定
     for (uint8_t col = 0; col < 21; col++) {
@@ -2021,30 +2728,25 @@ void oled_clear_line(uint8_t row) {
 }
 
 /****************************************************************************
-// * oled_partial_update_hor
-// *
-// * 指定された行範囲内でOLEDの部分更新を行う（横表示用）。
-// * 各行に対応する描画関数を動的に呼び出す。
-// * @param start_row 更新を開始する行番号
-// * @param end_row   更新を終了する行番号
-// * ****************************************************************************/
+ * oled_partial_update_hor
+ *
+ * 指定された行範囲内でOLEDの部分更新を行う（横表示用）。
+ * 依存する状態が変わった行だけを描き直す。
+ * @param start_row 更新を開始する行番号
+ * @param end_row   更新を終了する行番号
+ * ****************************************************************************/
 void oled_partial_update_hor(uint8_t start_row, uint8_t end_row) {
-    // 関数ポインタ配列を作成
-    void (*render_functions[])(uint8_t) = {
-        (void (*)(uint8_t))oled_render_hor0,
-        (void (*)(uint8_t))oled_render_hor1,
-        (void (*)(uint8_t))oled_render_hor2,
-        (void (*)(uint8_t))oled_render_hor3,
-        (void (*)(uint8_t))oled_render_hor4,
-        (void (*)(uint8_t))oled_render_hor5,
-        (void (*)(uint8_t))oled_render_hor6,
-        (void (*)(uint8_t))oled_render_hor7
+    static const oled_row_t rows[] = {
+        {0, oled_render_hor0, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_KEYLOG | MTK_OLED_DEP_CONFIG},
+        {1, oled_render_hor1, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_CONFIG},
+        {2, oled_render_hor2, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_CONFIG},
+        {3, oled_render_hor3, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_MOTION | MTK_OLED_DEP_CONFIG},
+        {4, oled_render_hor4, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_RGB | MTK_OLED_DEP_SCROLL},
+        {5, oled_render_hor5, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_RGB | MTK_OLED_DEP_SCROLL},
+        {6, oled_render_hor6, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_RGB | MTK_OLED_DEP_SCROLL},
+        {7, oled_render_hor7, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_RGB | MTK_OLED_DEP_SCROLL},
     };
-
-    // 指定範囲の行を描画
-    for (uint8_t row = start_row; row <= end_row && row < sizeof(render_functions) / sizeof(render_functions[0]); row++) {
-        render_functions[row](row);
-    }
+    oled_render_rows(rows, sizeof(rows) / sizeof(rows[0]), start_row, end_row);
 }
 
 
@@ -2052,35 +2754,178 @@ void oled_partial_update_hor(uint8_t start_row, uint8_t end_row) {
  * oled_partial_update_ver
  *
  * 指定された行範囲内でOLEDの部分更新を行う（縦表示用）。
- * 各行に対応する描画関数を動的に呼び出す。
+ * 依存する状態が変わった行だけを描き直す。
+ * ver5 と ver6 はどちらも5行目に書くので、同じ状態（レイヤ）に依存させて順に描く。
  * @param start_row 更新を開始する行番号
  * @param end_row   更新を終了する行番号
  * ****************************************************************************/
 void oled_partial_update_ver(uint8_t start_row, uint8_t end_row) {
-    // 関数ポインタ配列を作成
-    void (*render_functions[])(uint8_t) = {
-        (void (*)(uint8_t))oled_render_ver0,
-        (void (*)(uint8_t))oled_render_ver1,
-        (void (*)(uint8_t))oled_render_ver2,
-        (void (*)(uint8_t))oled_render_ver3,
-        (void (*)(uint8_t))oled_render_ver4,
-        (void (*)(uint8_t))oled_render_ver5,
-        (void (*)(uint8_t))oled_render_ver6,
-        (void (*)(uint8_t))oled_render_ver7,
-        (void (*)(uint8_t))oled_render_ver8,
-        (void (*)(uint8_t))oled_render_ver9,
-        (void (*)(uint8_t))oled_render_ver10,
-        (void (*)(uint8_t))oled_render_ver11,
-        (void (*)(uint8_t))oled_render_ver12,
-        (void (*)(uint8_t))oled_render_ver13,
-        (void (*)(uint8_t))oled_render_ver14,
-        (void (*)(uint8_t))oled_render_ver15
+    static const oled_row_t rows[] = {
+        {0,  oled_render_ver0,  MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_SCROLL},
+        {1,  oled_render_ver1,  MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_SCROLL},
+        {2,  oled_render_ver2,  MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_SCROLL},
+        {3,  oled_render_ver3,  MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_SCROLL},
+        {4,  oled_render_ver4,  MTK_OLED_DEP_LAYER | MTK_OLED_DEP_TYPE_LEVEL},
+        {5,  oled_render_ver5,  MTK_OLED_DEP_LAYER},
+        {6,  oled_render_ver6,  MTK_OLED_DEP_LAYER},
+        {7,  oled_render_ver7,  MTK_OLED_DEP_LAYER | MTK_OLED_DEP_TYPE_LEVEL},
+        {8,  oled_render_ver8,  MTK_OLED_DEP_KEYLOG},
+        {9,  oled_render_ver9,  MTK_OLED_DEP_KEYLOG},
+        {10, oled_render_ver10, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_TYPE_LEVEL},
+        {11, oled_render_ver11, MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_RGB},
+        {12, oled_render_ver12, MTK_OLED_DEP_RGB},
+        {13, oled_render_ver13, MTK_OLED_DEP_MOTION | MTK_OLED_DEP_RGB},
+        {14, oled_render_ver14, MTK_OLED_DEP_UPTIME | MTK_OLED_DEP_RGB},
+        {15, oled_render_ver15, MTK_OLED_DEP_COUNT},
     };
+    oled_render_rows(rows, sizeof(rows) / sizeof(rows[0]), start_row, end_row);
+}
+
+
+/****************************************************************************
+ * oled_partial_update_slave
+ *
+ * スレーブ側のレイヤ表示を、依存する状態が変わった行だけ描き直す。
+ * ****************************************************************************/
+void oled_partial_update_slave(void) {
+    static const oled_row_t rows[] = {
+        {0, oled_render_slave1, MTK_OLED_DEP_LAYER},
+        {2, oled_render_slave4, MTK_OLED_DEP_CONFIG},
+        {3, oled_render_slave5, MTK_OLED_DEP_CONFIG | MTK_OLED_DEP_SCROLL},
+        {4, oled_render_slave6, MTK_OLED_DEP_KEYLOG | MTK_OLED_DEP_COUNT},
+        {6, oled_render_slave2, MTK_OLED_DEP_LAYER},
+        {7, oled_render_slave3, MTK_OLED_DEP_LAYER | MTK_OLED_DEP_TYPE_LEVEL},
+    };
+    oled_render_rows(rows, sizeof(rows) / sizeof(rows[0]), 0, 7);
+}
 
-    // 指定範囲の行を描画
-    for (uint8_t row = start_row; row <= end_row && row < sizeof(render_functions) / sizeof(render_functions[0]); row++) {
-        render_functions[row](row);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+//  OLED表示 診断ページ（マスター側）
+//
+// OLED_PG キーで通常の表示と切り替える。縦表示では1列、横表示では2列に並べる。
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+/****************************************************************************
+ * oled_render_diag
+ *
+ * 1行目にタイトル、2行目以降に「ラベル + 5桁の値」を並べて描画する。
+ * @param title  タイトル
+ * @param labels 各項目のラベル（4文字）
+ * @param values 各項目の値
+ * @param count  項目数
+ * ****************************************************************************/
+void oled_render_diag(const char *title, const char *const labels[], const uint32_t values[], uint8_t count) {
+    const uint8_t rows = mtk_get_oled_orient_value() == 1 ? 15 : 7;  // タイトルを除いた1列の行数
+
+    render_fixed_string(0, 0, title);
+    oled_count_rows(1 + (count < rows ? count : rows));
+    for (uint8_t i = 0; i < count; i++) {
+        char    buffer[11];
+        uint8_t n = mtk_fmt_str(buffer, sizeof(buffer), labels[i]);
+        mtk_fmt_udec(buffer + n, sizeof(buffer) - n, values[i], 5, false);
+        oled_set_cursor((i / rows) * 11, 1 + i % rows);
+        oled_write(buffer, false);
+    }
+}
+
+
+/****************************************************************************
+ * oled_render_page_split
+ *
+ * 左右間の通信の状態（毎秒のトランザクション数・バイト数、失敗・再送・切断の回数、
+ * 直前の1秒間の往復時間の最小・平均・最大）を描画する。
+ * ****************************************************************************/
+void oled_render_page_split(void) {
+#ifdef SPLIT_KEYBOARD
+    static const char *const labels[] = {"TPS:", "BPS:", "ERR:", "RTY:", "DSC:", "MIN:", "AVG:", "MAX:"};
+    mtk_split_stats_t stats;
+    mtk_split_get_stats(&stats);
+    const uint32_t values[] = {
+        mtk_split_get_transaction_rate(), mtk_split_get_byte_rate(),
+        stats.errors, stats.retries, stats.disconnects,
+        stats.rtt_min_us, stats.rtt_avg_us, stats.rtt_max_us,
+    };
+    oled_render_diag(is_transport_connected() ? "LINK OK" : "LINK NG", labels, values, sizeof(values) / sizeof(values[0]));
+#endif
+}
+
+
+/****************************************************************************
+ * oled_render_page_matrix
+ *
+ * キーマトリクスのスキャン（毎秒のスキャン回数、1回のスキャン時間の平均・最大）と
+ * チャタリング除去の1回の処理時間（平均はナノ秒、最大はマイクロ秒）を描画する。
+ * ****************************************************************************/
+void oled_render_page_matrix(void) {
+    static const char *const labels[] = {"SCN:", "AVG:", "MAX:", "DBn:", "DBM:"};
+    const uint32_t values[] = {
+        mtk_matrix_get_scan_rate(), mtk_matrix_get_scan_time(false), mtk_matrix_get_scan_time(true),
+        mtk_debounce_get_avg_ns(), mtk_debounce_get_max_us(),
+    };
+    oled_render_diag("MATRIX", labels, values, sizeof(values) / sizeof(values[0]));
+}
+
+
+/****************************************************************************
+ * oled_render_page_latency
+ *
+ * 毎秒のスキャン回数、直前の1秒間のループ時間の最大（マイクロ秒）、
+ * キー入力からレポートまでの時間のヒストグラム（区間ごとの回数）と、
+ * OLED に毎秒描画した行数・バイト数、OLED の転送で待たされた時間の最大（マイクロ秒）を描画する。
+ * ****************************************************************************/
+void oled_render_page_latency(void) {
+    static const char *const labels[] = {"SCN:", "LPM:", "<100", "<250", "<500", "<1ms", "<2ms", "<5ms", ">5ms", "ROW:", "BYT:", "OST:"};
+    mtk_latency_stats_t stats;
+    mtk_latency_get_stats(&stats);
+    mtk_oled_stats_t oled;
+    mtk_oled_get_stats(&oled);
+    uint32_t values[2 + MTK_LATENCY_BUCKETS + 3] = {mtk_matrix_get_scan_rate(), stats.loop_max_us};
+    memcpy(&values[2], stats.histogram, sizeof(stats.histogram));
+    uint16_t rows;
+    mtk_get_oled_render_rate(&rows, &values[2 + MTK_LATENCY_BUCKETS + 1]);
+    values[2 + MTK_LATENCY_BUCKETS]     = rows;
+    values[2 + MTK_LATENCY_BUCKETS + 2] = oled.stall_max_us;
+    oled_render_diag("LATENCY", labels, values, sizeof(values) / sizeof(values[0]));
+}
+
+
+/****************************************************************************
+ * oled_render_page_keylog
+ *
+ * キーログの履歴を新しい順に1行ずつ描画する（キーログが変わったときだけ）。
+ * 各行は「16進のキーコード 名前 行 列」、横表示では前のキーからの時間（ミリ秒）も描画する。
+ * ****************************************************************************/
+void oled_render_page_keylog(void) {
+    if (!(oled_changed & MTK_OLED_DEP_KEYLOG)) {
+        return;
+    }
+    const bool    vertical = mtk_get_oled_orient_value() == 1;
+    const uint8_t rows     = vertical ? 15 : 7;
+
+    render_fixed_string(0, 0, "KEYS");
+    for (uint8_t i = 0; i < rows; i++) {
+        const mtk_keylog_t *entry = keylog_get(i);
+        char                buffer[22];
+        uint8_t             n = 0;
+
+        buffer[0] = '\0';
+        if (entry != NULL) {
+            const uint16_t keycode = keylog_code(entry->keycode);
+            n += mtk_fmt_hex(buffer + n, sizeof(buffer) - n, keycode, 4);
+            buffer[n++] = ' ';
+            buffer[n++] = keylog_name(keycode);
+            n += mtk_fmt_udec(buffer + n, sizeof(buffer) - n, entry->row, 2, false);
+            n += mtk_fmt_udec(buffer + n, sizeof(buffer) - n, entry->col, 2, false);
+
+            const mtk_keylog_t *prev = keylog_get(i + 1);
+            if (!vertical && prev != NULL) {
+                n += mtk_fmt_str(buffer + n, sizeof(buffer) - n, " +");
+                mtk_fmt_udec(buffer + n, sizeof(buffer) - n, (uint16_t)(entry->time - prev->time), 5, false);
+            }
+        }
+        render_fixed_string(0, 1 + i, buffer);
     }
+    oled_count_rows(1 + rows);
 }
 
 
@@ -2089,7 +2934,7 @@ void oled_partial_update_ver(uint8_t start_row, uint8_t end_row) {
  *
  * OLEDディスプレイのタスクを処理する関数。
  * - マスター/スレーブ状態に応じて異なる情報を表示。
- * - マスターの場合、OLEDの向きに応じて表示内容を更新。
+ * - マスターの場合、OLEDの向きに応じて表示内容を更新。診断ページの選択中はそのページを表示。
  * - スレーブの場合、レイヤ情報やキー押下情報、アニメーションを表示。
  *
  * @return 常に false を返す（QMKの規約に準拠）。
@@ -2099,20 +2944,29 @@ bool oled_task_kb(void) {
 
     if (timer_elapsed(last_update) > 100) {                                               // 前回の更新から100ms経過していたら更新を実行。
         last_update = timer_read();                                                       // 現在の時間を last_update に設定。
+        oled_update_state();                                                              // 値が変わった状態を調べる。
+        mtk_oled_frame();                                                                 // 前のフレームの転送量を記録する。
 
         if (is_keyboard_master()) {                                                       // マスターデバイスであるかどうかを判定。
-            if (mtk_get_oled_orient_value() == 0) {                                       // 横向きの場合(oled.orient=1)
+            if (oled_page == MTK_OLED_PAGE_SPLIT) {                                       // 診断ページ
+                oled_render_page_split();
+            } else if (oled_page == MTK_OLED_PAGE_MATRIX) {
+                oled_render_page_matrix();
+            } else if (oled_page == MTK_OLED_PAGE_LATENCY) {
+                oled_render_page_latency();
+            } else if (oled_page == MTK_OLED_PAGE_KEYLOG) {
+                oled_render_page_keylog();
+            } else if (mtk_get_oled_orient_value() == 0) {                                       // 横向きの場合(oled.orient=1)
                 oled_partial_update_hor(0, 7);                                            // 0行目から7行目まで部分的に更新。
             } else if (mtk_get_oled_orient_value() == 1) {                                // 縦向きの場合(oled.orient=0)
                 oled_partial_update_ver(0, 15);                                           // 0行目から15行目まで部分的に更新。
             }
         } else {                                                                          // スレーブデバイスである場合。
 #ifdef SPLIT_LAYER_STATE_ENABLE
-           if (get_highest_layer(layer_state) != 0) {                                           // アクティブなレイヤが0でない場合、特定のレイヤ名を表示。
-                oled_render_slave1(0);
-                oled_render_slave2(6);
-                oled_render_slave3(7);
+           if (oled_state.layer != 0) {                                                   // アクティブなレイヤが0でない場合、特定のレイヤ名を表示。
+                oled_partial_update_slave();                                              // 変わった行だけを描画。
             } else {                                                                      // それ以外の場合、アニメーションの描画。
+                oled_redraw = true;                                                       // レイヤ表示に戻ったら全行を描き直す。
                 oled_clear_line(6);  // 行6をクリア
                 oled_clear_line(7);  // 行7をクリア
                 if (timer_elapsed(anim_frame_interval) > 300) {                           // 300msごとにアニメーションを更新。
@@ -11,15 +11,28 @@
 
 #include "quantum.h"
 #include <stdint.h> // 基本的な型定義用
+#include "mtk_pointer.h" // ポインタ処理
 
 
 //////////////////////////////////////////////////////////////////////////////
 // 定数定義
 
-// スクロールスナップモードの定義
-#define MTK_SCROLLSNAP_MODE_VERTICAL   0
-#define MTK_SCROLLSNAP_MODE_HORIZONTAL 1
-#define MTK_SCROLLSNAP_MODE_FREE       2
+#define MTK_CONFIG_HID_ID  0xE2  // raw HID のコマンドID（拡張設定の読み書き）
+
+#ifndef MTK_KEYLOG_SIZE
+#    define MTK_KEYLOG_SIZE  16    // キーログの履歴の数（2のべき乗）
+#endif
+
+// マイクロ秒タイマー（RP2040 の TIMER ブロックの TIMERAWL を直接読む）
+// core 1 の RAM 上のコードからも呼ぶため、常にインライン展開する
+// ホストテストではレジスタの代わりに時刻の変数を指定する
+#ifndef MTK_TIMER_RAWL
+#    define MTK_TIMER_RAWL  (*(volatile uint32_t *)0x40054028)
+#endif
+
+static inline __attribute__((always_inline)) uint32_t mtk_timer_read_us(void) {
+    return MTK_TIMER_RAWL;
+}
 
 #ifndef EECONFIG_ADDITIONAL_H
     #define EECONFIG_ADDITIONAL_H
@@ -68,8 +81,7 @@ typedef struct {
     int16_t x;           // X方向の位置
     int16_t y;           // Y方向の位置
     int16_t active_time; // アクティブ時間
-    int16_t inertia_x;   // 慣性スクロールの速度X
-    int16_t inertia_y;   // 慣性スクロールの速度Y
+    uint32_t last_motion; // 最後に移動があった時刻（アイドルリセットの影響を受けない）
 } mtk_motion_t;
 
 // EEPROM設定データ
@@ -87,29 +99,66 @@ typedef union __attribute__((__packed__)) {
     };
 } ee_config_t;
 
-
+// EEPROM設定データ（拡張分、EECONFIG_KB_DATA_SIZE のデータブロック）
+// 0 の項目はデフォルト値を使う（データブロックは初期化時に0で埋められるため）
+typedef struct __attribute__((__packed__)) {
+    uint8_t rest1_time;           // 最後の移動からセンサーが REST1 に入るまでの時間（100ms単位）
+    uint8_t rest2_time;           // 最後の移動から REST2 に入るまでの時間（秒）
+    uint8_t rest3_time;           // 最後の移動から REST3 に入るまでの時間（秒）
+    uint8_t cpi_l;                // 左のCPI（PMW33XX_CPI_STEP 単位、0: 右と同じ）
+    uint8_t speed_adjust_value_l; // 左の速度調整値（0: 右と同じ）
+    uint8_t scroll_snap_mode_l;   // 左のスクロールスナップモード + 1（0: 右と同じ）
+    uint8_t side_flags;           // 左右別のフラグ（MTK_EE_SIDE_*）
+    uint8_t flags;                // 左右共通のフラグ（MTK_EE_FLAG_*）
+} ee_config_ext_t;
+
+// ee_config_ext_t.side_flags（0 がデフォルトになるよう、速度調整は無効の方をビットにする）
+#define MTK_EE_SIDE_SCROLL_ALWAYS_L   0x01  // 左は常にスクロール
+#define MTK_EE_SIDE_SCROLL_ALWAYS_R   0x02  // 右は常にスクロール
+#define MTK_EE_SIDE_ADJUST_OFF_L      0x04  // 左の速度調整を無効
+#define MTK_EE_SIDE_ADJUST_OFF_R      0x08  // 右の速度調整を無効
+
+// ee_config_ext_t.flags（0 がデフォルトになるよう、無効の方をビットにする）
+#define MTK_EE_FLAG_HIRES_OFF         0x01  // 高分解能スクロールを無効
+
+// 左右のトラックボール
+#define MTK_SIDE_LEFT   0
+#define MTK_SIDE_RIGHT  1
+
+// 左右それぞれのトラックボールの設定
 typedef struct {
     uint16_t cpi_value;             // トラックボールの感度値
+    bool     speed_adjust_enabled;  // トラックボール移動速度調整の有効/無効
+    uint8_t  speed_adjust_value;    // トラックボール移動速度調整の倍率 (0-255)
+    uint8_t  scroll_snap_mode;      // スクロールスナップモード (例: 0: 垂直, 1: 水平, 2: 無効)
+    bool     scroll_always;         // スクロールモードに関係なく常にスクロールする
+} mtk_side_config_t;
+
+
+typedef struct {
+    mtk_side_config_t side[2];      // 左右それぞれのトラックボールの設定 (MTK_SIDE_LEFT/RIGHT)
+    uint8_t  edit_side;             // キーで設定を変更する側 (MTK_SIDE_LEFT/RIGHT)
     bool     cpi_changed;           // 感度が変更されたかどうか
     bool     scroll_mode;           // スクロールモードの有効/無効
     bool     scroll_direction;      // スクロール方向 (true: 正方向, false: 逆方向)
     uint8_t  scroll_div;            // スクロール速度の分割値
-    uint8_t  scroll_snap_mode;      // スクロールスナップモード (例: 0: 無効, 1: 水平, 2: 垂直)
     uint16_t auto_mouse_time_out;   // 自動マウスモードのタイムアウト時間 (ミリ秒)
-    uint32_t scroll_snap_last;      // スクロールスナップの最後のタイムスタンプ
-    int8_t   scroll_snap_tension_h; // 水平方向のスクロールスナップのテンション
     mtk_motion_t motion;            // トラックボールの動き
     bool     auto_mouse_mode;       // 自動マウスモードの有効/無効
     bool     key_pressed;           // 現在キーが押されているかどうか
     char     current_key[6];        // 押下されたキー名 (最大5文字 + NULL終端)
     uint8_t  active_layer;          // 現在のアクティブレイヤ
-    bool     speed_adjust_enabled;  // トラックボール移動速度調整の有効/無効
-    uint8_t  speed_adjust_value;    // トラックボール移動速度調整の倍率 (0-255)
     uint8_t  oled_orient;           // OLED表示方向
+    bool     scroll_hires;          // 高分解能スクロールの有効/無効
+    bool     inertia_enabled;       // 慣性スクロールの有効/無効
+    uint8_t  inertia_friction;      // 慣性スクロールの減衰率 (1tickごとに速度を n/256 倍)
+    uint8_t  rest_time[3];          // センサーが REST1/2/3 に入るまでの時間 (ee_config_ext_t と同じ単位、0: デフォルト)
 } mtk_config_t;
 
 extern mtk_motion_t mtk_motion;
+extern mtk_motion_t remote_motion;
 extern ee_config_t ee_config;
+extern ee_config_ext_t ee_config_ext;
 extern mtk_config_t mtk_config;
 
 // カスタムキーコードの定義
@@ -143,6 +192,14 @@ enum custom_keycodes {
     ADJMS_SPD_DEC,          // トラックボール速度調整値を減少
 
     OLED_ORI_TG,            // OLED表示方向の切替 (0: 横 / 1: 縦)
+
+    INRT_TG,                // 慣性スクロールの切替
+    SCRL_HRS,               // 高分解能スクロールの切替
+    TRC_TG,                 // 移動量トレース記録の開始/停止
+
+    SIDE_TG,                // 設定を変更するトラックボール（左/右）の切替
+    SCRL_LCK,               // 設定中の側を常にスクロールにする切替
+    OLED_PG,                // OLEDの表示ページ（通常/診断）の切替
 };
 
 
@@ -161,11 +218,19 @@ void mtk_set_scroll_direction(bool direction);
 uint8_t mtk_get_scroll_div(void);
 void mtk_set_scroll_div(uint8_t div);
 
-// CPI値の取得と設定
-uint16_t mtk_get_cpi(void);
-void mtk_set_cpi(uint16_t cpi);
+// CPI値の取得と設定（side: MTK_SIDE_LEFT/RIGHT）
+uint16_t mtk_get_cpi(uint8_t side);
+void mtk_set_cpi(uint8_t side, uint16_t cpi);
+
+// 設定を変更する側の取得と設定
+uint8_t mtk_get_edit_side(void);
+void mtk_set_edit_side(uint8_t side);
+
+// 常にスクロールする側の取得と設定
+bool mtk_get_scroll_always(uint8_t side);
+void mtk_set_scroll_always(uint8_t side, bool enabled);
 
-// キーログの記録
+// キーログの記録（押したキーを履歴に積むだけで、表示用の文字列は OLED の描画時に作る）
 void set_keylog(uint16_t keycode, keyrecord_t *record);
 
 
@@ -180,22 +245,41 @@ void mtk_set_auto_mouse_mode(bool mode);
 uint16_t mtk_get_auto_mouse_time_out(void);
 void mtk_set_auto_mouse_time_out(uint16_t timeout);
 
-// スクロールスナップモードの取得と設定
-void mtk_set_scrollsnap_mode(uint8_t mode);
-uint8_t mtk_get_scrollsnap_mode(void);
+// スクロールスナップモードの取得と設定（左右別）
+void mtk_set_scrollsnap_mode(uint8_t side, uint8_t mode);
+uint8_t mtk_get_scrollsnap_mode(uint8_t side);
 
-// トラックボール速度調整値の取得と設定
-void mtk_set_speed_adjust_value(uint8_t value);
-uint8_t mtk_get_speed_adjust_value(void);
+// トラックボール速度調整値の取得と設定（左右別）
+void mtk_set_speed_adjust_value(uint8_t side, uint8_t value);
+uint8_t mtk_get_speed_adjust_value(uint8_t side);
 
-// トラックボール速度調整の有効化状態を取得と設定
-bool mtk_get_speed_adjust_enabled(void);
-void mtk_set_speed_adjust_enabled(bool enabled);
+// トラックボール速度調整の有効化状態を取得と設定（左右別）
+bool mtk_get_speed_adjust_enabled(uint8_t side);
+void mtk_set_speed_adjust_enabled(uint8_t side, bool enabled);
+
+// 高分解能スクロールの有効化状態と分解能の取得と設定
+bool mtk_get_scroll_hires(void);
+void mtk_set_scroll_hires(bool enabled);
+uint16_t mtk_get_scroll_resolution(void);
+
+// 慣性スクロールの有効化状態と減衰率の取得と設定
+bool mtk_get_inertia_enabled(void);
+void mtk_set_inertia_enabled(bool enabled);
+uint8_t mtk_get_inertia_friction(void);
+void mtk_set_inertia_friction(uint8_t friction);
+
+// センサーのレストモード移行時間の取得と設定（level: 1-3、ミリ秒）、センサーへの反映
+uint32_t mtk_get_rest_time(uint8_t level);
+void mtk_set_rest_time(uint8_t level, uint8_t value);
+void mtk_apply_rest_times(void);
 
 // OLED表示方向の取得と設定
 uint8_t mtk_get_oled_orient_value(void);
 void mtk_set_oled_orient_value(uint8_t val);
 
+// 直前の1秒間に OLED に描画した行数とバイト数
+void mtk_get_oled_render_rate(uint16_t *rows, uint32_t *bytes);
+
 // 値ロード
 void load_mtk_config(void);
 
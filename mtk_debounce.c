@@ -0,0 +1,205 @@
+/*
+ * mtk_debounce.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * キーごとのチャタリング除去（DEBOUNCE_TYPE = custom）。
+ * 押下はすぐに反映し、離しは DEBOUNCE ミリ秒続けて離れていたら反映する（eager press / deferred release）。
+ * 1つのキーがチャタリングしても他のキーは遅れない。
+ *
+ * ■ビット並列の処理
+ * 片手分の行（matrix_row_t のビット数 × MATRIX_ROWS / 2 行）を1つの64ビットのビット列にまとめ、
+ * キーごとの経過時間のカウンタもビットスライス（カウンタの各ビットを1つのビット列に）で持つ。
+ * 1ミリ秒ごとのカウンタの更新は、キーの数に関係なくビット列の数回の演算で済む。
+ * matrix_mask で除かれているキーは常に離した状態として扱う。
+ */
+
+#include "quantum.h"
+#include "matrix.h"
+#include "debounce.h"
+#include "mtk_debounce.h"
+#include "mtk64erp.h"
+
+typedef uint64_t debounce_bits_t;  // 片手分のキーの状態（行ごとに MATRIX_ROW_BITS ビット）
+
+#define MATRIX_ROW_BITS          (sizeof(matrix_row_t) * 8)
+#define MTK_DEBOUNCE_COUNT_BITS  4  // 経過時間のカウンタのビット数
+
+#ifdef SPLIT_KEYBOARD
+#    define MTK_DEBOUNCE_ROWS    (MATRIX_ROWS / 2)  // 片手分の行数（debounce に渡される num_rows）
+#else
+#    define MTK_DEBOUNCE_ROWS    MATRIX_ROWS
+#endif
+
+_Static_assert(MATRIX_ROW_BITS * MTK_DEBOUNCE_ROWS <= sizeof(debounce_bits_t) * 8, "half of the matrix must fit in debounce_bits_t");
+_Static_assert(DEBOUNCE > 0 && DEBOUNCE < (1 << MTK_DEBOUNCE_COUNT_BITS), "DEBOUNCE must fit in the counter");
+
+static debounce_bits_t raw_bits     = 0;  // スキャンした状態
+static debounce_bits_t cooked_bits  = 0;  // チャタリング除去後の状態
+static debounce_bits_t mask_bits    = 0;  // matrix_mask で有効なキー
+static debounce_bits_t count_bits[MTK_DEBOUNCE_COUNT_BITS];  // 離れている時間（ミリ秒）のビットスライス
+static uint16_t        last_tick    = 0;  // 前回の時刻（ミリ秒）
+
+// 処理時間の統計（1秒ごとに区切る）
+static uint32_t debounce_start   = 0;  // 集計区間の開始時刻（ミリ秒）
+static uint32_t debounce_count   = 0;  // 集計中の区間の呼び出し回数
+static uint32_t debounce_us_sum  = 0;  // 集計中の区間の処理時間の合計
+static uint16_t debounce_us_max  = 0;  // 集計中の区間の処理時間の最大
+static uint16_t debounce_avg_ns  = 0;  // 直前の1秒間の1回あたりの平均（ナノ秒）
+static uint16_t debounce_max_us  = 0;  // 直前の1秒間の最大（マイクロ秒）
+
+
+/****************************************************************************
+ * debounce_pack / debounce_unpack
+ *
+ * 行の配列と1つのビット列を相互に変換する。
+ * ****************************************************************************/
+static debounce_bits_t debounce_pack(const matrix_row_t rows[], uint8_t num_rows) {
+    debounce_bits_t bits = 0;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        bits |= (debounce_bits_t)rows[row] << (row * MATRIX_ROW_BITS);
+    }
+    return bits;
+}
+
+static void debounce_unpack(matrix_row_t rows[], uint8_t num_rows, debounce_bits_t bits) {
+    for (uint8_t row = 0; row < num_rows; row++) {
+        rows[row] = bits >> (row * MATRIX_ROW_BITS);
+    }
+}
+
+
+/****************************************************************************
+ * debounce_init
+ *
+ * 状態を初期化し、この手の matrix_mask をビット列にする。
+ * 分割キーボードでは右手の行は matrix_mask の後半にある。
+ * ****************************************************************************/
+void debounce_init(uint8_t num_rows) {
+    uint8_t offset = 0;
+#ifdef SPLIT_KEYBOARD
+    if (num_rows < MATRIX_ROWS && !is_keyboard_left()) {
+        offset = num_rows;
+    }
+#endif
+#ifdef MATRIX_MASKED
+    mask_bits = debounce_pack(&matrix_mask[offset], num_rows);
+#else
+    (void)offset;
+    mask_bits = ~(debounce_bits_t)0;
+#endif
+    raw_bits    = 0;
+    cooked_bits = 0;
+    for (uint8_t k = 0; k < MTK_DEBOUNCE_COUNT_BITS; k++) {
+        count_bits[k] = 0;
+    }
+    last_tick      = timer_read();
+    debounce_start = timer_read32();
+}
+
+
+/****************************************************************************
+ * debounce_tick
+ *
+ * 離しの確定待ちのキー（waiting）のカウンタを1ミリ秒進め、DEBOUNCE に達したキーを返す。
+ * ****************************************************************************/
+static debounce_bits_t debounce_tick(debounce_bits_t waiting) {
+    // ビットスライスのカウンタに waiting のビットだけ1を足す
+    debounce_bits_t carry = waiting;
+    for (uint8_t k = 0; k < MTK_DEBOUNCE_COUNT_BITS; k++) {
+        debounce_bits_t c = count_bits[k];
+        count_bits[k]     = c ^ carry;
+        carry &= c;
+    }
+
+    // カウンタが DEBOUNCE と一致したキー
+    debounce_bits_t done = waiting;
+    for (uint8_t k = 0; k < MTK_DEBOUNCE_COUNT_BITS; k++) {
+        done &= (DEBOUNCE >> k) & 1 ? count_bits[k] : ~count_bits[k];
+    }
+    return done;
+}
+
+
+/****************************************************************************
+ * debounce
+ *
+ * スキャン結果（raw）からチャタリング除去後の状態（cooked）を作る。
+ * 押下はすぐに反映する。離れたキーは DEBOUNCE ミリ秒続けて離れていたら反映し、
+ * その間に再び押された場合はカウンタを0に戻す。
+ * 離しの確定待ちのキーがなく、スキャン結果も変わっていなければ何もしない。
+ * ****************************************************************************/
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint32_t start   = mtk_timer_read_us();
+    uint16_t now     = timer_read();
+    uint16_t elapsed = now - last_tick;
+    last_tick        = now;
+
+    if (changed) {
+        raw_bits = debounce_pack(raw, num_rows) & mask_bits;
+    }
+
+    debounce_bits_t before  = cooked_bits;
+    debounce_bits_t waiting = cooked_bits & ~raw_bits;  // 離しの確定待ち
+    if (changed || waiting) {
+        cooked_bits |= raw_bits;                        // 押下はすぐに反映
+        for (uint8_t k = 0; k < MTK_DEBOUNCE_COUNT_BITS; k++) {
+            count_bits[k] &= waiting;                   // 押されているキーのカウンタは0に戻す
+        }
+
+        // 経過したミリ秒の分だけカウンタを進める
+        for (uint16_t t = 0; t < elapsed && waiting; t++) {
+            debounce_bits_t done = debounce_tick(waiting);
+            if (done) {
+                cooked_bits &= ~done;
+                waiting &= ~done;
+                for (uint8_t k = 0; k < MTK_DEBOUNCE_COUNT_BITS; k++) {
+                    count_bits[k] &= ~done;
+                }
+            }
+        }
+    }
+
+    bool cooked_changed = cooked_bits != before;
+    if (cooked_changed) {
+        debounce_unpack(cooked, num_rows, cooked_bits);
+    }
+
+    // 処理時間の統計
+    uint32_t us = mtk_timer_read_us() - start;
+    debounce_count++;
+    debounce_us_sum += us;
+    debounce_us_max = us > debounce_us_max ? (us > UINT16_MAX ? UINT16_MAX : us) : debounce_us_max;
+    if (timer_elapsed32(debounce_start) >= 1000) {
+        uint32_t avg_ns = debounce_count ? (uint64_t)debounce_us_sum * 1000 / debounce_count : 0;
+        debounce_avg_ns = avg_ns > UINT16_MAX ? UINT16_MAX : avg_ns;
+        debounce_max_us = debounce_us_max;
+        debounce_count  = 0;
+        debounce_us_sum = 0;
+        debounce_us_max = 0;
+        debounce_start  = timer_read32();
+    }
+    return cooked_changed;
+}
+
+
+/****************************************************************************
+ * debounce_free
+ *
+ * 静的な領域だけを使うので何もしない。
+ * ****************************************************************************/
+void debounce_free(void) {}
+
+
+/****************************************************************************
+ * mtk_debounce_get_avg_ns / mtk_debounce_get_max_us
+ *
+ * 直前の1秒間の1回あたりの処理時間の平均（ナノ秒）と最大（マイクロ秒）を取得する。
+ * ****************************************************************************/
+uint16_t mtk_debounce_get_avg_ns(void) {
+    return debounce_avg_ns;
+}
+
+uint16_t mtk_debounce_get_max_us(void) {
+    return debounce_max_us;
+}
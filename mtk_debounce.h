@@ -0,0 +1,21 @@
+/*
+ * mtk_debounce.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * キーごとのチャタリング除去（DEBOUNCE_TYPE = custom）。
+ * 押下はすぐに反映し、離しは DEBOUNCE ミリ秒続けて離れていたら反映する。
+ * 処理は片手分のキーをまとめたビット列の演算で行う（mtk_debounce.c を参照）。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// 直前の1秒間の1回あたりの処理時間の平均（ナノ秒）と最大（マイクロ秒）
+uint16_t mtk_debounce_get_avg_ns(void);
+uint16_t mtk_debounce_get_max_us(void);
@@ -0,0 +1,133 @@
+/*
+ * mtk_fmt.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * OLED 表示用の整数の書式化（仕様は mtk_fmt.h を参照）。
+ * 10進数は下の桁から一時領域に書いてから並べ直す。除算は定数10で、コンパイラが乗算に置き換える。
+ */
+
+#include "mtk_fmt.h"
+
+#define MTK_FMT_DIGITS_MAX  11  // 32ビットの10進数の最大桁数（符号を含む）
+
+
+/****************************************************************************
+ * fmt_put
+ *
+ * 1文字を書く。終端文字の分を残して入らない場合は書かない。
+ * ****************************************************************************/
+static inline void fmt_put(char *buf, uint8_t size, uint8_t *n, char c) {
+    if (*n + 1 < size) {
+        buf[(*n)++] = c;
+    }
+}
+
+
+/****************************************************************************
+ * fmt_number
+ *
+ * 符号と桁（下の桁から並んだもの）を幅に合わせて書き、終端文字を書く。
+ * ****************************************************************************/
+static uint8_t fmt_number(char *buf, uint8_t size, const char *digits, uint8_t count, bool negative, uint8_t width, bool left) {
+    uint8_t n   = 0;
+    uint8_t len = count + (negative ? 1 : 0);
+
+    if (size == 0) {
+        return 0;
+    }
+    if (!left) {
+        for (uint8_t i = len; i < width; i++) {
+            fmt_put(buf, size, &n, ' ');
+        }
+    }
+    if (negative) {
+        fmt_put(buf, size, &n, '-');
+    }
+    while (count) {
+        fmt_put(buf, size, &n, digits[--count]);
+    }
+    if (left) {
+        for (uint8_t i = len; i < width; i++) {
+            fmt_put(buf, size, &n, ' ');
+        }
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+
+/****************************************************************************
+ * mtk_fmt_str
+ *
+ * 文字列を書く。
+ * ****************************************************************************/
+uint8_t mtk_fmt_str(char *buf, uint8_t size, const char *str) {
+    uint8_t n = 0;
+
+    if (size == 0) {
+        return 0;
+    }
+    while (*str) {
+        fmt_put(buf, size, &n, *str++);
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+
+/****************************************************************************
+ * mtk_fmt_udec
+ *
+ * 符号なし整数を10進数で書く。
+ * ****************************************************************************/
+uint8_t mtk_fmt_udec(char *buf, uint8_t size, uint32_t value, uint8_t width, bool left) {
+    char    digits[MTK_FMT_DIGITS_MAX];
+    uint8_t count = 0;
+
+    do {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    return fmt_number(buf, size, digits, count, false, width, left);
+}
+
+
+/****************************************************************************
+ * mtk_fmt_dec
+ *
+ * 符号付き整数を10進数で書く。
+ * ****************************************************************************/
+uint8_t mtk_fmt_dec(char *buf, uint8_t size, int32_t value, uint8_t width, bool left) {
+    char     digits[MTK_FMT_DIGITS_MAX];
+    uint8_t  count     = 0;
+    bool     negative  = value < 0;
+    uint32_t magnitude = negative ? 0u - (uint32_t)value : (uint32_t)value;
+
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    return fmt_number(buf, size, digits, count, negative, width, left);
+}
+
+
+/****************************************************************************
+ * mtk_fmt_hex
+ *
+ * 符号なし整数を小文字の16進数で、digits 桁に0埋めして書く（桁が多い場合は全桁を書く）。
+ * ****************************************************************************/
+uint8_t mtk_fmt_hex(char *buf, uint8_t size, uint32_t value, uint8_t digits) {
+    static const char hex[] = "0123456789abcdef";
+    char              nibbles[8];
+    uint8_t           count = 0;
+
+    do {
+        nibbles[count++] = hex[value & 0xF];
+        value >>= 4;
+    } while (value);
+    while (count < digits && count < sizeof(nibbles)) {
+        nibbles[count++] = '0';
+    }
+    return fmt_number(buf, size, nibbles, count, false, 0, false);
+}
@@ -0,0 +1,31 @@
+/*
+ * mtk_fmt.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * OLED 表示用の整数の書式化（snprintf の代わり）。
+ * 10進数（幅と左寄せ・右寄せの指定）と16進数（0埋め）を、呼び出し元のバッファに直接書く。
+ * 結果は同じ指定の snprintf と同じで、バッファに入らない分は切り捨てて必ず終端文字を書く。
+ * 各関数は書いた文字数（終端文字を除く）を返すので、続けて書く場合は buf と size をずらして呼ぶ。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// 文字列（"%s"）
+uint8_t mtk_fmt_str(char *buf, uint8_t size, const char *str);
+
+// 符号付き10進数（"%3d"・"%-3d"、width = 0 は幅の指定なし）
+uint8_t mtk_fmt_dec(char *buf, uint8_t size, int32_t value, uint8_t width, bool left);
+
+// 符号なし10進数（"%5lu" など）
+uint8_t mtk_fmt_udec(char *buf, uint8_t size, uint32_t value, uint8_t width, bool left);
+
+// 16進数（"%04x"、小文字で digits 桁に0埋め）
+uint8_t mtk_fmt_hex(char *buf, uint8_t size, uint32_t value, uint8_t digits);
@@ -0,0 +1,137 @@
+/*
+ * mtk_latency.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * メインループの時間とキー入力からレポート送信までの時間の計測（フォーマットは mtk_latency.h を参照）。
+ *
+ * キーの変化はスキャン（matrix_scan_kb）の直後に処理され、通常のキーは process_record の中で
+ * レポートを送るので、post_process_record_kb の時点をレポートの送信時刻とみなす。
+ * タップ/ホールドなどで処理が後になったキーは、キーイベントの時刻（ミリ秒）から求める。
+ * スレーブ側のキーは、マスターのスキャンで変化が見えてからの時間になる。
+ */
+
+#include "quantum.h"
+#include <string.h>
+#include "mtk_latency.h"
+#include "mtk_matrix.h"
+#include "mtk_oled.h"
+#include "mtk64erp.h"
+
+static const uint16_t latency_bounds[] = MTK_LATENCY_BOUNDS_US;
+
+_Static_assert(sizeof(latency_bounds) / sizeof(latency_bounds[0]) == MTK_LATENCY_BUCKETS - 1, "MTK_LATENCY_BUCKETS must be the number of bounds + 1");
+
+static mtk_latency_stats_t latency_stats = {0};
+static uint32_t            last_scan_us  = 0;  // 前回のスキャンの時刻（マイクロ秒）
+static uint16_t            loop_max_us   = 0;  // 集計中の区間のループ時間の最大
+static uint32_t            loop_start    = 0;  // 集計区間の開始時刻（ミリ秒）
+
+
+/****************************************************************************
+ * mtk_latency_scan
+ *
+ * スキャンの時刻を記録し、前回のスキャンからの時間をループ時間として最大値を取る。
+ * 1秒ごとに直前の1秒間の最大値を確定する。
+ * ****************************************************************************/
+void mtk_latency_scan(void) {
+    uint32_t now  = mtk_timer_read_us();
+    uint32_t loop = last_scan_us ? now - last_scan_us : 0;  // 最初のスキャンは初期化の時間を含むので数えない
+    last_scan_us  = now;
+
+    loop          = loop > UINT16_MAX ? UINT16_MAX : loop;
+    loop_max_us   = loop > loop_max_us ? loop : loop_max_us;
+
+    if (timer_elapsed32(loop_start) >= 1000) {
+        latency_stats.loop_max_us  = loop_max_us;
+        latency_stats.loop_peak_us = loop_max_us > latency_stats.loop_peak_us ? loop_max_us : latency_stats.loop_peak_us;
+        loop_max_us                = 0;
+        loop_start                 = timer_read32();
+    }
+}
+
+
+/****************************************************************************
+ * mtk_latency_record
+ *
+ * キーの押下と離しの処理が終わったところで、変化を検出したスキャンからの時間を
+ * ヒストグラムに記録する。
+ * ****************************************************************************/
+void mtk_latency_record(keyrecord_t *record) {
+    if (!IS_EVENT(record->event)) {
+        return;
+    }
+
+    uint16_t age_ms  = timer_elapsed(record->event.time);
+    uint32_t latency = age_ms > 1 ? (uint32_t)age_ms * 1000 : mtk_timer_read_us() - last_scan_us;
+
+    uint8_t bucket = 0;
+    while (bucket < MTK_LATENCY_BUCKETS - 1 && latency >= latency_bounds[bucket]) {
+        bucket++;
+    }
+    latency_stats.histogram[bucket]++;
+    latency_stats.keys++;
+    latency_stats.latency_sum_us += latency;
+}
+
+
+/****************************************************************************
+ * mtk_latency_get_stats
+ *
+ * ループ時間とキー入力からレポートまでの時間の統計を取得する。
+ * ****************************************************************************/
+void mtk_latency_get_stats(mtk_latency_stats_t *stats) {
+    *stats = latency_stats;
+}
+
+
+/****************************************************************************
+ * mtk_latency_hid_command
+ *
+ * raw HID で受け取った計測のコマンドを処理し、応答を data に書き込む。
+ *   data[1] = 0x00: 概要 → data[2..3]: 毎秒スキャン回数, data[4..5]: 直前の1秒間のループ時間の最大（us）,
+ *                          data[6..7]: 起動からのループ時間の最大（us）, data[8..11]: キー入力の数,
+ *                          data[12..13]: キー入力からレポートまでの平均（us）,
+ *                          data[14..15]: OLED に毎秒描画した行数, data[16..19]: 同じくバイト数,
+ *                          data[20..21]: OLED の転送で待たされた時間の最大（us）、いずれもリトルエンディアン
+ *   data[1] = 0x01: 統計のクリア
+ *   data[1] = 0x02: ヒストグラム → data[2]: 区間の数, data[3..]: 区間ごとの数（uint32）
+ * ****************************************************************************/
+bool mtk_latency_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 3 + MTK_LATENCY_BUCKETS * 4 || data[0] != MTK_LATENCY_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case 0x00: {
+            uint16_t scans = mtk_matrix_get_scan_rate();
+            uint32_t avg   = latency_stats.keys ? latency_stats.latency_sum_us / latency_stats.keys : 0;
+            uint16_t avg16 = avg > UINT16_MAX ? UINT16_MAX : avg;
+            memcpy(&data[2], &scans, 2);
+            memcpy(&data[4], &latency_stats.loop_max_us, 2);
+            memcpy(&data[6], &latency_stats.loop_peak_us, 2);
+            memcpy(&data[8], &latency_stats.keys, 4);
+            memcpy(&data[12], &avg16, 2);
+            uint16_t rows;
+            uint32_t bytes;
+            mtk_get_oled_render_rate(&rows, &bytes);
+            memcpy(&data[14], &rows, 2);
+            memcpy(&data[16], &bytes, 4);
+            mtk_oled_stats_t oled;
+            mtk_oled_get_stats(&oled);
+            memcpy(&data[20], &oled.stall_max_us, 2);
+            break;
+        }
+        case 0x01:
+            latency_stats = (mtk_latency_stats_t){0};
+            break;
+        case 0x02:
+            data[2] = MTK_LATENCY_BUCKETS;
+            memcpy(&data[3], latency_stats.histogram, sizeof(latency_stats.histogram));
+            break;
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
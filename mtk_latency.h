@@ -0,0 +1,62 @@
+/*
+ * mtk_latency.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * メインループの時間とキー入力からレポート送信までの時間の計測。
+ * OLED・RGB・トラックボールの処理を含めた実際のループ時間と、
+ * キーの変化を検出したスキャンから HID レポートを送るまでの時間のヒストグラムを記録する。
+ *
+ * ■raw HID コマンド（data[0] = MTK_LATENCY_HID_ID、data[1] = サブコマンド）
+ *   0x00 概要     → data[2..3]: 毎秒スキャン回数, data[4..5]: 直前の1秒間のループ時間の最大（us）,
+ *                   data[6..7]: 起動からのループ時間の最大（us）, data[8..11]: 計測したキー入力の数,
+ *                   data[12..13]: キー入力からレポートまでの平均（us）,
+ *                   data[14..15]: OLED に毎秒描画した行数, data[16..19]: 同じくバイト数,
+ *                   data[20..21]: 直前の1秒間に OLED の転送で待たされた時間の最大（us）
+ *   0x01 統計のクリア
+ *   0x02 ヒストグラム → data[2]: 区間の数, data[3..]: 区間ごとの数（uint32）
+ *   区間の境界は MTK_LATENCY_BOUNDS_US（最後の区間はそれ以上）。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "action.h"             // keyrecord_t
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#define MTK_LATENCY_BOUNDS_US   { 100, 250, 500, 1000, 2000, 5000 }  // ヒストグラムの区間の境界（マイクロ秒）
+#define MTK_LATENCY_BUCKETS     7                                    // ヒストグラムの区間の数
+
+#define MTK_LATENCY_HID_ID      0xE4  // raw HID のコマンドID
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+typedef struct {
+    uint16_t loop_max_us;                       // 直前の1秒間のループ時間の最大（マイクロ秒）
+    uint16_t loop_peak_us;                      // 起動（クリア）からのループ時間の最大
+    uint32_t keys;                              // 計測したキー入力の数
+    uint32_t latency_sum_us;                    // キー入力からレポートまでの時間の合計
+    uint32_t histogram[MTK_LATENCY_BUCKETS];    // キー入力からレポートまでの時間のヒストグラム
+} mtk_latency_stats_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// スキャンごとの記録（matrix_scan_kb から呼ぶ）
+void mtk_latency_scan(void);
+
+// キー入力の処理後の記録（post_process_record_kb から呼ぶ）
+void mtk_latency_record(keyrecord_t *record);
+
+// 統計の取得
+void mtk_latency_get_stats(mtk_latency_stats_t *stats);
+
+// raw HID のコマンド処理（MTK_LATENCY_HID_ID 以外は false を返す）
+bool mtk_latency_hid_command(uint8_t *data, uint8_t length);
@@ -0,0 +1,157 @@
+/*
+ * mtk_matrix.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * キーマトリクスのスキャン（構成は mtk_matrix.h を参照）。
+ *
+ * ■スキャンの手順
+ * 初期化で全ピンをプルアップ付きの入力にし、出力値を Low にしておく。
+ * 行の選択は出力の有効化（GPIO_OE_SET）だけで行い、ダイオードは COL2ROW なので
+ * 押されているキーの列のピンが Low になる。入力レジスタ（GPIO_IN）を1回読み、
+ * Low のピンから行のビット列を作る。押されたキーがない行は変換を省く。
+ */
+
+#include "quantum.h"
+#include "matrix.h"
+#include "mtk_matrix.h"
+#include "mtk64erp.h"
+
+#define RP_REG(addr)              (*(volatile uint32_t *)(addr))
+#define RP_SIO_BASE               0xD0000000
+#define RP_SIO_GPIO_IN            RP_REG(RP_SIO_BASE + 0x04)
+#define RP_SIO_GPIO_OUT_CLR       RP_REG(RP_SIO_BASE + 0x18)
+#define RP_SIO_GPIO_OE_SET        RP_REG(RP_SIO_BASE + 0x24)
+#define RP_SIO_GPIO_OE_CLR        RP_REG(RP_SIO_BASE + 0x28)
+
+static const pin_t matrix_pins[] = MTK_MATRIX_PINS;
+
+_Static_assert(sizeof(matrix_pins) / sizeof(matrix_pins[0]) == MATRIX_COLS, "MTK_MATRIX_PINS must have MATRIX_COLS pins");
+_Static_assert(MATRIX_ROWS / 2 == MATRIX_COLS, "rows and columns share the same pins");
+
+static uint32_t pin_bits[MATRIX_COLS];  // ピンごとの GPIO レジスタのビット
+static uint32_t pin_mask = 0;           // 全ピンのビット
+
+// スキャンの統計（1秒ごとに区切る）
+static uint32_t scan_start    = 0;  // 集計区間の開始時刻（ミリ秒）
+static uint32_t scan_count    = 0;  // 集計中の区間のスキャン回数
+static uint32_t scan_us_sum   = 0;  // 集計中の区間のスキャン時間の合計
+static uint16_t scan_us_max   = 0;  // 集計中の区間のスキャン時間の最大
+static uint32_t scan_timed    = 0;  // 集計中の区間で時間を測ったスキャン回数
+static uint16_t scan_rate     = 0;  // 直前の1秒間のスキャン回数
+static uint16_t scan_time_avg = 0;  // 直前の1秒間のスキャン時間の平均
+static uint16_t scan_time_max = 0;  // 直前の1秒間のスキャン時間の最大
+
+
+/****************************************************************************
+ * matrix_init_custom
+ *
+ * 全ピンをプルアップ付きの入力にし、出力したときの値を Low にしておく。
+ * ****************************************************************************/
+void matrix_init_custom(void) {
+    for (uint8_t i = 0; i < MATRIX_COLS; i++) {
+        gpio_set_pin_input_high(matrix_pins[i]);
+        pin_bits[i] = 1u << (matrix_pins[i] & 0x1F);
+        pin_mask |= pin_bits[i];
+    }
+    RP_SIO_GPIO_OUT_CLR = pin_mask;
+}
+
+
+/****************************************************************************
+ * matrix_settle
+ *
+ * 選択を解除したピンと押されたキーの列が High に戻るまで待つ。
+ * 固定の待ち時間の代わりに入力レジスタを見て、戻ったらすぐに抜ける。
+ * ****************************************************************************/
+static inline void matrix_settle(void) {
+    uint32_t start = mtk_timer_read_us();
+    while ((RP_SIO_GPIO_IN & pin_mask) != pin_mask) {
+        if (mtk_timer_read_us() - start >= MTK_MATRIX_SETTLE_TIMEOUT_US) {
+            break;
+        }
+    }
+}
+
+
+/****************************************************************************
+ * matrix_scan_custom
+ *
+ * 片手分（MATRIX_COLS 行）をスキャンする。1行ごとにピンを1本 Low に駆動し、
+ * 入力レジスタを1回読んで、Low になっている他のピンを押されたキーとする。
+ * ****************************************************************************/
+bool matrix_scan_custom(matrix_row_t current_matrix[]) {
+    uint32_t start   = mtk_timer_read_us();
+    bool     changed = false;
+
+    for (uint8_t row = 0; row < MATRIX_COLS; row++) {
+        const uint32_t row_bit = pin_bits[row];
+
+        RP_SIO_GPIO_OE_SET = row_bit;                          // 行を Low に駆動
+        waitInputPinDelay();
+        uint32_t low = ~RP_SIO_GPIO_IN & pin_mask & ~row_bit;  // Low の列（駆動中のピンを除く）
+        RP_SIO_GPIO_OE_CLR = row_bit;                          // 選択を解除
+
+        matrix_row_t cols = 0;
+        if (low) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                if (low & pin_bits[col]) {
+                    cols |= MATRIX_ROW_SHIFTER << col;
+                }
+            }
+        }
+        if (current_matrix[row] != cols) {
+            current_matrix[row] = cols;
+            changed             = true;
+        }
+        matrix_settle();
+    }
+
+    uint32_t elapsed = mtk_timer_read_us() - start;
+    scan_us_sum += elapsed;
+    scan_us_max = elapsed > scan_us_max ? (elapsed > UINT16_MAX ? UINT16_MAX : elapsed) : scan_us_max;
+    scan_timed++;
+    return changed;
+}
+
+
+/****************************************************************************
+ * mtk_matrix_count_scan
+ *
+ * スキャン回数を数え、1秒ごとに毎秒の値とスキャン時間の平均・最大を記録する。
+ * ****************************************************************************/
+void mtk_matrix_count_scan(void) {
+    scan_count++;
+    if (timer_elapsed32(scan_start) < 1000) {
+        return;
+    }
+    scan_rate     = scan_count > UINT16_MAX ? UINT16_MAX : scan_count;
+    scan_time_avg = scan_timed ? scan_us_sum / scan_timed : 0;
+    scan_time_max = scan_us_max;
+    scan_count    = 0;
+    scan_us_sum   = 0;
+    scan_us_max   = 0;
+    scan_timed    = 0;
+    scan_start    = timer_read32();
+}
+
+
+/****************************************************************************
+ * mtk_matrix_get_scan_rate
+ *
+ * 直前の1秒間のスキャン回数を取得する。
+ * ****************************************************************************/
+uint16_t mtk_matrix_get_scan_rate(void) {
+    return scan_rate;
+}
+
+
+/****************************************************************************
+ * mtk_matrix_get_scan_time
+ *
+ * 直前の1秒間の1回のスキャン時間の平均（max = false）または最大（max = true）を取得する。
+ * 標準のスキャナを使っている場合は 0 になる。
+ * ****************************************************************************/
+uint16_t mtk_matrix_get_scan_time(bool max) {
+    return max ? scan_time_max : scan_time_avg;
+}
@@ -0,0 +1,41 @@
+/*
+ * mtk_matrix.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * キーマトリクスのスキャン（CUSTOM_MATRIX = lite）。
+ * mtk64erp は行と列に同じ7本のピンを使う（keyboard.json の matrix_pins、対角は matrix_mask で除く）。
+ * 1本のピンを Low に駆動し、残りのピンを GPIO の入力レジスタ1回の読み取りでまとめて読む。
+ * 選択の解除後は固定の待ち時間ではなく、全ピンが High に戻ったらすぐ次の行に進む。
+ * スキャン回数は標準のスキャナでも数えられるよう matrix_scan_kb から数える。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#ifndef MTK_MATRIX_PINS
+#    define MTK_MATRIX_PINS  { GP28, GP27, GP26, GP22, GP20, GP23, GP21 }  // 行と列で共有するピン（keyboard.json と同じ順）
+#endif
+
+#ifndef MTK_MATRIX_SETTLE_TIMEOUT_US
+#    define MTK_MATRIX_SETTLE_TIMEOUT_US  30  // 選択の解除後、全ピンが High に戻るのを待つ最大時間（マイクロ秒）
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// スキャン回数の記録（matrix_scan_kb から呼ぶ）
+void mtk_matrix_count_scan(void);
+
+// 直前の1秒間のスキャン回数
+uint16_t mtk_matrix_get_scan_rate(void);
+
+// 直前の1秒間の1回のスキャンにかかった時間の平均と最大（マイクロ秒、このスキャナを使う場合）
+uint16_t mtk_matrix_get_scan_time(bool max);
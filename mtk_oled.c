@@ -0,0 +1,418 @@
+/*
+ * mtk_oled.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * SSD1306 への転送（構成は mtk_oled.h を参照）。
+ *
+ * ■転送の手順
+ * I2C1 をレジスタで直接操作し、割り込みは使わない。送る内容は IC_DATA_CMD に書く形式
+ * （下位8ビットがデータ、最後のバイトに STOP）で転送用のバッファに写し、DMA が TX FIFO の空きに
+ * 合わせて書き込む。DMA が書き終えた時点でバッファは空くので、次の転送はすぐに始めてよい
+ * （FIFO に残った前の転送が STOP を出した後、次の START が出る）。
+ * 転送の完了は DMA の BUSY ビットで確認し、待っている転送の開始は送信の呼び出しと
+ * mtk_oled_task で行う。
+ *
+ * QMK のコマンドの配列は先頭に制御バイト（0x00）を含むのでそのまま送り、
+ * データには制御バイト（0x40）を付けて送る。
+ *
+ * フレームの転送量は、前のフレームの区切りからの転送回数とバイト数の差で求める。
+ * QMK は変更のあったブロックを複数回の oled_task に分けて送るので、
+ * あるフレームの転送量には前のフレームの残りが含まれることがある。
+ */
+
+#include "quantum.h"
+#include <string.h>
+#include "mtk_oled.h"
+#include "mtk64erp.h"
+
+static mtk_oled_stats_t oled_stats = {0};
+static uint32_t         frame_transfers = 0;  // 前のフレームの区切りでの転送回数
+static uint32_t         frame_bytes     = 0;  // 同じくバイト数
+
+#if defined(OLED_ENABLE) && defined(OLED_TRANSPORT_CUSTOM)
+
+#define MTK_OLED_XFER_MAX         (OLED_BLOCK_SIZE + 1)  // 1回の転送の最大バイト数（制御バイト + 1ブロック）
+
+#define SSD1306_CONTROL_DATA      0x40  // 制御バイト: 以降はデータ
+
+
+//////////////////////////////////////////////////////////////////////////////
+// RP2040 のレジスタ
+
+#define RP_REG(addr)              (*(volatile uint32_t *)(addr))
+#define RP_CLR_ALIAS              0x3000                    // アトミックなビットクリア
+
+#define RP_RESETS_BASE            0x4000C000
+#define RP_RESETS_RESET_CLR       RP_REG(RP_RESETS_BASE + RP_CLR_ALIAS + 0x00)
+#define RP_RESETS_DONE            RP_REG(RP_RESETS_BASE + 0x08)
+#define RP_RESETS_I2C1            (1u << 4)
+
+#define RP_I2C1_BASE              0x40048000
+#define RP_IC_CON                 RP_REG(RP_I2C1_BASE + 0x00)
+#define RP_IC_TAR                 RP_REG(RP_I2C1_BASE + 0x04)
+#define RP_IC_DATA_CMD            RP_REG(RP_I2C1_BASE + 0x10)
+#define RP_IC_FS_SCL_HCNT         RP_REG(RP_I2C1_BASE + 0x1C)
+#define RP_IC_FS_SCL_LCNT         RP_REG(RP_I2C1_BASE + 0x20)
+#define RP_IC_INTR_MASK           RP_REG(RP_I2C1_BASE + 0x30)
+#define RP_IC_RAW_INTR_STAT       RP_REG(RP_I2C1_BASE + 0x34)
+#define RP_IC_CLR_TX_ABRT         RP_REG(RP_I2C1_BASE + 0x54)
+#define RP_IC_ENABLE              RP_REG(RP_I2C1_BASE + 0x6C)
+#define RP_IC_STATUS              RP_REG(RP_I2C1_BASE + 0x70)
+#define RP_IC_SDA_HOLD            RP_REG(RP_I2C1_BASE + 0x7C)
+#define RP_IC_DMA_CR              RP_REG(RP_I2C1_BASE + 0x88)
+#define RP_IC_DMA_TDLR            RP_REG(RP_I2C1_BASE + 0x8C)
+#define RP_IC_FS_SPKLEN           RP_REG(RP_I2C1_BASE + 0xA0)
+#define RP_IC_CON_MASTER          (1u << 0)
+#define RP_IC_CON_SPEED_FAST      (2u << 1)
+#define RP_IC_CON_RESTART_EN      (1u << 5)
+#define RP_IC_CON_SLAVE_DISABLE   (1u << 6)
+#define RP_IC_CON_TX_EMPTY_CTRL   (1u << 8)
+#define RP_IC_DATA_CMD_STOP       (1u << 9)
+#define RP_IC_INTR_TX_ABRT        (1u << 6)
+#define RP_IC_ENABLE_ENABLE       (1u << 0)
+#define RP_IC_ENABLE_ABORT        (1u << 1)
+#define RP_IC_STATUS_TFE          (1u << 2)
+#define RP_IC_STATUS_MST_ACTIVITY (1u << 5)
+#define RP_IC_DMA_CR_TDMAE        (1u << 1)
+
+#define RP_DMA_BASE               0x50000000
+#define RP_DMA_READ_ADDR(ch)      RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x00)
+#define RP_DMA_WRITE_ADDR(ch)     RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x04)
+#define RP_DMA_TRANS_COUNT(ch)    RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x08)
+#define RP_DMA_CTRL_TRIG(ch)      RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x0C)
+#define RP_DMA_CHAN_ABORT         RP_REG(RP_DMA_BASE + 0x444)
+#define RP_DMA_CTRL_EN            (1u << 0)
+#define RP_DMA_CTRL_SIZE_HALFWORD (1u << 2)
+#define RP_DMA_CTRL_INCR_READ     (1u << 4)
+#define RP_DMA_CTRL_CHAIN_TO(ch)  ((uint32_t)(ch) << 11)   // 自分自身を指定するとチェーンしない
+#define RP_DMA_CTRL_TREQ(dreq)    ((uint32_t)(dreq) << 15)
+#define RP_DMA_CTRL_IRQ_QUIET     (1u << 21)
+#define RP_DMA_CTRL_BUSY          (1u << 24)
+#define RP_DREQ_I2C1_TX           34
+
+#define OLED_I2C_PAL_MODE         (PAL_MODE_ALTERNATE_I2C | PAL_RP_PAD_SLEWFAST | PAL_RP_PAD_PUE | PAL_RP_PAD_DRIVE4)
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 転送用のバッファ（リング、oled_xfer_tail が転送中または次に転送する）
+
+static uint16_t oled_xfer_buf[MTK_OLED_XFER_SLOTS][MTK_OLED_XFER_MAX];  // IC_DATA_CMD に書く値
+static uint16_t oled_xfer_len[MTK_OLED_XFER_SLOTS];
+static uint8_t  oled_xfer_head  = 0;      // 次に書き込むバッファ
+static uint8_t  oled_xfer_tail  = 0;      // 最も古いバッファ
+static bool     oled_xfer_busy  = false;  // oled_xfer_tail を転送中
+static uint32_t oled_xfer_start = 0;      // 転送を始めた時刻（マイクロ秒）
+static uint8_t  oled_dma        = 0;      // 送信用DMAチャネル
+static bool     oled_ready      = false;  // I2C1 と DMA の初期化済み
+
+// 待ち時間の統計（1秒ごとに区切る）
+static uint32_t oled_stall_start  = 0;    // 集計区間の開始時刻（ミリ秒）
+static uint16_t oled_stall_max_us = 0;    // 集計中の区間の最大
+
+_Static_assert((MTK_OLED_XFER_SLOTS & (MTK_OLED_XFER_SLOTS - 1)) == 0, "MTK_OLED_XFER_SLOTS must be a power of two");
+
+
+/****************************************************************************
+ * oled_i2c_init
+ *
+ * I2C1 をリセットから戻し、F_SCL のファストモードのマスターとして設定する。
+ * 割り込みは使わず、送信は DMA の要求（TX FIFO の空き）で行う。
+ * ****************************************************************************/
+static void oled_i2c_init(void) {
+    RP_RESETS_RESET_CLR = RP_RESETS_I2C1;
+    while (!(RP_RESETS_DONE & RP_RESETS_I2C1)) {
+    }
+
+    // ボーレートの設定（Low 60%・High 40%、SDA のホールド時間 300ns）
+    const uint32_t freq   = hal_lld_get_clock(clk_sys);
+    const uint32_t period = (freq + F_SCL / 2) / F_SCL;
+    const uint32_t lcnt   = period * 3 / 5;
+    const uint32_t hcnt   = period - lcnt;
+
+    RP_IC_ENABLE      = 0;
+    RP_IC_CON         = RP_IC_CON_MASTER | RP_IC_CON_SPEED_FAST | RP_IC_CON_RESTART_EN | RP_IC_CON_SLAVE_DISABLE | RP_IC_CON_TX_EMPTY_CTRL;
+    RP_IC_TAR         = OLED_DISPLAY_ADDRESS;
+    RP_IC_FS_SCL_HCNT = hcnt;
+    RP_IC_FS_SCL_LCNT = lcnt;
+    RP_IC_FS_SPKLEN   = lcnt < 16 ? 1 : lcnt / 16;
+    RP_IC_SDA_HOLD    = freq * 3 / 10000000 + 1;
+    RP_IC_INTR_MASK   = 0;
+    RP_IC_DMA_TDLR    = 4;
+    RP_IC_DMA_CR      = RP_IC_DMA_CR_TDMAE;
+    RP_IC_ENABLE      = RP_IC_ENABLE_ENABLE;
+
+    palSetLineMode(I2C1_SCL_PIN, OLED_I2C_PAL_MODE);
+    palSetLineMode(I2C1_SDA_PIN, OLED_I2C_PAL_MODE);
+}
+
+
+/****************************************************************************
+ * oled_xfer_abort
+ *
+ * 転送中の DMA とバスの転送を中断し、転送中のバッファを捨てる。
+ * ****************************************************************************/
+static void oled_xfer_abort(void) {
+    RP_DMA_CHAN_ABORT = 1u << oled_dma;
+    while (RP_DMA_CHAN_ABORT & (1u << oled_dma)) {
+    }
+    if (!(RP_IC_RAW_INTR_STAT & RP_IC_INTR_TX_ABRT)) {
+        RP_IC_ENABLE = RP_IC_ENABLE_ENABLE | RP_IC_ENABLE_ABORT;  // STOP を出して FIFO を捨てる
+        uint32_t start = mtk_timer_read_us();
+        while ((RP_IC_ENABLE & RP_IC_ENABLE_ABORT) && mtk_timer_read_us() - start < MTK_OLED_TIMEOUT_US) {
+        }
+    }
+    (void)RP_IC_CLR_TX_ABRT;  // 読むと FIFO の保持が解除される
+    oled_stats.errors++;
+    if (oled_xfer_busy) {
+        oled_xfer_tail++;
+        oled_xfer_busy = false;
+    }
+}
+
+
+/****************************************************************************
+ * oled_xfer_poll
+ *
+ * 転送中のバッファの完了を確認し、待っているバッファがあれば転送を始める。
+ * NACK で中断された場合とタイムアウトした場合はそのバッファを捨てる。
+ * ****************************************************************************/
+static void oled_xfer_poll(void) {
+    if (RP_IC_RAW_INTR_STAT & RP_IC_INTR_TX_ABRT) {
+        oled_xfer_abort();
+    } else if (oled_xfer_busy) {
+        if (RP_DMA_CTRL_TRIG(oled_dma) & RP_DMA_CTRL_BUSY) {
+            if (mtk_timer_read_us() - oled_xfer_start >= MTK_OLED_TIMEOUT_US) {
+                oled_xfer_abort();
+            }
+            return;
+        }
+        oled_xfer_tail++;
+        oled_xfer_busy = false;
+    }
+
+    if (oled_xfer_head == oled_xfer_tail) {
+        return;
+    }
+    const uint8_t slot = oled_xfer_tail & (MTK_OLED_XFER_SLOTS - 1);
+    oled_xfer_busy     = true;
+    oled_xfer_start    = mtk_timer_read_us();
+    oled_stats.transfers++;
+    oled_stats.bytes += oled_xfer_len[slot];
+
+    RP_DMA_READ_ADDR(oled_dma)   = (uint32_t)oled_xfer_buf[slot];
+    RP_DMA_WRITE_ADDR(oled_dma)  = (uint32_t)&RP_IC_DATA_CMD;
+    RP_DMA_TRANS_COUNT(oled_dma) = oled_xfer_len[slot];
+    RP_DMA_CTRL_TRIG(oled_dma)   = RP_DMA_CTRL_EN | RP_DMA_CTRL_IRQ_QUIET | RP_DMA_CTRL_SIZE_HALFWORD | RP_DMA_CTRL_INCR_READ
+                                 | RP_DMA_CTRL_CHAIN_TO(oled_dma) | RP_DMA_CTRL_TREQ(RP_DREQ_I2C1_TX);
+}
+
+
+/****************************************************************************
+ * oled_xfer_idle
+ *
+ * 全てのバッファを送り終え、バスも止まっているかを返す。
+ * ****************************************************************************/
+static bool oled_xfer_idle(void) {
+    oled_xfer_poll();
+    return oled_xfer_head == oled_xfer_tail && (RP_IC_STATUS & RP_IC_STATUS_TFE) && !(RP_IC_STATUS & RP_IC_STATUS_MST_ACTIVITY);
+}
+
+
+/****************************************************************************
+ * oled_xfer_send
+ *
+ * 1回の I2C の転送（制御バイト + 内容）を転送用のバッファに写して転送を依頼する。
+ * 空いているバッファがなければ空くまで待ち、送信の呼び出しにかかった時間を待ち時間として記録する。
+ * MTK_OLED_ASYNC が 0 の場合は転送が終わるまで待つ。
+ * @param control 先頭に付ける制御バイト（負の値は付けない）
+ * @param data    送る内容
+ * @param size    送る内容のバイト数
+ * @return        転送を依頼できた場合は true
+ * ****************************************************************************/
+static bool oled_xfer_send(int16_t control, const uint8_t *data, uint16_t size) {
+    const uint16_t len = size + (control >= 0 ? 1 : 0);
+    if (!oled_ready || size == 0 || len > MTK_OLED_XFER_MAX) {
+        return false;
+    }
+
+    const uint32_t start = mtk_timer_read_us();
+    oled_xfer_poll();
+    while ((uint8_t)(oled_xfer_head - oled_xfer_tail) >= MTK_OLED_XFER_SLOTS) {
+        oled_xfer_poll();
+    }
+
+    const uint8_t slot = oled_xfer_head & (MTK_OLED_XFER_SLOTS - 1);
+    uint16_t     *buf  = oled_xfer_buf[slot];
+    uint16_t      n    = 0;
+    if (control >= 0) {
+        buf[n++] = control;
+    }
+    for (uint16_t i = 0; i < size; i++) {
+        buf[n++] = data[i];
+    }
+    buf[n - 1] |= RP_IC_DATA_CMD_STOP;
+    oled_xfer_len[slot] = n;
+    oled_xfer_head++;
+    oled_xfer_poll();
+
+#if !MTK_OLED_ASYNC
+    while (!oled_xfer_idle()) {
+    }
+#endif
+
+    // 待ち時間の統計
+    uint32_t stall = mtk_timer_read_us() - start;
+    stall          = stall > UINT16_MAX ? UINT16_MAX : stall;
+    oled_stall_max_us = stall > oled_stall_max_us ? stall : oled_stall_max_us;
+    return true;
+}
+
+
+/****************************************************************************
+ * oled_driver_init
+ *
+ * QMK の oled_init から呼ばれる。I2C1 と DMA チャネルを初期化する。
+ * 向きの変更などで再び呼ばれた場合は、送信中の内容を送り終えてから戻る。
+ * ****************************************************************************/
+void oled_driver_init(void) {
+    if (oled_ready) {
+        uint32_t start = mtk_timer_read_us();
+        while (!oled_xfer_idle() && mtk_timer_read_us() - start < MTK_OLED_TIMEOUT_US * MTK_OLED_XFER_SLOTS) {
+        }
+        return;
+    }
+
+    osalSysLock();
+    const rp_dma_channel_t *tx = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, RP_DMA_PRIORITY_LOW, NULL, NULL);
+    osalSysUnlock();
+    if (tx == NULL) {
+        return;
+    }
+    oled_dma = tx->chnidx;
+    oled_i2c_init();
+    oled_stall_start = timer_read32();
+    oled_ready       = true;
+}
+
+
+/****************************************************************************
+ * oled_send_cmd / oled_send_data
+ *
+ * QMK の OLED ドライバからの送信。コマンドは先頭の制御バイトごとそのまま、
+ * データは制御バイト（0x40）を付けて送る。
+ * ****************************************************************************/
+bool oled_send_cmd(const uint8_t *data, uint16_t size) {
+    return oled_xfer_send(-1, data, size);
+}
+
+bool oled_send_cmd_P(const uint8_t *data, uint16_t size) {
+    return oled_send_cmd(data, size);
+}
+
+bool oled_send_data(const uint8_t *data, uint16_t size) {
+    return oled_xfer_send(SSD1306_CONTROL_DATA, data, size);
+}
+
+
+/****************************************************************************
+ * mtk_oled_task
+ *
+ * 待っている転送を始め、1秒ごとに待ち時間の最大値を記録する。
+ * ****************************************************************************/
+void mtk_oled_task(void) {
+    if (!oled_ready) {
+        return;
+    }
+    oled_xfer_poll();
+
+    if (timer_elapsed32(oled_stall_start) >= 1000) {
+        oled_stats.stall_max_us = oled_stall_max_us;
+        oled_stall_max_us       = 0;
+        oled_stall_start        = timer_read32();
+    }
+}
+
+#else
+
+void mtk_oled_task(void) {}
+
+#endif
+
+
+/****************************************************************************
+ * mtk_oled_frame
+ *
+ * フレームの区切り。前の区切りからの転送回数とバイト数を直前のフレームの転送量とする。
+ * ****************************************************************************/
+void mtk_oled_frame(void) {
+    uint32_t transfers = oled_stats.transfers - frame_transfers;
+    uint32_t bytes     = oled_stats.bytes - frame_bytes;
+    frame_transfers    = oled_stats.transfers;
+    frame_bytes        = oled_stats.bytes;
+
+    oled_stats.frame_transfers = transfers > UINT16_MAX ? UINT16_MAX : transfers;
+    oled_stats.frame_bytes     = bytes > UINT16_MAX ? UINT16_MAX : bytes;
+    oled_stats.frame_bytes_max = oled_stats.frame_bytes > oled_stats.frame_bytes_max ? oled_stats.frame_bytes : oled_stats.frame_bytes_max;
+}
+
+
+/****************************************************************************
+ * mtk_oled_get_stats
+ *
+ * 転送の統計（転送回数・バイト数・中断数・直前の1秒間の待ち時間の最大）を取得する。
+ * ****************************************************************************/
+void mtk_oled_get_stats(mtk_oled_stats_t *stats) {
+    *stats = oled_stats;
+}
+
+
+/****************************************************************************
+ * mtk_oled_hid_command
+ *
+ * raw HID で受け取った OLED のコマンドを処理し、応答を data に書き込む。
+ *   data[1] = 0x00: 転送の統計（形式は mtk_oled.h を参照）
+ *   data[1] = 0x01: 統計のクリア
+ *   data[1] = 0x02: フレームバッファの読み出し（data[2..3] の位置から入るだけ）
+ * ****************************************************************************/
+bool mtk_oled_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 24 || data[0] != MTK_OLED_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case 0x00: {
+            const uint16_t size = OLED_MATRIX_SIZE;
+            memcpy(&data[2], &oled_stats.frame_transfers, 2);
+            memcpy(&data[4], &oled_stats.frame_bytes, 2);
+            memcpy(&data[6], &oled_stats.frame_bytes_max, 2);
+            memcpy(&data[8], &oled_stats.transfers, 4);
+            memcpy(&data[12], &oled_stats.bytes, 4);
+            memcpy(&data[16], &oled_stats.errors, 4);
+            memcpy(&data[20], &oled_stats.stall_max_us, 2);
+            memcpy(&data[22], &size, 2);
+            break;
+        }
+        case 0x01:
+            oled_stats      = (mtk_oled_stats_t){0};
+            frame_transfers = 0;
+            frame_bytes     = 0;
+            break;
+        case 0x02: {
+            uint16_t offset;
+            memcpy(&offset, &data[2], 2);
+            oled_buffer_reader_t reader = oled_read_raw(offset);
+            uint8_t              count  = length - 5;
+            count                       = reader.remaining_element_count < count ? reader.remaining_element_count : count;
+            data[4]                     = count;
+            if (count) {
+                memcpy(&data[5], reader.current_element, count);
+            }
+            break;
+        }
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * mtk_oled.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * SSD1306 への転送（OLED_TRANSPORT = custom）。
+ * QMK の OLED ドライバは描画と変更のあったブロックの検出だけを行い、
+ * コマンドとデータの送信（oled_send_cmd / oled_send_data）をこのファイルで置き換える。
+ * 送る内容は転送用のバッファに写してから I2C1 に DMA で流すので、送信の呼び出しはすぐに戻り、
+ * 転送中もメインループ（マトリクスのスキャンやセンサーの処理）は止まらない。
+ * 描画用のフレームバッファ（QMK）と転送用のバッファが別なので、描画と転送が重なってもよい。
+ * 転送用のバッファが全て使用中のときだけ空くのを待ち、その時間を待ち時間として記録する。
+ *
+ * 描画の結果と転送の量は実機で raw HID から確認する。フレーム（oled_task_kb の1回の描画）ごとに
+ * 転送回数とバイト数を数え、フレームバッファの内容を読み出せる（ホスト側で画像にして比較する）。
+ *
+ * ■raw HID コマンド（data[0] = MTK_OLED_HID_ID、data[1] = サブコマンド）
+ *   0x00 転送の統計 → data[2..3]: 直前のフレームの転送回数, data[4..5]: 同じくバイト数,
+ *                     data[6..7]: フレームあたりのバイト数の最大, data[8..11]: 転送回数,
+ *                     data[12..15]: 転送バイト数, data[16..19]: 中断数, data[20..21]: 待ち時間の最大（us）,
+ *                     data[22..23]: フレームバッファのサイズ
+ *   0x01 統計のクリア
+ *   0x02 フレームバッファの読み出し → 要求 data[2..3]: 開始位置、応答 data[4]: バイト数, data[5..]: 内容
+ *   フレームバッファは QMK の OLED ドライバの配置（ページごとに横方向、1バイトが縦8ドット）。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#ifndef MTK_OLED_ASYNC
+#    define MTK_OLED_ASYNC        1     // 1: DMA で転送してすぐ戻る、0: 転送の完了まで待つ（比較用）
+#endif
+
+#ifndef MTK_OLED_XFER_SLOTS
+#    define MTK_OLED_XFER_SLOTS   4     // 転送用のバッファの数（ブロックのコマンドとデータで2つずつ、2ブロック分）
+#endif
+
+#ifndef MTK_OLED_TIMEOUT_US
+#    define MTK_OLED_TIMEOUT_US   5000  // 1回の転送がこの時間で終わらなければ中断する（マイクロ秒）
+#endif
+
+#define MTK_OLED_HID_ID           0xE5  // raw HID のコマンドID
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+typedef struct {
+    uint32_t transfers;      // I2C の転送回数
+    uint32_t bytes;          // 転送バイト数（制御バイトを含む）
+    uint32_t errors;         // NACK やタイムアウトで中断した転送の数
+    uint16_t stall_max_us;   // 直前の1秒間に送信の呼び出しで待たされた時間の最大（マイクロ秒）
+    uint16_t frame_transfers;  // 直前のフレームの転送回数
+    uint16_t frame_bytes;      // 直前のフレームの転送バイト数
+    uint16_t frame_bytes_max;  // フレームあたりの転送バイト数の最大
+} mtk_oled_stats_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// 待っている転送の開始（housekeeping_task_kb から呼ぶ）
+void mtk_oled_task(void);
+
+// フレームの区切り（oled_task_kb で描画したときに呼ぶ）
+void mtk_oled_frame(void);
+
+// 転送の統計の取得
+void mtk_oled_get_stats(mtk_oled_stats_t *stats);
+
+// raw HID のコマンド処理（MTK_OLED_HID_ID 以外は false を返す）
+bool mtk_oled_hid_command(uint8_t *data, uint8_t length);
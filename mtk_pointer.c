@@ -0,0 +1,566 @@
+/*
+ * mtk_pointer.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールの移動量をマウスレポートに変換するポインタ処理。
+ * 状態はすべて mtk_pointer_t に持たせ、設定は mtk_pointer_config_t で受け取る。
+ */
+
+#include "mtk_pointer.h"
+#include "timer.h"              // タイマー管理ヘッダ
+#include <stdlib.h>             // abs
+#include <math.h>               // 数学関数ライブラリ（速度調整テーブルの計算のみ）
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 設定値
+
+#ifndef MTK_SCROLLBALL_INHIVITOR
+#    define MTK_SCROLLBALL_INHIVITOR     5    // スクロールボールの動き抑制値
+#endif
+
+#ifndef MTK_SCROLLSNAP_ENABLE
+#    define MTK_SCROLLSNAP_ENABLE        1    // スクロールスナップ機能の有効化
+#endif
+
+#ifndef MTK_SCROLLSNAP_RESET_TIMER
+#    define MTK_SCROLLSNAP_RESET_TIMER   100  // スクロールスナップのリセットタイマー値（ミリ秒）
+#endif
+
+#ifndef MTK_SCROLLSNAP_TENSION_THRESHOLD
+#    define MTK_SCROLLSNAP_TENSION_THRESHOLD 12   // スクロールスナップの張力閾値
+#endif
+
+#ifndef MTK_INERTIA_TICK_MS
+#    define MTK_INERTIA_TICK_MS          10   // 慣性スクロールの計算周期（ミリ秒）
+#endif
+
+#ifndef MTK_INERTIA_RELEASE_MS
+#    define MTK_INERTIA_RELEASE_MS       30   // ボールから指を離したと判定するまでの時間（ミリ秒）
+#endif
+
+#ifndef MTK_INERTIA_THRESHOLD
+#    define MTK_INERTIA_THRESHOLD        8    // 慣性スクロールを開始する最低速度（カウント/tick）
+#endif
+
+#define MTK_INERTIA_FRAC_BITS            4    // 慣性スクロール速度の小数部ビット数（Q4）
+
+// マウスレポートの移動量の範囲（MOUSE_EXTENDED_REPORT の場合は16ビット）
+#ifdef MOUSE_EXTENDED_REPORT
+#    define MTK_XY_REPORT_MAX            INT16_MAX
+#else
+#    define MTK_XY_REPORT_MAX            INT8_MAX
+#endif
+
+// ホイールの送信量の範囲（WHEEL_EXTENDED_REPORT の場合は16ビット）
+#ifdef WHEEL_EXTENDED_REPORT
+#    define MTK_HV_REPORT_MAX            INT16_MAX
+#else
+#    define MTK_HV_REPORT_MAX            INT8_MAX
+#endif
+
+#ifndef MTK_MOTION_CARRY_REPORTS
+#    define MTK_MOTION_CARRY_REPORTS     64   // 繰り越せる移動量の上限（最大レポート何回分か）
+#endif
+
+#define XSCALE_FACTOR                    1.0    // X方向のスケールファクター
+#define YSCALE_FACTOR                    1.0    // Y方向のスケールファクター
+
+
+/****************************************************************************
+ * constrain_hid
+ *
+ * マウスレポートで送れる範囲内に値を制限する。
+ * MOUSE_EXTENDED_REPORT の場合は -32767から32767、それ以外は -127から127。
+ * 入力値が範囲を超える場合は、それぞれの境界値に切り詰める。
+ * ****************************************************************************/
+static int16_t constrain_hid(int32_t value) {
+    if (value > MTK_XY_REPORT_MAX) {
+        return MTK_XY_REPORT_MAX;
+    } else if (value < -MTK_XY_REPORT_MAX) {
+        return -MTK_XY_REPORT_MAX;
+    }
+    return (int16_t)value;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 速度調整テーブル（固定小数点）
+//
+// 速度調整カーブ c * (|d| / c)^e （c = cpi / 20、e = speed_adjust_value / 10）を
+// |d| = 0〜512 の範囲で Q16 固定小数点のテーブルとして保持する。
+// テーブル範囲外の入力は上位9ビットで表引き・補間し、2^(n*e) を掛けて求める。
+// テーブルは CPI または速度調整値が変わったときだけ再計算する。
+// テーブルはセンサーごとの設定で使えるよう mtk_pointer_t に持つ（範囲の定義は mtk_pointer.h）。
+#define MTK_ACCEL_LUT_FRAC_BITS  16                                           // テーブルの小数部ビット数（Q16）
+#define MTK_ACCEL_FRAC_BITS      8                                            // 出力の小数部ビット数（Q8）
+#define MTK_ACCEL_POW2_BITS      16                                           // 2^(n*e) 係数の小数部ビット数（Q16）
+#define MTK_ACCEL_LUT_MAX        ((uint32_t)INT16_MAX << MTK_ACCEL_LUT_FRAC_BITS) // テーブル値の上限（Q16）
+
+
+/****************************************************************************
+ * accel_lut_update
+ *
+ * CPIと速度調整値から速度調整テーブルを再計算する。
+ * 浮動小数点演算はここでのみ行い、レポートごとの処理では使用しない。
+ * 基準値 c は従来の計算式と同じく cpi / 20 の整数除算で求める。
+ * ****************************************************************************/
+static void accel_lut_update(mtk_pointer_t *p, uint16_t cpi, uint8_t speed_adjust_value) {
+    float       e        = speed_adjust_value / 10.0f;
+    uint16_t    base     = cpi / 20 > 0 ? cpi / 20 : 1;
+    float       gain     = ((float)cpi / 20.0f) / powf((float)base, e);
+    const float scale[2] = {XSCALE_FACTOR, YSCALE_FACTOR};
+
+    for (uint8_t axis = 0; axis < 2; axis++) {
+        float k = gain / scale[axis] * (float)(1UL << MTK_ACCEL_LUT_FRAC_BITS);
+        for (uint16_t d = 0; d <= MTK_ACCEL_LUT_SIZE; d++) {
+            float v = powf((float)d, e) * k + 0.5f;
+            p->accel_lut[axis][d] = v >= (float)MTK_ACCEL_LUT_MAX ? MTK_ACCEL_LUT_MAX : (uint32_t)v;
+        }
+    }
+
+    for (uint8_t n = 0; n < MTK_ACCEL_OCTAVES; n++) {
+        p->accel_pow2[n] = (uint64_t)(exp2f(n * e) * (float)(1UL << MTK_ACCEL_POW2_BITS) + 0.5f);
+    }
+    p->accel_lut_cpi   = cpi;
+    p->accel_lut_speed = speed_adjust_value;
+}
+
+
+/****************************************************************************
+ * accel_apply
+ *
+ * 速度調整テーブルを使って1軸分の移動量を変換する（戻り値はQ8）。
+ * |delta| が512を超える場合は、上位9ビットでテーブルを引いて下位ビットで
+ * 線形補間し、切り捨てたビット数 n に応じて 2^(n*e) を掛ける。
+ * @param p     テーブルを持つポインタ処理の状態
+ * @param axis  0: X軸、1: Y軸
+ * @param delta センサーの移動量
+ * ****************************************************************************/
+static int32_t accel_apply(const mtk_pointer_t *p, uint8_t axis, int16_t delta) {
+    const uint8_t shift = MTK_ACCEL_LUT_FRAC_BITS - MTK_ACCEL_FRAC_BITS;
+    uint32_t      d     = delta < 0 ? -(int32_t)delta : delta;
+    uint32_t      out;
+
+    if (d <= MTK_ACCEL_LUT_SIZE) {
+        out = p->accel_lut[axis][d] >> shift;
+    } else {
+        uint8_t  n    = 32 - __builtin_clz(d) - MTK_ACCEL_LUT_BITS;
+        uint32_t m    = d >> n;
+        uint32_t frac = d & ((1UL << n) - 1);
+        uint64_t lo   = p->accel_lut[axis][m];
+        uint64_t v    = lo + (((p->accel_lut[axis][m + 1] - lo) * frac) >> n);
+        uint64_t s    = (v * p->accel_pow2[n]) >> (MTK_ACCEL_POW2_BITS + shift);
+        out = s > (MTK_ACCEL_LUT_MAX >> shift) ? (MTK_ACCEL_LUT_MAX >> shift) : (uint32_t)s;
+    }
+    return delta < 0 ? -(int32_t)out : (int32_t)out;
+}
+
+
+/****************************************************************************
+ * accel_round
+ *
+ * Q8の値を整数に丸める（roundf と同じく 0.5 はゼロから遠い方向へ）。
+ * ****************************************************************************/
+static inline int32_t accel_round(int32_t q) {
+    const int32_t half = 1 << (MTK_ACCEL_FRAC_BITS - 1);
+    return q >= 0 ? (q + half) >> MTK_ACCEL_FRAC_BITS : -((-q + half) >> MTK_ACCEL_FRAC_BITS);
+}
+
+
+/****************************************************************************
+ * motion_carry_apply
+ *
+ * 速度調整後の移動量（Q8）の端数を軸ごとに繰り越す。
+ * 1カウントに満たない動きも次のレポート以降に持ち越されるため、
+ * ゆっくりとした細かい動きが丸めで失われない。
+ * レポートの範囲（MTK_XY_REPORT_MAX）を超えた分も同様に繰り越し、
+ * 以降のレポートに分けて送るため、速いフリックでも移動量が失われない。
+ * 移動方向が反転した場合は、逆方向の繰り越しを持ち越さないよう破棄する。
+ * ****************************************************************************/
+static int32_t motion_carry_apply(mtk_pointer_t *p, uint8_t axis, int16_t delta, int32_t q) {
+    int8_t dir = (delta > 0) - (delta < 0);
+    if (dir != 0 && dir != p->carry_dir[axis]) {
+        p->carry[axis]     = 0;
+        p->carry_dir[axis] = dir;
+    }
+
+    // 繰り越しが際限なく溜まらないよう上限を設ける
+    const int32_t limit = (int32_t)MTK_XY_REPORT_MAX * MTK_MOTION_CARRY_REPORTS * (1 << MTK_ACCEL_FRAC_BITS);
+    p->carry[axis] += q;
+    if (p->carry[axis] > limit) {
+        p->carry[axis] = limit;
+    } else if (p->carry[axis] < -limit) {
+        p->carry[axis] = -limit;
+    }
+
+    int32_t out = constrain_hid(accel_round(p->carry[axis]));
+    p->carry[axis] -= out * (1 << MTK_ACCEL_FRAC_BITS);
+    return out;
+}
+
+
+/******************************************************************************
+ * Function: motion_to_mouse
+ * --------------------------------------------------------------------------
+ * トラックボールの移動量をマウスレポートに変換
+ * --------------------------------------------------------------------------
+ * トラックボールから取得した移動量（delta_x, delta_y）をCPIや速度調整設定を考慮して計算し、
+ * マウスレポート（x, y）に反映する。
+ * 計算は速度調整テーブル（accel_lut）を引くだけで行い、pow() などの浮動小数点演算は
+ * CPI または速度調整値が変わったときのテーブル再計算でのみ実行する。
+ * 1カウント未満の端数とレポートの範囲を超えた分は motion_carry で次のレポートへ繰り越す。
+ *
+ * ■パラメータ詳細
+ * 1. XSCALE_FACTOR および YSCALE_FACTOR
+ *    - 説明: XSCALE_FACTOR と YSCALE_FACTOR は、カーソルの最終的な動きをスケーリング
+ *            （倍率を掛ける）ためのパラメータです。これにより、トラックボールの動きが
+ *            カーソルの動きにどれだけ反映されるかを調整します。
+ *    - 設定方法: これらの値を「大きく」するとカーソルの移動が「遅く」なり、値を「小さく」
+ *                するとカーソルの移動が「速く」なります。
+ *    - 推奨設定: 非線形的な速度調整を目指す場合、1.0〜2.0 の範囲で微調整することで
+ *                直感的に扱いやすい速度にします。
+ *                非線形な速度を望むならば 1 前後に設定するのがよいです。過度に大きくすると
+ *                全体的な動きが抑制されすぎてしまう可能性があります。
+ *
+ * 2. cpi（カウント・パー・インチ）
+ *    - 説明: cpi は、トラックボールが動いた際に 1 インチあたりの検出される「移動単位」
+ *            を表します。cpi が高い場合、カーソルは敏感に反応し、小さな動きでも速く動きます。
+ *            cpi が低いと、カーソルの動きはゆっくりになります。
+ *    - 設定方法: 高い cpi を設定すると、トラックボールの小さな動きでもカーソルが敏感に
+ *                動きます。低い cpi を設定すると、トラックボールの動きがゆっくりと反映されます。
+ *    - 推奨設定: 非線形な動きを実現するため、cpi は 200～800 程度に設定します。この範囲で
+ *                トラックボールの精細な動きを反映しつつ、カーソルの過度な移動を防ぎます。
+ *
+ * 3. speed_adjust_value
+ *    - 説明: speed_adjust_value は、トラックボールの動きに対する加速度合いを設定します。
+ *            |d|^(speed_adjust_value / 10) の非線形な加速を実現するための重要なパラメータです。
+ *    - 設定方法: 値が 1.0 より小さいと全体的に「緩やかな移動」となり、1.0 より大きいと
+ *                「加速度的に速く」なります。
+ *    - 推奨設定: speed_adjust_value を 1.5～2.0 の範囲で調整し、ゆっくりとした動きと
+ *                加速的な動きのバランスを取ることが推奨されます。例えば 1.5 に設定すると
+ *                非線形のスムーズな動きを得られます。
+ *
+ * ■推奨設定
+ * - XSCALE_FACTOR および YSCALE_FACTOR: 1.0〜1.2（動きのスムーズさと制御性のバランス）
+ * - cpi: 400（小さな動きにも反応しやすく、適度な移動速度を実現）
+ * - speed_adjust_value: 1.5～2.0（小さな動きには細かく、大きな動きには加速度的に速くなる）
+ *
+ * ■戻り値
+ * - なし
+ *
+ * ■注意点
+ * トラックボールの速度調整は、パラメータの微調整に依存します。使用感に基づき、各値を試行錯誤しながら
+ * 最適な設定を見つけてください。
+ * ****************************************************************************/
+static void motion_to_mouse(mtk_pointer_t *p, const mtk_pointer_config_t *c, report_mouse_t *mouse_report, int16_t delta_x, int16_t delta_y) {
+    if (c->cpi != p->accel_lut_cpi || c->speed_adjust_value != p->accel_lut_speed) {
+        accel_lut_update(p, c->cpi, c->speed_adjust_value);
+    }
+
+    // 速度調整テーブルで変換（Q8）
+    int32_t x = accel_apply(p, 0, delta_x);
+    int32_t y = accel_apply(p, 1, delta_y);
+
+    // 元の移動量を加え、端数と範囲外の分を繰り越しつつ最終値をマウスレポートに反映
+    mouse_report->x = motion_carry_apply(p, 0, delta_x, delta_x * (1 << MTK_ACCEL_FRAC_BITS) + x);
+    mouse_report->y = motion_carry_apply(p, 1, delta_y, delta_y * (1 << MTK_ACCEL_FRAC_BITS) + y);
+}
+
+
+/****************************************************************************
+ * inertia
+ *
+ * スクロールモードの慣性（キネティック）スクロール。
+ * ボールを弾いて離すと、その速度で減衰しながらスクロールを続ける。
+ * 速度は inertia_x / inertia_y に Q4 固定小数点（カウント/tick）で保持し、
+ * MTK_INERTIA_TICK_MS ごとに inertia_friction / 256 倍に減衰させる。
+ * ボールが再び動いた場合やキーが押された場合は、すぐに慣性を止める。
+ * ****************************************************************************/
+void mtk_pointer_inertia_stop(mtk_pointer_t *p) {
+    p->inertia_coasting = false;
+    p->inertia_x        = 0;
+    p->inertia_y        = 0;
+    p->inertia_acc[0]   = 0;
+    p->inertia_acc[1]   = 0;
+    p->inertia_frac[0]  = 0;
+    p->inertia_frac[1]  = 0;
+}
+
+
+/****************************************************************************
+ * inertia_measure
+ *
+ * 1tick分の移動量から速度を更新する（直前の速度との平均）。
+ * ****************************************************************************/
+static int16_t inertia_measure(int16_t velocity, int16_t counts) {
+    int32_t v = ((int32_t)velocity + counts * (1 << MTK_INERTIA_FRAC_BITS)) / 2;
+    return v > INT16_MAX ? INT16_MAX : (v < -INT16_MAX ? -INT16_MAX : (int16_t)v);
+}
+
+
+/****************************************************************************
+ * inertia_coast
+ *
+ * 1tick分の慣性による移動量（カウント）を求め、速度を減衰させる。
+ * ****************************************************************************/
+static int16_t inertia_coast(int16_t *velocity, int16_t *frac, uint8_t friction) {
+    // 速度が INT16_MAX 近くでも端数を足してあふれないよう32ビットで計算する
+    int32_t q   = (int32_t)*frac + *velocity;
+    int32_t out = q / (1 << MTK_INERTIA_FRAC_BITS);
+    *frac       = (int16_t)(q - out * (1 << MTK_INERTIA_FRAC_BITS));
+    *velocity   = ((int32_t)*velocity * friction) / 256;
+    return out > INT16_MAX ? INT16_MAX : (out < -INT16_MAX ? -INT16_MAX : (int16_t)out);
+}
+
+
+/****************************************************************************
+ * inertia_task
+ *
+ * スクロールモードの移動量（h, v: カウント）から速度を計測し、
+ * ボールを離した後は慣性による移動量を h, v に加える。
+ * ****************************************************************************/
+static void inertia_task(mtk_pointer_t *p, const mtk_pointer_config_t *c, int16_t *h, int16_t *v) {
+    uint16_t now = timer_read();
+
+    if (*h != 0 || *v != 0) {
+        // ボールが動いたら慣性を止め、新しい動きの速度を計測する
+        p->inertia_coasting     = false;
+        p->inertia_acc[0]      += *h;
+        p->inertia_acc[1]      += *v;
+        p->inertia_last_motion  = now;
+    }
+
+    if (TIMER_DIFF_16(now, p->inertia_tick) < MTK_INERTIA_TICK_MS) {
+        return;
+    }
+    p->inertia_tick = now;
+
+    if (p->inertia_coasting) {
+        *h += inertia_coast(&p->inertia_x, &p->inertia_frac[0], c->inertia_friction);
+        *v += inertia_coast(&p->inertia_y, &p->inertia_frac[1], c->inertia_friction);
+
+        // 1カウント/tickを下回ったら終了
+        const int16_t min = 1 << MTK_INERTIA_FRAC_BITS;
+        if (abs(p->inertia_x) < min && abs(p->inertia_y) < min) {
+            mtk_pointer_inertia_stop(p);
+        }
+    } else if (p->inertia_acc[0] != 0 || p->inertia_acc[1] != 0) {
+        p->inertia_x      = inertia_measure(p->inertia_x, p->inertia_acc[0]);
+        p->inertia_y      = inertia_measure(p->inertia_y, p->inertia_acc[1]);
+        p->inertia_acc[0] = 0;
+        p->inertia_acc[1] = 0;
+    } else if (TIMER_DIFF_16(now, p->inertia_last_motion) >= MTK_INERTIA_RELEASE_MS) {
+        // ボールを離した：十分な速度があれば慣性スクロールを開始
+        const int16_t threshold = MTK_INERTIA_THRESHOLD << MTK_INERTIA_FRAC_BITS;
+        if (c->inertia_enabled && (abs(p->inertia_x) >= threshold || abs(p->inertia_y) >= threshold)) {
+            p->inertia_coasting = true;
+            p->inertia_frac[0]  = 0;
+            p->inertia_frac[1]  = 0;
+        } else {
+            mtk_pointer_inertia_stop(p);
+        }
+    }
+}
+
+
+/****************************************************************************
+ * scroll_snap_update
+ *
+ * スクロールスナップのテンションを更新し、今回適用するスナップモードを返す。
+ * スナップ中は軸外方向とスナップ軸の移動量の差をテンションとして蓄積し、
+ * MTK_SCROLLSNAP_TENSION_THRESHOLD に達したらスナップを解除する（FREE）。
+ * ボールが MTK_SCROLLSNAP_RESET_TIMER の間止まるとテンションを戻して再スナップする。
+ * スナップ中の軸外方向の移動量（h, v: カウント）は破棄する。
+ * ****************************************************************************/
+static uint8_t scroll_snap_update(mtk_pointer_t *p, int16_t *h, int16_t *v, uint8_t mode) {
+#if MTK_SCROLLSNAP_ENABLE
+    if (mode == MTK_SCROLLSNAP_MODE_FREE) {
+        return mode;
+    }
+
+    uint32_t now = timer_read32();
+    if (*h != 0 || *v != 0) {
+        p->scroll_snap_last = now;
+    } else if (TIMER_DIFF_32(now, p->scroll_snap_last) >= MTK_SCROLLSNAP_RESET_TIMER) {
+        p->scroll_snap_tension_h = 0;
+    }
+
+    // テンションが閾値に達している間はスナップを解除
+    if (p->scroll_snap_tension_h >= MTK_SCROLLSNAP_TENSION_THRESHOLD) {
+        return MTK_SCROLLSNAP_MODE_FREE;
+    }
+
+    int16_t *on  = (mode == MTK_SCROLLSNAP_MODE_VERTICAL) ? v : h; // スナップ軸
+    int16_t *off = (mode == MTK_SCROLLSNAP_MODE_VERTICAL) ? h : v; // 軸外方向
+
+    // 軸外方向の優勢分でテンションを増減させる
+    // 下限を -MTK_SCROLLBALL_INHIVITOR とし、スナップ軸で動かした直後の軸外の揺れは不感帯として吸収する
+    int16_t tension = p->scroll_snap_tension_h + abs(*off) - abs(*on);
+    if (tension < -MTK_SCROLLBALL_INHIVITOR) {
+        tension = -MTK_SCROLLBALL_INHIVITOR;
+    } else if (tension > MTK_SCROLLSNAP_TENSION_THRESHOLD) {
+        tension = MTK_SCROLLSNAP_TENSION_THRESHOLD;
+    }
+    p->scroll_snap_tension_h = tension;
+
+    if (tension >= MTK_SCROLLSNAP_TENSION_THRESHOLD) {
+        return MTK_SCROLLSNAP_MODE_FREE;
+    }
+    *off = 0;
+#endif
+    return mode;
+}
+
+
+/****************************************************************************
+ * scroll_to_wheel
+ *
+ * 累積スクロール量（カウント×分解能）をホイールの送信単位に変換する。
+ * 送信した分だけ累積量から差し引き、端数は次回のレポートに繰り越す。
+ * ****************************************************************************/
+static mouse_hv_report_t scroll_to_wheel(int32_t *acc, int16_t div) {
+    int32_t out = *acc / div;
+    if (out > MTK_HV_REPORT_MAX) {
+        out = MTK_HV_REPORT_MAX;
+    } else if (out < -MTK_HV_REPORT_MAX) {
+        out = -MTK_HV_REPORT_MAX;
+    }
+    *acc -= out * div;
+    return (mouse_hv_report_t)out;
+}
+
+
+/****************************************************************************
+ * mtk_pointer_task
+ *
+ * センサーの移動量（mouse_report の x, y）をマウスレポートに変換する。
+ * スクロールモードではホイール（h, v）に、それ以外はカーソル移動（x, y）にする。
+ * ****************************************************************************/
+report_mouse_t mtk_pointer_task(mtk_pointer_t *p, const mtk_pointer_config_t *c, report_mouse_t mouse_report) {
+    int16_t scroll_div = c->scroll_div * 8;      // スクロール分解能
+    uint8_t snap_mode  = c->scroll_snap_mode;
+
+    //X軸とY軸を反転させます（X軸→Y軸、Y軸→X軸）
+    int16_t x_rev =  mouse_report.y * -1;
+    int16_t y_rev =  mouse_report.x * -1;
+
+    // スクロールモードが有効な場合
+    if (c->scroll_mode) {
+        // 慣性スクロールの計測と、慣性による移動量の追加
+        inertia_task(p, c, &x_rev, &y_rev);
+
+        // スクロールスナップ（テンションが閾値を超えるまで軸を固定）
+        snap_mode = scroll_snap_update(p, &x_rev, &y_rev, snap_mode);
+
+        // X軸とY軸を反転し、高分解能の単位でスクロール量に加算
+        p->scroll_h += (int32_t)x_rev * c->scroll_resolution;
+        p->scroll_v += (int32_t)y_rev * c->scroll_resolution;
+
+        // ホイール単位に変換し、送信しなかった端数は次回に繰り越す
+        mouse_hv_report_t scaled_scroll_h = scroll_to_wheel(&p->scroll_h, scroll_div);
+        mouse_hv_report_t scaled_scroll_v = scroll_to_wheel(&p->scroll_v, scroll_div);
+
+        // 水平方向のスクロール処理（AC Pan）
+        if (scaled_scroll_h != 0) {
+            switch (snap_mode) {
+                case MTK_SCROLLSNAP_MODE_VERTICAL:
+                    mouse_report.h = 0;
+                    break;
+                case MTK_SCROLLSNAP_MODE_HORIZONTAL:
+                case MTK_SCROLLSNAP_MODE_FREE:
+                    mouse_report.h = scaled_scroll_h;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // 垂直方向のスクロール処理
+        if (scaled_scroll_v != 0) {
+            mouse_hv_report_t adjusted_v = (c->scroll_direction) ? scaled_scroll_v : -scaled_scroll_v;
+            switch (snap_mode) {
+                case MTK_SCROLLSNAP_MODE_VERTICAL:
+                    mouse_report.v = adjusted_v;
+                    break;
+                case MTK_SCROLLSNAP_MODE_HORIZONTAL:
+                    mouse_report.v = 0;
+                    break;
+                case MTK_SCROLLSNAP_MODE_FREE:
+                    mouse_report.v = adjusted_v;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // 通常の移動量を無効化
+        mouse_report.x = 0;
+        mouse_report.y = 0;
+    } else {
+        // スクロールモードが無効な場合（計測中の速度とスクロールの端数も破棄する）
+        mtk_pointer_scroll_reset(p);
+
+        if (c->speed_adjust_enabled) {
+            motion_to_mouse(p, c, &mouse_report, mouse_report.x, mouse_report.y);
+
+            // motion_to_mouse後のmouse_reportの向きを修正
+            int16_t temp_x = mouse_report.x;
+            mouse_report.x = mouse_report.y;
+            mouse_report.y = temp_x;
+
+            // 向きを反転させる場合
+            mouse_report.x *= -1;
+            mouse_report.y *= -1;
+
+        } else {
+            // 速度調整が無効な場合のみCPI反転値を適用
+            mouse_report.x = x_rev;
+            mouse_report.y = y_rev;
+        }
+        mouse_report.h = 0;
+        mouse_report.v = 0;
+    }
+
+    return mouse_report;
+}
+
+
+/****************************************************************************
+ * mtk_pointer_init
+ *
+ * ポインタ処理の状態をすべて初期化する。
+ * ****************************************************************************/
+void mtk_pointer_init(mtk_pointer_t *p) {
+    mtk_pointer_carry_reset(p);
+    mtk_pointer_scroll_reset(p);
+    p->accel_lut_cpi = 0;           // 速度調整テーブルは次の変換で再計算
+}
+
+
+/****************************************************************************
+ * mtk_pointer_carry_reset
+ *
+ * 繰り越し中の端数を破棄する。一定時間動作がない場合に呼び出す。
+ * ****************************************************************************/
+void mtk_pointer_carry_reset(mtk_pointer_t *p) {
+    p->carry[0]     = 0;
+    p->carry[1]     = 0;
+    p->carry_dir[0] = 0;
+    p->carry_dir[1] = 0;
+}
+
+
+/****************************************************************************
+ * mtk_pointer_scroll_reset
+ *
+ * スクロールの端数・慣性・スナップのテンションを破棄する。
+ * スクロールモードを抜けたときや分解能を切り替えたときに呼び出す。
+ * ****************************************************************************/
+void mtk_pointer_scroll_reset(mtk_pointer_t *p) {
+    mtk_pointer_inertia_stop(p);
+    p->scroll_h              = 0;
+    p->scroll_v              = 0;
+    p->scroll_snap_tension_h = 0;
+}
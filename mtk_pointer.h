@@ -0,0 +1,83 @@
+/*
+ * mtk_pointer.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールの移動量をマウスレポートに変換するポインタ処理。
+ * 速度調整・端数の繰り越し・慣性スクロール・スクロールスナップ・
+ * 高分解能ホイールへの変換をまとめている。
+ * QMKへの依存は report_mouse_t とタイマーのみで、キーボード本体の設定
+ * （mtk_config）には触れないため、ホスト上でもスタブヘッダでコンパイルできる。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "report.h"             // report_mouse_t
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+// スクロールスナップモードの定義
+#define MTK_SCROLLSNAP_MODE_VERTICAL   0
+#define MTK_SCROLLSNAP_MODE_HORIZONTAL 1
+#define MTK_SCROLLSNAP_MODE_FREE       2
+
+// 速度調整テーブルの範囲
+#define MTK_ACCEL_LUT_BITS       9                              // テーブル範囲のビット数
+#define MTK_ACCEL_LUT_SIZE       (1 << MTK_ACCEL_LUT_BITS)      // テーブル範囲（0〜512カウント）
+#define MTK_ACCEL_OCTAVES        (16 - MTK_ACCEL_LUT_BITS + 1)  // テーブル範囲外の段数（int16全域）
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+// ポインタ処理の設定（レポートごとに mtk_config から作る）
+typedef struct {
+    uint16_t cpi;                   // CPI値
+    bool     speed_adjust_enabled;  // 速度調整の有効/無効
+    uint8_t  speed_adjust_value;    // 速度調整値（指数×10）
+    bool     scroll_mode;           // スクロールモード
+    bool     scroll_direction;      // スクロール方向
+    uint8_t  scroll_div;            // スクロール速度の分割値
+    uint8_t  scroll_snap_mode;      // スクロールスナップモード
+    uint16_t scroll_resolution;     // 1ノッチあたりのホイール送信単位数
+    bool     inertia_enabled;       // 慣性スクロールの有効/無効
+    uint8_t  inertia_friction;      // 慣性スクロールの減衰率 (1tickごとに速度を n/256 倍)
+} mtk_pointer_config_t;
+
+// ポインタ処理の状態（センサー1つにつき1つ）
+typedef struct {
+    int32_t  carry[2];              // 繰り越し中の端数（Q8）、X/Y別
+    int8_t   carry_dir[2];          // 直前の移動方向（-1, 0, 1）、X/Y別
+    int32_t  scroll_h;              // 水平スクロールの累積量（カウント×分解能）
+    int32_t  scroll_v;              // 垂直スクロールの累積量（カウント×分解能）
+    bool     inertia_coasting;      // 慣性スクロール中フラグ
+    uint16_t inertia_tick;          // 直前のtick処理の時刻
+    uint16_t inertia_last_motion;   // 最後にボールが動いた時刻
+    int16_t  inertia_x;             // 慣性スクロールの速度X（Q4 カウント/tick）
+    int16_t  inertia_y;             // 慣性スクロールの速度Y（Q4 カウント/tick）
+    int16_t  inertia_acc[2];        // 現在のtickで計測中の移動量（カウント）
+    int16_t  inertia_frac[2];       // 慣性による移動量の端数（Q4）
+    uint32_t scroll_snap_last;      // スクロールスナップの最後のタイムスタンプ
+    int8_t   scroll_snap_tension_h; // スクロールスナップのテンション（軸外方向）
+    uint16_t accel_lut_cpi;         // 速度調整テーブル計算時のCPI（0: 未計算）
+    uint8_t  accel_lut_speed;       // 速度調整テーブル計算時の速度調整値
+    uint32_t accel_lut[2][MTK_ACCEL_LUT_SIZE + 1]; // 速度調整テーブル |delta| → 移動量（Q16）、X/Y別
+    uint64_t accel_pow2[MTK_ACCEL_OCTAVES];        // 2^(n*e)（Q16）
+} mtk_pointer_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// センサーの移動量をマウスレポート（移動またはスクロール）に変換
+report_mouse_t mtk_pointer_task(mtk_pointer_t *pointer, const mtk_pointer_config_t *config, report_mouse_t mouse_report);
+
+// 状態のリセット
+void mtk_pointer_init(mtk_pointer_t *pointer);
+void mtk_pointer_carry_reset(mtk_pointer_t *pointer);
+void mtk_pointer_scroll_reset(mtk_pointer_t *pointer);
+void mtk_pointer_inertia_stop(mtk_pointer_t *pointer);
@@ -0,0 +1,1032 @@
+/*
+ * mtk_sensor.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールセンサー（PMW3389）のドライバ（POINTING_DEVICE_DRIVER = custom）。
+ *
+ * ■構成
+ * - 初期化（電源投入・SROMの書き込み）は core 0 で QMK の spi_master を使って行う。
+ * - 初期化後は SPI1 をこのファイルで直接操作し、MTK_SENSOR_CORE1 が有効な場合は
+ *   core 1 が MTK_SENSOR_POLL_US ごとにモーションバーストを読み、
+ *   移動があればパケットをリングバッファに積む。
+ * - モーションバーストはアドレスの1バイトだけを同期で送り、残りの6バイトは
+ *   DMA で受信する（sensor_step の状態機械）。転送中も CPU は他の処理を続けられる。
+ * - MTK_SENSOR_SOF_SYNC が有効な場合は USB の SOF に合わせ、各フレームの終わりの直前に
+ *   1回だけセンサーを読み、core 0 はフレームごとに1回だけレポートを出す。
+ * - MTK_SENSOR_MOTION_PIN を定義すると、センサーの MOTION 端子が Low の間だけ
+ *   バーストを読む。静止中は SPI のトランザクションが発生しない。
+ * - core 0 は pointing_device_driver_get_report でリングバッファを空になるまで読み、
+ *   移動量を合計してマウスレポートにする。
+ * - CPI の変更などレジスタの書き込みは、コマンドキューで core 1 に依頼する。
+ *
+ * ■core 1 の制約
+ * core 1 で動くコードは .time_critical セクション（RAM）に置く。
+ * 設定の保存でフラッシュを書き換えている間は XIP が止まるため、
+ * core 1 からはフラッシュ上の関数（ChibiOS・libc・libgcc の除算など）や定数を参照しない。
+ */
+
+#include "quantum.h"
+#include <string.h>
+#include "spi_master.h"
+#include "mtk_sensor.h"
+#include "mtk64erp.h"
+#include "../../drivers/sensors/pmw3389.h" // CPIの範囲
+#include "drivers/sensors/pmw3389_firmware.h" // SROMファームウェア
+
+_Static_assert((MTK_SENSOR_RING_SIZE & (MTK_SENSOR_RING_SIZE - 1)) == 0, "MTK_SENSOR_RING_SIZE must be a power of two");
+
+#define MTK_SENSOR_TIME_CRITICAL  __attribute__((section(".time_critical.mtk_sensor"), noinline))
+#define MTK_SENSOR_INLINE         static inline __attribute__((always_inline))
+
+
+//////////////////////////////////////////////////////////////////////////////
+// PMW3389 のレジスタとタイミング
+
+#define PMW_REG_PRODUCT_ID        0x00
+#define PMW_REG_MOTION            0x02
+#define PMW_REG_DELTA_X_L         0x03
+#define PMW_REG_DELTA_X_H         0x04
+#define PMW_REG_DELTA_Y_L         0x05
+#define PMW_REG_DELTA_Y_H         0x06
+#define PMW_REG_RESOLUTION_L      0x0E
+#define PMW_REG_RESOLUTION_H      0x0F
+#define PMW_REG_CONFIG2           0x10
+#define PMW_REG_SROM_ENABLE       0x13
+#define PMW_REG_RUN_DOWNSHIFT     0x14
+#define PMW_REG_REST1_RATE_L      0x15
+#define PMW_REG_REST1_RATE_H      0x16
+#define PMW_REG_REST1_DOWNSHIFT   0x17
+#define PMW_REG_REST2_RATE_L      0x18
+#define PMW_REG_REST2_RATE_H      0x19
+#define PMW_REG_REST2_DOWNSHIFT   0x1A
+#define PMW_REG_REST3_RATE_L      0x1B
+#define PMW_REG_REST3_RATE_H      0x1C
+#define PMW_REG_SROM_ID           0x2A
+#define PMW_REG_POWER_UP_RESET    0x3A
+#define PMW_REG_SHUTDOWN          0x3B
+#define PMW_REG_MOTION_BURST      0x50
+#define PMW_REG_SROM_LOAD_BURST   0x62
+#define PMW_REG_LIFT_CONFIG       0x63
+
+#define PMW_CONFIG2_REST_EN       0x20  // Config2: レストモード有効
+#define PMW_MOTION_MOT            0x80  // Motion: 移動あり
+#define PMW_MOTION_LIFT           0x08  // Motion: ボールが離れている
+#define PMW_MOTION_OP_MODE        0x07  // Motion: バースト中は0以外にならないビット
+
+#define PMW_T_SRAD_US             160   // アドレス送信から読み取りまでの待ち時間
+#define PMW_T_SRAD_MOTBR_US       35    // バーストのアドレス送信から読み取りまでの待ち時間
+#define PMW_T_SCLK_NCS_WRITE_US   35    // 書き込み後にCSを上げるまでの待ち時間
+#define PMW_T_SWX_US              180   // 書き込み後の待ち時間
+#define PMW_T_BEXIT_US            1     // バースト後にCSを上げておく時間
+
+#ifndef PMW33XX_CPI
+#    define PMW33XX_CPI            1600  // 初期化時のCPI
+#endif
+
+#ifndef PMW33XX_LIFTOFF_DISTANCE
+#    define PMW33XX_LIFTOFF_DISTANCE 0x02
+#endif
+
+#define PMW_SPI_DIVISOR           64    // 125MHz / 64 = 約2MHz（PMW3389 の上限）
+#define PMW_BURST_LEN             6     // Motion, Observation, Delta_X_L/H, Delta_Y_L/H
+
+// レストモードのフレーム周期（ミリ秒）。ダウンシフト時間の計算に使うため固定値を書き込む
+#define PMW_REST1_PERIOD_MS       1
+#define PMW_REST2_PERIOD_MS       100
+#define PMW_REST3_PERIOD_MS       500
+
+
+//////////////////////////////////////////////////////////////////////////////
+// RP2040 のレジスタ（core 1 から直接操作する）
+
+#define RP_REG(addr)              (*(volatile uint32_t *)(addr))
+#define RP_CLR_ALIAS              0x3000                    // アトミックなビットクリア
+#define RP_SET_ALIAS              0x2000                    // アトミックなビットセット
+
+#define RP_RESETS_BASE            0x4000C000
+#define RP_RESETS_DONE            RP_REG(RP_RESETS_BASE + 0x08)
+#define RP_RESETS_SPI1            (1u << 17)
+
+#define RP_PSM_FRCE_OFF_ADDR      0x40010004
+#define RP_PSM_PROC1              (1u << 16)
+
+#define RP_SPI1_BASE              0x40040000
+#define RP_SSPCR0                 RP_REG(RP_SPI1_BASE + 0x00)
+#define RP_SSPCR1                 RP_REG(RP_SPI1_BASE + 0x04)
+#define RP_SSPDR                  RP_REG(RP_SPI1_BASE + 0x08)
+#define RP_SSPSR                  RP_REG(RP_SPI1_BASE + 0x0C)
+#define RP_SSPCPSR                RP_REG(RP_SPI1_BASE + 0x10)
+#define RP_SSPDMACR               RP_REG(RP_SPI1_BASE + 0x24)
+#define RP_SSPSR_TNF              (1u << 1)
+#define RP_SSPSR_RNE              (1u << 2)
+#define RP_SSPSR_BSY              (1u << 4)
+#define RP_SSPDMACR_RXDMAE        (1u << 0)
+#define RP_SSPDMACR_TXDMAE        (1u << 1)
+
+#define RP_DMA_BASE               0x50000000
+#define RP_DMA_READ_ADDR(ch)      RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x00)
+#define RP_DMA_WRITE_ADDR(ch)     RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x04)
+#define RP_DMA_TRANS_COUNT(ch)    RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x08)
+#define RP_DMA_CTRL_TRIG(ch)      RP_REG(RP_DMA_BASE + (ch) * 0x40 + 0x0C)
+#define RP_DMA_CTRL_EN            (1u << 0)
+#define RP_DMA_CTRL_INCR_WRITE    (1u << 5)
+#define RP_DMA_CTRL_CHAIN_TO(ch)  ((uint32_t)(ch) << 11)   // 自分自身を指定するとチェーンしない
+#define RP_DMA_CTRL_TREQ(dreq)    ((uint32_t)(dreq) << 15)
+#define RP_DMA_CTRL_IRQ_QUIET     (1u << 21)
+#define RP_DMA_CTRL_BUSY          (1u << 24)
+#define RP_DREQ_SPI1_TX           18
+#define RP_DREQ_SPI1_RX           19
+
+#define RP_SIO_BASE               0xD0000000
+#define RP_SIO_GPIO_IN            RP_REG(RP_SIO_BASE + 0x04)
+#define RP_SIO_GPIO_OUT_SET       RP_REG(RP_SIO_BASE + 0x14)
+#define RP_SIO_GPIO_OUT_CLR       RP_REG(RP_SIO_BASE + 0x18)
+#define RP_SIO_FIFO_ST            RP_REG(RP_SIO_BASE + 0x50)
+#define RP_SIO_FIFO_WR            RP_REG(RP_SIO_BASE + 0x54)
+#define RP_SIO_FIFO_RD            RP_REG(RP_SIO_BASE + 0x58)
+#define RP_SIO_FIFO_VLD           (1u << 0)
+#define RP_SIO_FIFO_RDY           (1u << 1)
+
+#define RP_SCB_VTOR               RP_REG(0xE000ED08)
+
+#define RP_USB_SOF_RD             RP_REG(0x50110008)  // 最後に受信した SOF のフレーム番号
+#define RP_USB_SOF_FRAME_MASK     0x7FF
+
+#define PMW_CS_MASK               (1u << (PMW33XX_CS_PIN & 0x1F))
+#ifdef MTK_SENSOR_MOTION_PIN
+#    define PMW_MOTION_PIN_MASK   (1u << (MTK_SENSOR_MOTION_PIN & 0x1F))
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////
+// core 1 からメインループへの移動量パケット（単一生産者・単一消費者）
+
+static mtk_sensor_packet_t sensor_ring[MTK_SENSOR_RING_SIZE];
+static volatile uint16_t   sensor_ring_head = 0;  // core 1 だけが書き込む
+static volatile uint16_t   sensor_ring_tail = 0;  // core 0 だけが書き込む
+
+// core 0 から core 1 へのレジスタ書き込み依頼（単一生産者・単一消費者）
+#define MTK_SENSOR_CMD_SIZE       8
+typedef struct {
+    uint8_t reg;
+    uint8_t value;
+} sensor_cmd_t;
+
+static sensor_cmd_t      sensor_cmd[MTK_SENSOR_CMD_SIZE];
+static volatile uint8_t  sensor_cmd_head = 0;     // core 0 だけが書き込む
+static volatile uint8_t  sensor_cmd_tail = 0;     // core 1 だけが書き込む
+
+// センサー読み取りの状態（sensor_step）
+typedef enum {
+    SENSOR_STATE_IDLE,                            // 次の読み取り周期を待つ
+    SENSOR_STATE_SRAD,                            // アドレス送信後の待ち
+    SENSOR_STATE_XFER,                            // DMA で受信中
+} sensor_state_t;
+
+static volatile sensor_state_t sensor_state = SENSOR_STATE_IDLE;
+static uint8_t  sensor_burst_buf[PMW_BURST_LEN];  // モーションバーストの受信バッファ（DMAの書き込み先）
+static uint8_t  sensor_dma_zero = 0;              // DMA で送るダミーデータ
+static uint8_t  sensor_dma_rx;                    // 受信用DMAチャネル
+static uint8_t  sensor_dma_tx;                    // 送信用DMAチャネル
+
+// 読み取りの統計（項目は mtk_sensor_stats_t と同じ。センサーを読む側だけが書き込み、クリアも core 0 から依頼して読む側で行う）
+typedef struct {
+    uint32_t reads;
+    uint32_t bytes;
+    uint32_t blocked_us;
+    uint32_t idle_transactions;
+    uint32_t moving_transactions;
+    uint32_t idle_us;
+    uint32_t moving_us;
+} sensor_read_stats_t;
+
+// レポートの統計（項目は mtk_sensor_stats_t と同じ。core 0 だけが書き込む）
+typedef struct {
+    uint32_t reports;
+    uint32_t latency_count;
+    uint32_t latency_sum_us;
+    uint32_t latency_max_us;
+} sensor_report_stats_t;
+
+static sensor_read_stats_t   sensor_stats;        // 読み取りの統計
+static sensor_report_stats_t report_stats;        // レポートの統計
+static volatile bool         sensor_stats_clear = false;  // 読み取りの統計のクリア依頼（core 0 が立て、読む側が下ろす）
+
+#if MTK_SENSOR_SOF_SYNC
+// USB の SOF（1ms フレームの開始）
+static uint16_t          sof_frame      = 0;      // 最後に見たフレーム番号（センサーを読む側だけが触る）
+static volatile uint32_t sof_time       = 0;      // そのフレームが始まった時刻
+static uint16_t          sof_read_frame = 0;      // 最後にセンサーを読んだフレーム番号
+static uint16_t          report_frame   = 0;      // 最後にレポートを出したフレーム番号（core 0）
+#endif
+
+static bool     sensor_ready   = false;           // 初期化済みフラグ
+static bool     sensor_core1   = false;           // core 1 が動作中
+static bool     sensor_burst   = false;           // バーストモード中（センサーを読む側だけが触る）
+static bool     sensor_moving  = false;           // 前回のバーストで移動あり（センサーを読む側だけが触る）
+static uint16_t sensor_cpi     = PMW33XX_CPI;     // 最後に設定したCPI
+static int32_t  sensor_carry_x = 0;               // レポートの範囲を超えた移動量の繰り越し
+static int32_t  sensor_carry_y = 0;
+
+#if MTK_SENSOR_CORE1
+static uint32_t core1_stack[256];                 // core 1 のスタック（1KB）
+#endif
+
+
+/****************************************************************************
+ * メモリバリアと時刻
+ * ****************************************************************************/
+MTK_SENSOR_INLINE void sensor_barrier(void) {
+    __asm volatile("dmb" ::: "memory");
+}
+
+MTK_SENSOR_INLINE void sensor_delay_us(uint32_t us) {
+    uint32_t start = mtk_timer_read_us();
+    while (mtk_timer_read_us() - start < us) {
+    }
+}
+
+
+/****************************************************************************
+ * SPI1 の直接操作
+ * ****************************************************************************/
+MTK_SENSOR_INLINE uint8_t sensor_spi_xfer(uint8_t out) {
+    while (!(RP_SSPSR & RP_SSPSR_TNF)) {
+    }
+    RP_SSPDR = out;
+    while (!(RP_SSPSR & RP_SSPSR_RNE)) {
+    }
+    return (uint8_t)RP_SSPDR;
+}
+
+MTK_SENSOR_INLINE void sensor_cs_low(void) {
+    RP_SIO_GPIO_OUT_CLR = PMW_CS_MASK;
+}
+
+MTK_SENSOR_INLINE void sensor_cs_high(void) {
+    while (RP_SSPSR & RP_SSPSR_BSY) {
+    }
+    RP_SIO_GPIO_OUT_SET = PMW_CS_MASK;
+}
+
+
+/****************************************************************************
+ * sensor_motion_pending
+ *
+ * センサーの MOTION 端子（Low アクティブ）が移動データありを示しているか。
+ * MOTION 端子はモーションバーストを読むまで Low のままなので、端子の状態を見るだけでよい。
+ * MTK_SENSOR_MOTION_PIN が未定義の場合は常に読む。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE bool sensor_motion_pending(void) {
+#ifdef MTK_SENSOR_MOTION_PIN
+    return !(RP_SIO_GPIO_IN & PMW_MOTION_PIN_MASK);
+#else
+    return true;
+#endif
+}
+
+
+/****************************************************************************
+ * sensor_spi_setup
+ *
+ * QMK の spi_master を使った初期化の後、SPI1 を直接操作できるよう設定する。
+ * モード3・8ビット・約2MHz、DMA要求は使わない。
+ * ****************************************************************************/
+static void sensor_spi_setup(void) {
+    RP_REG(RP_RESETS_BASE + RP_CLR_ALIAS) = RP_RESETS_SPI1;
+    while (!(RP_RESETS_DONE & RP_RESETS_SPI1)) {
+    }
+    RP_SSPCR1   = 0;                                     // 設定中は停止
+    RP_SSPCPSR  = 2;                                     // プリスケーラ
+    RP_SSPCR0   = (7u << 0) | (1u << 6) | (1u << 7)      // 8ビット、CPOL=1、CPHA=1
+                | ((PMW_SPI_DIVISOR / 2 - 1) << 8);      // SCR
+    RP_SSPDMACR = 0;
+    RP_SSPCR1   = (1u << 1);                             // 有効化
+    while (RP_SSPSR & RP_SSPSR_RNE) {
+        (void)RP_SSPDR;
+    }
+    gpio_write_pin_high(PMW33XX_CS_PIN);
+#ifdef MTK_SENSOR_MOTION_PIN
+    gpio_set_pin_input_high(MTK_SENSOR_MOTION_PIN);
+#endif
+}
+
+
+/****************************************************************************
+ * sensor_blocked
+ *
+ * CPUが待たされた時間（start からの経過）を統計に加える。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE void sensor_blocked(uint32_t start) {
+    sensor_stats.blocked_us += mtk_timer_read_us() - start;
+}
+
+
+/****************************************************************************
+ * sensor_count_transaction
+ *
+ * SPI トランザクション（CS を下げてから上げるまで）の回数を、
+ * 移動中か静止中かに分けて統計に加える。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE void sensor_count_transaction(void) {
+    if (sensor_moving) {
+        sensor_stats.moving_transactions++;
+    } else {
+        sensor_stats.idle_transactions++;
+    }
+}
+
+
+/****************************************************************************
+ * sensor_reg_write
+ *
+ * センサーのレジスタに1バイト書き込む（SPI1 の直接操作）。
+ * 書き込むとバーストモードは解除される。まれにしか呼ばれないため待ち合わせは同期で行う。
+ * ****************************************************************************/
+MTK_SENSOR_TIME_CRITICAL static void sensor_reg_write(uint8_t reg, uint8_t value) {
+    uint32_t start = mtk_timer_read_us();
+    sensor_cs_low();
+    sensor_spi_xfer(reg | 0x80);
+    sensor_spi_xfer(value);
+    sensor_delay_us(PMW_T_SCLK_NCS_WRITE_US);
+    sensor_cs_high();
+    sensor_delay_us(PMW_T_SWX_US);
+    sensor_burst = false;
+    sensor_count_transaction();
+    sensor_stats.bytes += 2;
+    sensor_blocked(start);
+}
+
+
+/****************************************************************************
+ * sensor_dma_start
+ *
+ * モーションバーストの残り（PMW_BURST_LEN バイト）を DMA で受信する。
+ * 受信用チャネルで SSPDR から sensor_burst_buf へ、送信用チャネルで
+ * ダミーの 0x00 を SSPDR へ転送し、完了は受信用チャネルの BUSY で確認する。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE void sensor_dma_start(void) {
+    const uint32_t ctrl = RP_DMA_CTRL_EN | RP_DMA_CTRL_IRQ_QUIET;
+
+    RP_DMA_READ_ADDR(sensor_dma_rx)   = (uint32_t)&RP_SSPDR;
+    RP_DMA_WRITE_ADDR(sensor_dma_rx)  = (uint32_t)sensor_burst_buf;
+    RP_DMA_TRANS_COUNT(sensor_dma_rx) = PMW_BURST_LEN;
+    RP_DMA_CTRL_TRIG(sensor_dma_rx)   = ctrl | RP_DMA_CTRL_INCR_WRITE | RP_DMA_CTRL_CHAIN_TO(sensor_dma_rx) | RP_DMA_CTRL_TREQ(RP_DREQ_SPI1_RX);
+
+    RP_DMA_READ_ADDR(sensor_dma_tx)   = (uint32_t)&sensor_dma_zero;
+    RP_DMA_WRITE_ADDR(sensor_dma_tx)  = (uint32_t)&RP_SSPDR;
+    RP_DMA_TRANS_COUNT(sensor_dma_tx) = PMW_BURST_LEN;
+    RP_DMA_CTRL_TRIG(sensor_dma_tx)   = ctrl | RP_DMA_CTRL_CHAIN_TO(sensor_dma_tx) | RP_DMA_CTRL_TREQ(RP_DREQ_SPI1_TX);
+}
+
+
+/****************************************************************************
+ * sensor_ring_push
+ *
+ * 移動量パケットをリングバッファに積む（生産者側）。
+ * 満杯の場合は積めなかった移動量を呼び出し元で保持し、次回に合算する。
+ * ****************************************************************************/
+MTK_SENSOR_TIME_CRITICAL static bool sensor_ring_push(int16_t dx, int16_t dy) {
+    uint16_t head = sensor_ring_head;
+    if ((uint16_t)(head - sensor_ring_tail) >= MTK_SENSOR_RING_SIZE) {
+        return false;
+    }
+    mtk_sensor_packet_t *p = &sensor_ring[head & (MTK_SENSOR_RING_SIZE - 1)];
+    p->time_us = mtk_timer_read_us();
+    p->dx      = dx;
+    p->dy      = dy;
+    sensor_barrier();                 // パケットの書き込みを先に完了させる
+    sensor_ring_head = head + 1;
+    return true;
+}
+
+
+/****************************************************************************
+ * sensor_burst_done
+ *
+ * 受信したモーションバーストを解釈し、移動があればリングバッファに積む。
+ * ****************************************************************************/
+MTK_SENSOR_TIME_CRITICAL static void sensor_burst_done(void) {
+    static int16_t pending_x = 0;    // リングバッファが満杯で積めなかった移動量
+    static int16_t pending_y = 0;
+    const uint8_t *buf = sensor_burst_buf;
+
+    // バーストモードが外れていたら次回入り直す
+    if (buf[0] & PMW_MOTION_OP_MODE) {
+        sensor_burst = false;
+    }
+    sensor_moving = (buf[0] & PMW_MOTION_MOT) != 0;
+    if (!(buf[0] & PMW_MOTION_LIFT) && (buf[0] & PMW_MOTION_MOT)) {
+        int32_t x = pending_x + (int16_t)(buf[2] | (buf[3] << 8));
+        int32_t y = pending_y + (int16_t)(buf[4] | (buf[5] << 8));
+        pending_x = x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : x);
+        pending_y = y > INT16_MAX ? INT16_MAX : (y < INT16_MIN ? INT16_MIN : y);
+    }
+    if ((pending_x != 0 || pending_y != 0) && sensor_ring_push(pending_x, pending_y)) {
+        pending_x = 0;
+        pending_y = 0;
+    }
+}
+
+
+#if MTK_SENSOR_SOF_SYNC
+/****************************************************************************
+ * sensor_sof_active
+ *
+ * USB の SOF を受信しているか（ホストに接続されたマスター側か）。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE bool sensor_sof_active(uint32_t now) {
+    return now - sof_time < MTK_SENSOR_SOF_TIMEOUT_US;
+}
+#endif
+
+
+/****************************************************************************
+ * sensor_poll_due
+ *
+ * センサーを読む時刻になったか判定する。
+ * SOF に同期する場合は、フレームごとに1回、次の SOF の MTK_SENSOR_SOF_LEAD_US 前に読む。
+ * SOF が来ていない場合（スレーブ側など）は MTK_SENSOR_POLL_US ごとに読む。
+ * ****************************************************************************/
+MTK_SENSOR_INLINE bool sensor_poll_due(uint32_t now, uint32_t t_poll) {
+#if MTK_SENSOR_SOF_SYNC
+    uint16_t frame = RP_USB_SOF_RD & RP_USB_SOF_FRAME_MASK;
+    if (frame != sof_frame) {
+        sof_frame = frame;
+        sof_time  = now;
+    }
+    if (sensor_sof_active(now)) {
+        if (sof_read_frame == sof_frame || now - sof_time < 1000 - MTK_SENSOR_SOF_LEAD_US) {
+            return false;
+        }
+        sof_read_frame = sof_frame;
+        return true;
+    }
+#endif
+    return now - t_poll >= MTK_SENSOR_POLL_US;
+}
+
+
+/****************************************************************************
+ * sensor_step
+ *
+ * センサー読み取りの状態機械を1段進める。待ち時間の間は何もせずに戻るため、
+ * 呼び出し元（core 1 のループ、または core 0 のメインループ）は
+ * バーストの転送中も他の処理を続けられる。
+ *
+ *   IDLE : 読み取り周期（sensor_poll_due）が来たら、レジスタ書き込みの依頼を処理してからアドレスを送る。
+ *          MOTION 端子が移動なしを示している間はバーストを読まない
+ *   SRAD : tSRAD_MOTBR（35us）待ってから DMA で6バイト受信を開始する
+ *   XFER : DMA の完了を確認してCSを上げ、結果を解釈する
+ * ****************************************************************************/
+MTK_SENSOR_TIME_CRITICAL static void sensor_step(void) {
+    static uint32_t t_state = 0;     // 現在の状態に入った時刻
+    static uint32_t t_poll  = 0;     // 前回の読み取り開始時刻
+    uint32_t        now     = mtk_timer_read_us();
+    bool            due     = sensor_poll_due(now, t_poll);   // SOF の検出のため毎回呼ぶ
+
+    if (sensor_stats_clear) {
+        sensor_stats       = (sensor_read_stats_t){0};
+        sensor_barrier();             // クリアしてから依頼を下ろす
+        sensor_stats_clear = false;
+    }
+
+    switch (sensor_state) {
+        case SENSOR_STATE_IDLE: {
+            if (!due) {
+                return;
+            }
+            if (sensor_moving) {
+                sensor_stats.moving_us += now - t_poll;
+            } else {
+                sensor_stats.idle_us += now - t_poll;
+            }
+            t_poll = now;
+
+            // レジスタ書き込みの依頼を処理
+            while (sensor_cmd_tail != sensor_cmd_head) {
+                sensor_barrier();
+                sensor_cmd_t *c = &sensor_cmd[sensor_cmd_tail & (MTK_SENSOR_CMD_SIZE - 1)];
+                sensor_reg_write(c->reg, c->value);
+                sensor_barrier();
+                sensor_cmd_tail = sensor_cmd_tail + 1;
+            }
+
+            // 静止中は SPI に触れない（バーストモードに入る前は1回読んで状態を確定させる）
+            if (sensor_burst && !sensor_motion_pending()) {
+                sensor_moving = false;
+                return;
+            }
+            if (!sensor_burst) {
+                sensor_reg_write(PMW_REG_MOTION_BURST, 0x00);
+                sensor_burst = true;
+            }
+
+            // アドレスの送信（1バイトだけ同期で送る）
+            uint32_t start = mtk_timer_read_us();
+            sensor_cs_low();
+            sensor_spi_xfer(PMW_REG_MOTION_BURST);
+            sensor_blocked(start);
+            sensor_count_transaction();
+            sensor_stats.reads++;
+            sensor_stats.bytes += 1 + PMW_BURST_LEN;
+            t_state      = mtk_timer_read_us();
+            sensor_state = SENSOR_STATE_SRAD;
+            break;
+        }
+        case SENSOR_STATE_SRAD:
+            if (now - t_state < PMW_T_SRAD_MOTBR_US) {
+                return;
+            }
+            RP_SSPDMACR = RP_SSPDMACR_RXDMAE | RP_SSPDMACR_TXDMAE;
+            sensor_dma_start();
+            sensor_state = SENSOR_STATE_XFER;
+            break;
+        case SENSOR_STATE_XFER: {
+            if (RP_DMA_CTRL_TRIG(sensor_dma_rx) & RP_DMA_CTRL_BUSY) {
+                return;
+            }
+            uint32_t start = mtk_timer_read_us();
+            RP_SSPDMACR = 0;
+            sensor_cs_high();
+            sensor_delay_us(PMW_T_BEXIT_US);
+            sensor_blocked(start);
+            sensor_burst_done();
+            sensor_state = SENSOR_STATE_IDLE;
+            break;
+        }
+    }
+}
+
+
+#if MTK_SENSOR_CORE1
+/****************************************************************************
+ * core1_main
+ *
+ * core 1 のメインループ。センサー読み取りの状態機械を回し続ける。
+ * ****************************************************************************/
+MTK_SENSOR_TIME_CRITICAL static void core1_main(void) {
+    for (;;) {
+        sensor_step();
+    }
+}
+
+
+/****************************************************************************
+ * core1_fifo_push / core1_fifo_pop
+ *
+ * コア間FIFOの送受信（core 1 の起動手順で使う）。
+ * ****************************************************************************/
+static void core1_fifo_push(uint32_t value) {
+    while (!(RP_SIO_FIFO_ST & RP_SIO_FIFO_RDY)) {
+    }
+    RP_SIO_FIFO_WR = value;
+    __asm volatile("sev");
+}
+
+static uint32_t core1_fifo_pop(void) {
+    while (!(RP_SIO_FIFO_ST & RP_SIO_FIFO_VLD)) {
+        __asm volatile("wfe");
+    }
+    return RP_SIO_FIFO_RD;
+}
+
+
+/****************************************************************************
+ * core1_launch
+ *
+ * core 1 をリセットし、ブートROMの手順（0, 0, 1, VTOR, SP, エントリ）で
+ * core1_main を起動する。
+ * ****************************************************************************/
+static void core1_launch(void) {
+    // core 1 を強制的に電源オフ→オンしてブートROMの待ち状態に戻す
+    RP_REG(RP_PSM_FRCE_OFF_ADDR + RP_SET_ALIAS) = RP_PSM_PROC1;
+    while (!(RP_REG(RP_PSM_FRCE_OFF_ADDR) & RP_PSM_PROC1)) {
+    }
+    RP_REG(RP_PSM_FRCE_OFF_ADDR + RP_CLR_ALIAS) = RP_PSM_PROC1;
+
+    const uint32_t seq[] = {
+        0, 0, 1,
+        RP_SCB_VTOR,
+        (uint32_t)&core1_stack[sizeof(core1_stack) / sizeof(core1_stack[0])],
+        (uint32_t)core1_main,
+    };
+    uint8_t i = 0;
+    while (i < sizeof(seq) / sizeof(seq[0])) {
+        if (seq[i] == 0) {
+            while (RP_SIO_FIFO_ST & RP_SIO_FIFO_VLD) {
+                (void)RP_SIO_FIFO_RD;
+            }
+            __asm volatile("sev");
+        }
+        core1_fifo_push(seq[i]);
+        i = (core1_fifo_pop() == seq[i]) ? i + 1 : 0;
+    }
+    sensor_core1 = true;
+}
+#endif
+
+
+/****************************************************************************
+ * sensor_init_write / sensor_init_read
+ *
+ * 初期化用のレジスタ読み書き（core 0、QMK の spi_master を使用）。
+ * ****************************************************************************/
+static void sensor_init_write(uint8_t reg, uint8_t value) {
+    spi_start(PMW33XX_CS_PIN, false, 3, PMW_SPI_DIVISOR);
+    spi_write(reg | 0x80);
+    spi_write(value);
+    wait_us(PMW_T_SCLK_NCS_WRITE_US);
+    spi_stop();
+    wait_us(PMW_T_SWX_US);
+}
+
+static uint8_t sensor_init_read(uint8_t reg) {
+    spi_start(PMW33XX_CS_PIN, false, 3, PMW_SPI_DIVISOR);
+    spi_write(reg & 0x7F);
+    wait_us(PMW_T_SRAD_US);
+    uint8_t value = spi_read();
+    spi_stop();
+    wait_us(PMW_T_SWX_US);
+    return value;
+}
+
+
+/****************************************************************************
+ * sensor_upload_srom
+ *
+ * SROM ファームウェアをセンサーに書き込み、SROM ID を確認する。
+ * ****************************************************************************/
+static bool sensor_upload_srom(void) {
+    sensor_init_write(PMW_REG_SROM_ENABLE, 0x1D);
+    wait_ms(10);
+    sensor_init_write(PMW_REG_SROM_ENABLE, 0x18);
+
+    spi_start(PMW33XX_CS_PIN, false, 3, PMW_SPI_DIVISOR);
+    spi_write(PMW_REG_SROM_LOAD_BURST | 0x80);
+    wait_us(15);
+    for (uint16_t i = 0; i < PMW33XX_FIRMWARE_LENGTH; i++) {
+        spi_write(pgm_read_byte(&pmw33xx_firmware_data[i]));
+        wait_us(15);
+    }
+    spi_stop();
+    wait_us(200);
+
+    uint8_t id = sensor_init_read(PMW_REG_SROM_ID);
+    sensor_init_write(PMW_REG_CONFIG2, 0x00);
+    return id == pgm_read_byte(&pmw33xx_firmware_signature[2]);
+}
+
+
+/****************************************************************************
+ * mtk_sensor_write
+ *
+ * センサーのレジスタに書き込む。書き込みはコマンドキューに積み、次の読み取り周期に
+ * sensor_step が行う。キューが満杯の場合は空くまで待つ（CPI の変更などで、頻繁には呼ばれない）。
+ * センサーの初期化前は書き込めないので false を返す。
+ * ****************************************************************************/
+bool mtk_sensor_write(uint8_t reg, uint8_t value) {
+    if (!sensor_ready) {
+        return false;
+    }
+
+    // バーストの転送中に割り込まないよう、core 0 で読む場合もキューを通して
+    // sensor_step の IDLE で書き込む
+    uint8_t head = sensor_cmd_head;
+    while ((uint8_t)(head - sensor_cmd_tail) >= MTK_SENSOR_CMD_SIZE) {
+        if (!sensor_core1) {
+            sensor_step();
+        }
+    }
+    sensor_cmd[head & (MTK_SENSOR_CMD_SIZE - 1)] = (sensor_cmd_t){.reg = reg, .value = value};
+    sensor_barrier();
+    sensor_cmd_head = head + 1;
+    return true;
+}
+
+
+/****************************************************************************
+ * sensor_dma_alloc
+ *
+ * ChibiOS の DMA アロケータからバースト受信用に2チャネルを確保する。
+ * 割り込みは使わず、完了はチャネルの BUSY ビットで確認する。
+ * ****************************************************************************/
+static bool sensor_dma_alloc(void) {
+    osalSysLock();
+    const rp_dma_channel_t *rx = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, RP_DMA_PRIORITY_HIGH, NULL, NULL);
+    const rp_dma_channel_t *tx = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, RP_DMA_PRIORITY_HIGH, NULL, NULL);
+    osalSysUnlock();
+    if (rx == NULL || tx == NULL) {
+        return false;
+    }
+    sensor_dma_rx = rx->chnidx;
+    sensor_dma_tx = tx->chnidx;
+    return true;
+}
+
+
+/****************************************************************************
+ * mtk_sensor_get_stats
+ *
+ * センサー読み取りの統計（読み取り回数・転送バイト数・CPUが待たされた時間）を取得する。
+ * クリアの依頼が読む側に処理されるまでは、読み取りの統計を0とする。
+ * ****************************************************************************/
+void mtk_sensor_get_stats(mtk_sensor_stats_t *stats) {
+    sensor_read_stats_t read = {0};
+    if (!sensor_stats_clear) {
+        sensor_barrier();             // 依頼が下りたのを見てから統計を読む
+        read = sensor_stats;
+    }
+    *stats = (mtk_sensor_stats_t){
+        .reads               = read.reads,
+        .bytes               = read.bytes,
+        .blocked_us          = read.blocked_us,
+        .idle_transactions   = read.idle_transactions,
+        .moving_transactions = read.moving_transactions,
+        .idle_us             = read.idle_us,
+        .moving_us           = read.moving_us,
+        .reports             = report_stats.reports,
+        .latency_count       = report_stats.latency_count,
+        .latency_sum_us      = report_stats.latency_sum_us,
+        .latency_max_us      = report_stats.latency_max_us,
+    };
+}
+
+
+/****************************************************************************
+ * mtk_sensor_get_transaction_rate
+ *
+ * 1秒あたりの SPI トランザクション数を、移動中（moving = true）と静止中で分けて取得する。
+ * ****************************************************************************/
+uint16_t mtk_sensor_get_transaction_rate(bool moving) {
+    mtk_sensor_stats_t stats;
+    mtk_sensor_get_stats(&stats);
+    uint32_t count = moving ? stats.moving_transactions : stats.idle_transactions;
+    uint32_t us    = moving ? stats.moving_us : stats.idle_us;
+    if (us == 0) {
+        return 0;
+    }
+    uint64_t rate = (uint64_t)count * 1000000 / us;
+    return rate > UINT16_MAX ? UINT16_MAX : rate;
+}
+
+
+/****************************************************************************
+ * mtk_sensor_hid_command
+ *
+ * raw HID で受け取ったセンサー統計のコマンドを処理し、応答を data に書き込む。
+ *   data[1] = 0x00: 統計の取得 → data[2..5]: 読み取り回数, data[6..9]: 転送バイト数,
+ *                               data[10..13]: 待たされた時間（us）,
+ *                               data[14..15]: 静止中の毎秒トランザクション数,
+ *                               data[16..17]: 移動中の毎秒トランザクション数,
+ *                               data[18..19]: 読み取りからレポートまでの平均時間（us）,
+ *                               data[20..21]: 同じく最大時間（us）,
+ *                               data[22..25]: レポート数、いずれもリトルエンディアン
+ *   data[1] = 0x01: 統計のクリア
+ * ****************************************************************************/
+bool mtk_sensor_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 26 || data[0] != MTK_SENSOR_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case 0x00: {
+            mtk_sensor_stats_t stats;
+            mtk_sensor_get_stats(&stats);
+            memcpy(&data[2], &stats.reads, 4);
+            memcpy(&data[6], &stats.bytes, 4);
+            memcpy(&data[10], &stats.blocked_us, 4);
+            uint16_t idle   = mtk_sensor_get_transaction_rate(false);
+            uint16_t moving = mtk_sensor_get_transaction_rate(true);
+            memcpy(&data[14], &idle, 2);
+            memcpy(&data[16], &moving, 2);
+            uint16_t avg = stats.latency_count ? stats.latency_sum_us / stats.latency_count : 0;
+            uint16_t max = stats.latency_max_us > UINT16_MAX ? UINT16_MAX : stats.latency_max_us;
+            memcpy(&data[18], &avg, 2);
+            memcpy(&data[20], &max, 2);
+            memcpy(&data[22], &stats.reports, 4);
+            break;
+        }
+        case 0x01:
+            // 読み取りの統計は core 1 が書き込んでいる最中でも失われないよう、読む側でクリアする
+            report_stats       = (sensor_report_stats_t){0};
+            sensor_barrier();
+            sensor_stats_clear = true;
+            break;
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
+
+
+/****************************************************************************
+ * mtk_sensor_set_rest
+ *
+ * センサーのレストモード（RUN → REST1 → REST2 → REST3 の自動移行）の有効/無効を設定する。
+ * 無効にするとセンサーは常に最大フレームレート（RUN）で動く。
+ * 有効の間もセンサーは移動を検出するとすぐに RUN に戻る。
+ * センサーの初期化前は書き込めないので false を返す。
+ * ****************************************************************************/
+bool mtk_sensor_set_rest(bool enabled) {
+    return mtk_sensor_write(PMW_REG_CONFIG2, enabled ? PMW_CONFIG2_REST_EN : 0x00);
+}
+
+
+/****************************************************************************
+ * mtk_sensor_set_rest_times
+ *
+ * レストモードの移行時間を設定する。レストモードを有効にしてからすぐに REST1 に入り、
+ * REST1 に rest2_ms、REST2 に rest3_ms とどまると次のモードに移る。
+ * レジスタの単位（REST1: 320フレーム、REST2: 32フレーム）に丸め、最大値で制限する。
+ * 丸めた値が前回書き込んだものと同じ場合はレジスタに書かない（センサーの初期化前の呼び出しは
+ * 書き込めないので、初期化後の呼び出しで書く）。
+ * ****************************************************************************/
+void mtk_sensor_set_rest_times(uint32_t rest2_ms, uint32_t rest3_ms) {
+    static uint16_t written = 0;  // 書き込み済みの REST1/REST2 の downshift（上位・下位バイト、0: 未設定）
+
+    uint32_t rest1_down = rest2_ms / (320 * PMW_REST1_PERIOD_MS);
+    uint32_t rest2_down = rest3_ms / (32 * PMW_REST2_PERIOD_MS);
+    rest1_down          = rest1_down < 1 ? 1 : (rest1_down > 0xFF ? 0xFF : rest1_down);
+    rest2_down          = rest2_down < 1 ? 1 : (rest2_down > 0xFF ? 0xFF : rest2_down);
+    uint16_t downshift  = rest1_down << 8 | rest2_down;
+    if (downshift == written) {
+        return;
+    }
+
+    if (!mtk_sensor_write(PMW_REG_RUN_DOWNSHIFT, 1)) {    // 10ms で RUN から REST1 へ
+        return;
+    }
+    mtk_sensor_write(PMW_REG_REST1_RATE_L, (PMW_REST1_PERIOD_MS - 1) & 0xFF);
+    mtk_sensor_write(PMW_REG_REST1_RATE_H, (PMW_REST1_PERIOD_MS - 1) >> 8);
+    mtk_sensor_write(PMW_REG_REST1_DOWNSHIFT, rest1_down);
+    mtk_sensor_write(PMW_REG_REST2_RATE_L, (PMW_REST2_PERIOD_MS - 1) & 0xFF);
+    mtk_sensor_write(PMW_REG_REST2_RATE_H, (PMW_REST2_PERIOD_MS - 1) >> 8);
+    mtk_sensor_write(PMW_REG_REST2_DOWNSHIFT, rest2_down);
+    mtk_sensor_write(PMW_REG_REST3_RATE_L, (PMW_REST3_PERIOD_MS - 1) & 0xFF);
+    mtk_sensor_write(PMW_REG_REST3_RATE_H, (PMW_REST3_PERIOD_MS - 1) >> 8);
+    written = downshift;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ポインティングデバイスドライバ（POINTING_DEVICE_DRIVER = custom）
+
+/****************************************************************************
+ * pointing_device_driver_init
+ *
+ * センサーを初期化し、SPI1 を直接操作に切り替えて core 1 を起動する。
+ * ****************************************************************************/
+void pointing_device_driver_init(void) {
+    spi_init();
+    gpio_set_pin_output(PMW33XX_CS_PIN);
+    gpio_write_pin_high(PMW33XX_CS_PIN);
+
+    // 電源投入とリセット
+    sensor_init_write(PMW_REG_SHUTDOWN, 0xB6);
+    wait_ms(300);
+    spi_start(PMW33XX_CS_PIN, false, 3, PMW_SPI_DIVISOR);
+    wait_us(40);
+    spi_stop();
+    wait_us(40);
+    sensor_init_write(PMW_REG_POWER_UP_RESET, 0x5A);
+    wait_ms(50);
+
+    // 移動量のレジスタを読み捨てる
+    sensor_init_read(PMW_REG_MOTION);
+    sensor_init_read(PMW_REG_DELTA_X_L);
+    sensor_init_read(PMW_REG_DELTA_X_H);
+    sensor_init_read(PMW_REG_DELTA_Y_L);
+    sensor_init_read(PMW_REG_DELTA_Y_H);
+
+    if (!sensor_upload_srom()) {
+        dprintf("mtk_sensor: SROM upload failed\n");
+    }
+    wait_ms(10);
+    sensor_init_write(PMW_REG_LIFT_CONFIG, PMW33XX_LIFTOFF_DISTANCE);
+
+    // バースト受信用のDMAチャネルを確保し、以降は SPI1 を直接操作する
+    if (!sensor_dma_alloc()) {
+        dprintf("mtk_sensor: no DMA channel\n");
+        return;
+    }
+    sensor_spi_setup();
+    sensor_ready = true;
+    pointing_device_driver_set_cpi(sensor_cpi);
+
+#if MTK_SENSOR_CORE1
+    core1_launch();
+#endif
+}
+
+
+/****************************************************************************
+ * sensor_ring_drain
+ *
+ * リングバッファに溜まった移動量パケットをすべて読み、x, y に足す。
+ * パケットの読み取り時刻から now までの時間を統計に記録する。
+ * ****************************************************************************/
+static void sensor_ring_drain(int32_t *x, int32_t *y, uint32_t now) {
+    uint16_t tail = sensor_ring_tail;
+    while (tail != sensor_ring_head) {
+        sensor_barrier();             // head を読んでからパケットを読む
+        const mtk_sensor_packet_t *p = &sensor_ring[tail & (MTK_SENSOR_RING_SIZE - 1)];
+        uint32_t latency = now - p->time_us;
+        report_stats.latency_sum_us += latency;
+        if (latency > report_stats.latency_max_us) {
+            report_stats.latency_max_us = latency;
+        }
+        report_stats.latency_count++;
+        *x += p->dx;
+        *y += p->dy;
+        tail++;
+    }
+    sensor_barrier();                 // パケットを読み終えてから tail を進める
+    sensor_ring_tail = tail;
+}
+
+
+/****************************************************************************
+ * mtk_sensor_take_motion
+ *
+ * スレーブ側で、溜まった移動量をすべて x, y に足して取り出す。
+ * 分割キーボードのスレーブでは移動量をマウスレポートにせず、
+ * 専用のトランザクション（mtk_split.c）でマスターに送る。
+ * ****************************************************************************/
+void mtk_sensor_take_motion(int32_t *x, int32_t *y) {
+    if (!sensor_ready) {
+        return;
+    }
+    sensor_ring_drain(x, y, mtk_timer_read_us());
+}
+
+
+/****************************************************************************
+ * pointing_device_driver_get_report
+ *
+ * リングバッファに溜まった移動量パケットをすべて読み、合計をマウスレポートにする。
+ * core 1 を使わない場合は、ここでセンサー読み取りの状態機械を1段進める。
+ * SOF に同期する場合は、1フレームに1回だけ移動量を出す。
+ * パケットの読み取り時刻からレポートにするまでの時間を統計に記録する。
+ * 分割キーボードのスレーブでは移動量を読まずに残しておく（mtk_sensor_take_motion）。
+ * ****************************************************************************/
+report_mouse_t pointing_device_driver_get_report(report_mouse_t mouse_report) {
+    if (!sensor_ready) {
+        return mouse_report;
+    }
+    if (!sensor_core1) {
+        sensor_step();
+    }
+#ifdef SPLIT_KEYBOARD
+    if (!is_keyboard_master()) {
+        return mouse_report;          // 移動量は専用のトランザクションで送る
+    }
+#endif
+
+    uint32_t now = mtk_timer_read_us();
+    if (sensor_ring_tail == sensor_ring_head && sensor_carry_x == 0 && sensor_carry_y == 0) {
+        return mouse_report;          // 新しいパケットなし
+    }
+#if MTK_SENSOR_SOF_SYNC
+    // 同じフレームではレポートを1回だけ出す
+    uint16_t frame = RP_USB_SOF_RD & RP_USB_SOF_FRAME_MASK;
+    if (sensor_sof_active(now)) {
+        if (frame == report_frame) {
+            return mouse_report;
+        }
+        report_frame = frame;
+    }
+#endif
+
+    int32_t x = sensor_carry_x;
+    int32_t y = sensor_carry_y;
+    sensor_ring_drain(&x, &y, now);
+    report_stats.reports++;
+
+    // レポートの範囲を超えた分は次回に繰り越す
+    mouse_report.x = x > INT16_MAX ? INT16_MAX : (x < -INT16_MAX ? -INT16_MAX : x);
+    mouse_report.y = y > INT16_MAX ? INT16_MAX : (y < -INT16_MAX ? -INT16_MAX : y);
+    sensor_carry_x = x - mouse_report.x;
+    sensor_carry_y = y - mouse_report.y;
+    return mouse_report;
+}
+
+
+/****************************************************************************
+ * pointing_device_driver_get_cpi / pointing_device_driver_set_cpi
+ *
+ * CPI の取得と設定。設定値の扱いは QMK の pmw33xx ドライバと同じ
+ * （CPI / PMW33XX_CPI_STEP - 1 をレジスタに書く）。
+ * ****************************************************************************/
+uint16_t pointing_device_driver_get_cpi(void) {
+    return sensor_cpi;
+}
+
+void pointing_device_driver_set_cpi(uint16_t cpi) {
+    uint16_t value = (cpi < PMW33XX_CPI_MIN ? PMW33XX_CPI_MIN : (cpi > PMW33XX_CPI_MAX ? PMW33XX_CPI_MAX : cpi)) / PMW33XX_CPI_STEP - 1;
+    sensor_cpi     = cpi;
+    mtk_sensor_write(PMW_REG_RESOLUTION_H, (value >> 8) & 0xFF);
+    mtk_sensor_write(PMW_REG_RESOLUTION_L, value & 0xFF);
+}
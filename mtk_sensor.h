@@ -0,0 +1,106 @@
+/*
+ * mtk_sensor.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールセンサー（PMW3389）のドライバ（POINTING_DEVICE_DRIVER = custom）。
+ * MTK_SENSOR_CORE1 が有効な場合は RP2040 の2つ目のコア（core 1）でセンサーを読み続け、
+ * 移動量のパケットをロックフリーのリングバッファ（単一生産者・単一消費者）で
+ * メインループ（core 0）に渡す。OLED の転送などでメインループが止まっていても
+ * ボールの読み取りは止まらない。
+ * モーションバーストの受信は DMA で行い、読み取りの統計を raw HID で読み出せる。
+ *
+ * ■raw HID コマンド（data[0] = MTK_SENSOR_HID_ID、data[1] = サブコマンド）
+ *   0x00 統計     → data[2..5]: 読み取り回数, data[6..9]: 転送バイト数, data[10..13]: 待たされた時間（us）,
+ *                   data[14..15]: 静止中の毎秒トランザクション数, data[16..17]: 移動中の毎秒トランザクション数,
+ *                   data[18..19]: 読み取りからレポートまでの平均時間（us）, data[20..21]: 同じく最大時間（us）,
+ *                   data[22..25]: レポート数
+ *   0x01 統計のクリア
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#ifndef MTK_SENSOR_CORE1
+#    define MTK_SENSOR_CORE1       1     // 1: core 1 でセンサーを読む、0: core 0 のメインループで読む
+#endif
+
+#ifndef MTK_SENSOR_POLL_US
+#    define MTK_SENSOR_POLL_US     250   // core 1 でのセンサーの読み取り周期（マイクロ秒、SOF に同期しない場合）
+#endif
+
+#ifndef MTK_SENSOR_SOF_SYNC
+#    define MTK_SENSOR_SOF_SYNC    1     // 1: USB の SOF に合わせて1フレームに1回読み、1回レポートを出す
+#endif
+
+#ifndef MTK_SENSOR_SOF_LEAD_US
+#    define MTK_SENSOR_SOF_LEAD_US 150   // 次の SOF の何マイクロ秒前にセンサーを読むか
+#endif
+
+#ifndef MTK_SENSOR_SOF_TIMEOUT_US
+#    define MTK_SENSOR_SOF_TIMEOUT_US 3000 // この時間 SOF が来なければ MTK_SENSOR_POLL_US ごとに読む
+#endif
+
+#ifndef MTK_SENSOR_RING_SIZE
+#    define MTK_SENSOR_RING_SIZE   64    // 移動量パケットのリングバッファのサイズ（2のべき乗）
+#endif
+
+// MTK_SENSOR_MOTION_PIN: センサーの MOTION 端子をつないだピン（例: GP11）。
+// config.h で定義すると、移動があるときだけセンサーを読む。
+
+#define MTK_SENSOR_HID_ID          0xE1  // raw HID のコマンドID
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+// core 1 からメインループに渡す移動量パケット
+typedef struct {
+    uint32_t time_us;   // 読み取り時刻（マイクロ秒）
+    int16_t  dx;        // 移動量X
+    int16_t  dy;        // 移動量Y
+} mtk_sensor_packet_t;
+
+// センサー読み取りの統計
+typedef struct {
+    uint32_t reads;                // モーションバーストの読み取り回数
+    uint32_t bytes;                // SPI で転送したバイト数
+    uint32_t blocked_us;           // SPI の転送で CPU が待たされた時間の合計（マイクロ秒）
+    uint32_t idle_transactions;    // 静止中の SPI トランザクション数
+    uint32_t moving_transactions;  // 移動中の SPI トランザクション数
+    uint32_t idle_us;              // 静止していた時間（マイクロ秒）
+    uint32_t moving_us;            // 移動していた時間（マイクロ秒）
+    uint32_t reports;              // 移動量をレポートにした回数（以下 core 0 だけが書き込む）
+    uint32_t latency_count;        // レポートにしたパケット数
+    uint32_t latency_sum_us;       // パケットの読み取りからレポートまでの時間の合計（マイクロ秒）
+    uint32_t latency_max_us;       // 同じく最大値（マイクロ秒）
+} mtk_sensor_stats_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// センサーのレジスタ書き込み（core 1 の動作中は core 1 に依頼する、初期化前は false）
+bool mtk_sensor_write(uint8_t reg, uint8_t value);
+
+// レストモードの有効/無効と移行時間（REST1 の滞在時間、REST2 の滞在時間）の設定（初期化前は false）
+bool mtk_sensor_set_rest(bool enabled);
+void mtk_sensor_set_rest_times(uint32_t rest2_ms, uint32_t rest3_ms);
+
+// 分割キーボードのスレーブで、溜まった移動量を x, y に足して取り出す
+void mtk_sensor_take_motion(int32_t *x, int32_t *y);
+
+// 読み取りの統計の取得
+void mtk_sensor_get_stats(mtk_sensor_stats_t *stats);
+
+// 1秒あたりの SPI トランザクション数（移動中・静止中）
+uint16_t mtk_sensor_get_transaction_rate(bool moving);
+
+// raw HID のコマンド処理（MTK_SENSOR_HID_ID 以外は false を返す）
+bool mtk_sensor_hid_command(uint8_t *data, uint8_t length);
@@ -0,0 +1,459 @@
+/*
+ * mtk_split.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * 分割キーボードの左右間の通信（フォーマットは mtk_split.h を参照）。
+ */
+
+#include "quantum.h"
+#include "transactions.h"
+#include "transport.h"
+#include "atomic_util.h"
+#include <string.h>
+#include "mtk_split.h"
+#include "mtk_sensor.h"
+#include "mtk64erp.h"
+
+#ifdef SPLIT_KEYBOARD
+
+// 移動量のサイズ（ヘッダの bit0..1）
+enum {
+    MOTION_EMPTY = 0,   // 移動なし
+    MOTION_INT8  = 1,   // int8 に収まる
+    MOTION_INT16 = 2,   // int16 が必要
+};
+
+#define MOTION_SIZE_MASK   0x03
+#define MOTION_SEQ_SHIFT   2
+#define MOTION_SEQ_MASK    0x3F
+#define MOTION_SEQ_NONE    0xFF   // 未受信（スレーブが送ることのない番号）
+
+// サイズごとの応答の長さ（ヘッダ + 移動量）
+static const uint8_t motion_length[] = {1, 1 + 2 * sizeof(int8_t), 1 + 2 * sizeof(int16_t)};
+
+// スレーブ側の状態
+static int32_t slave_x      = 0;      // まだ送っていない移動量X
+static int32_t slave_y      = 0;      // まだ送っていない移動量Y
+static int16_t slave_sent_x = 0;      // 送ったが確認応答が届いていない移動量X
+static int16_t slave_sent_y = 0;      // 送ったが確認応答が届いていない移動量Y
+static bool    slave_sent   = false;  // 確認応答待ちの移動量がある
+static uint8_t slave_seq    = 0;      // 最後に送った移動量のシーケンス番号
+
+// マスター側の状態
+static uint8_t  master_ack       = MOTION_SEQ_NONE;  // 最後に受け取った移動量のシーケンス番号
+static uint8_t  master_size      = MOTION_EMPTY;     // 次に要求する移動量のサイズ
+static uint32_t master_last_sync = 0;                // 最後に移動量トランザクションを行った時刻
+static bool     master_connected = false;            // 前回のスレーブとの接続状態
+
+// 設定と表示状態のスナップショット（スレーブ側）
+static mtk_split_state_t slave_state;                   // 受け取ったスナップショット
+static volatile bool     slave_state_received = false;  // 未適用のスナップショットがある
+
+// 設定と表示状態のスナップショット（マスター側）
+static uint8_t  state_version   = 1;      // 変更ごとに増える番号
+static uint8_t  state_acked     = 0;      // スレーブが受け取った番号
+static uint32_t state_last_sync = 0;      // 最後にスナップショットを送った時刻
+static bool     state_connected = false;  // 前回のスレーブとの接続状態
+
+// 通信の統計
+static mtk_split_stats_t split_stats        = {0};
+static uint32_t          rate_start         = 0;  // 集計区間の開始時刻
+static uint32_t          rate_transactions  = 0;  // 集計区間の開始時のトランザクション数
+static uint32_t          rate_bytes         = 0;  // 集計区間の開始時のバイト数
+static uint16_t          rate_tps           = 0;  // 直前の1秒間のトランザクション数
+static uint32_t          rate_bps           = 0;  // 直前の1秒間のバイト数
+static bool              split_failed[2]    = {false};  // トランザクションごとの前回の失敗（再送の判定用）
+
+// 往復時間の集計（1秒ごとに区切る）
+static uint32_t          rtt_count          = 0;           // 集計中の区間のトランザクション数
+static uint32_t          rtt_sum_us         = 0;           // 集計中の区間の往復時間の合計
+static uint16_t          rtt_min_us         = UINT16_MAX;  // 集計中の区間の最小値
+static uint16_t          rtt_max_us         = 0;           // 集計中の区間の最大値
+
+
+/****************************************************************************
+ * motion_size_of
+ *
+ * 移動量を送るのに必要なサイズを求める。
+ * ****************************************************************************/
+static uint8_t motion_size_of(int32_t x, int32_t y) {
+    if (x == 0 && y == 0) {
+        return MOTION_EMPTY;
+    }
+    if (x >= INT8_MIN && x <= INT8_MAX && y >= INT8_MIN && y <= INT8_MAX) {
+        return MOTION_INT8;
+    }
+    return MOTION_INT16;
+}
+
+
+/****************************************************************************
+ * motion_clamp
+ *
+ * 移動量を ±limit の範囲に制限する。
+ * ****************************************************************************/
+static int16_t motion_clamp(int32_t v, int32_t limit) {
+    return v > limit ? limit : (v < -limit ? -limit : v);
+}
+
+
+/****************************************************************************
+ * split_exec
+ *
+ * マスター側でトランザクションを1回行い、統計に数える。
+ * 往復時間（送信から応答の受信まで）を測り、同じトランザクションの前回が
+ * 失敗していた場合は再送として数える。
+ * ****************************************************************************/
+static bool split_exec(int8_t id, uint8_t in_len, const void *in_data, uint8_t out_len, void *out_data) {
+    bool *failed = &split_failed[id - MTK_SPLIT_MOTION];
+
+    split_stats.transactions++;
+    split_stats.bytes += in_len + out_len;
+    if (*failed) {
+        split_stats.retries++;
+    }
+
+    uint32_t start = mtk_timer_read_us();
+    *failed        = !transaction_rpc_exec(id, in_len, in_data, out_len, out_data);
+    uint32_t rtt   = mtk_timer_read_us() - start;
+
+    rtt_count++;
+    rtt_sum_us += rtt;
+    rtt_min_us = rtt < rtt_min_us ? rtt : rtt_min_us;
+    rtt_max_us = rtt > rtt_max_us ? (rtt > UINT16_MAX ? UINT16_MAX : rtt) : rtt_max_us;
+    if (*failed) {
+        split_stats.errors++;
+        return false;
+    }
+    return true;
+}
+
+
+/****************************************************************************
+ * motion_slave_handler
+ *
+ * スレーブ側の移動量トランザクションの処理。
+ * 前回送った移動量の確認応答が届いていなければ未送信の移動量に戻し、
+ * センサーの移動量を足してから、応答に入る分だけを新しいシーケンス番号で送る。
+ * ****************************************************************************/
+static void motion_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    uint8_t *out = out_data;
+    if (out_buflen < 1) {
+        return;
+    }
+
+    if (slave_sent) {
+        if (in_buflen < 1 || *(const uint8_t *)in_data != slave_seq) {
+            // マスターに届かなかったので次の応答で送り直す
+            slave_x += slave_sent_x;
+            slave_y += slave_sent_y;
+        }
+        slave_sent = false;
+    }
+
+    mtk_sensor_take_motion(&slave_x, &slave_y);
+    uint8_t size = motion_size_of(slave_x, slave_y);
+
+    if (size != MOTION_EMPTY && out_buflen >= motion_length[MOTION_INT8]) {
+        int16_t x, y;
+        if (out_buflen >= motion_length[MOTION_INT16]) {
+            x = motion_clamp(slave_x, INT16_MAX);
+            y = motion_clamp(slave_y, INT16_MAX);
+            memcpy(&out[1], &x, sizeof(x));
+            memcpy(&out[3], &y, sizeof(y));
+        } else {
+            x      = motion_clamp(slave_x, INT8_MAX);
+            y      = motion_clamp(slave_y, INT8_MAX);
+            out[1] = (int8_t)x;
+            out[2] = (int8_t)y;
+        }
+        slave_x -= x;
+        slave_y -= y;
+        slave_sent_x = x;
+        slave_sent_y = y;
+        slave_sent   = true;
+        slave_seq    = (slave_seq + 1) & MOTION_SEQ_MASK;
+    }
+
+    // サイズは送る前の移動量で知らせ、マスターは次回その長さで要求する
+    out[0] = size | (slave_seq << MOTION_SEQ_SHIFT);
+}
+
+
+/****************************************************************************
+ * motion_exec
+ *
+ * マスター側で移動量トランザクションを1回行い、新しい移動量を remote_motion に足す。
+ * 戻り値はスレーブに溜まっている移動量のサイズ。失敗した場合は size をそのまま返す。
+ * ****************************************************************************/
+static uint8_t motion_exec(uint8_t size) {
+    uint8_t buf[1 + 2 * sizeof(int16_t)];
+    uint8_t len = motion_length[size];
+
+    if (!split_exec(MTK_SPLIT_MOTION, sizeof(master_ack), &master_ack, len, buf)) {
+        return size;
+    }
+
+    uint8_t seq = (buf[0] >> MOTION_SEQ_SHIFT) & MOTION_SEQ_MASK;
+    if (len > 1 && seq != master_ack) {
+        int32_t x, y;
+        if (size == MOTION_INT16) {
+            int16_t x16, y16;
+            memcpy(&x16, &buf[1], sizeof(x16));
+            memcpy(&y16, &buf[3], sizeof(y16));
+            x = x16;
+            y = y16;
+        } else {
+            x = (int8_t)buf[1];
+            y = (int8_t)buf[2];
+        }
+        remote_motion.x = motion_clamp(remote_motion.x + x, INT16_MAX);
+        remote_motion.y = motion_clamp(remote_motion.y + y, INT16_MAX);
+        master_ack      = seq;
+    }
+    return buf[0] & MOTION_SIZE_MASK;
+}
+
+
+/****************************************************************************
+ * state_slave_handler
+ *
+ * スレーブ側のスナップショットのトランザクションの処理。
+ * 受け取ったスナップショットを保存し、適用は housekeeping（mtk_split_task）で行う。
+ * 応答には受け取った変更番号を返す。形式が違う場合は何もしない。
+ * ****************************************************************************/
+static void state_slave_handler(uint8_t in_buflen, const void *in_data, uint8_t out_buflen, void *out_data) {
+    const mtk_split_state_t *state = in_data;
+    if (in_buflen != sizeof(mtk_split_state_t) || out_buflen < 1 || state->format != MTK_SPLIT_STATE_FORMAT) {
+        return;
+    }
+    memcpy(&slave_state, state, sizeof(slave_state));
+    slave_state_received = true;
+    *(uint8_t *)out_data = state->version;
+}
+
+
+/****************************************************************************
+ * state_sync
+ *
+ * マスター側で、設定や表示状態が変わっていればスナップショットをスレーブに送る。
+ * 変更がなければ通信しない。スレーブとの接続が切れて戻った場合は、
+ * スレーブが再起動した可能性があるので変更がなくても送り直す。
+ * 送信は MTK_SPLIT_STATE_INTERVAL_MS ごとにまとめる。
+ * ****************************************************************************/
+static void state_sync(void) {
+    bool connected = is_transport_connected();
+    if (connected && !state_connected) {
+        state_acked = state_version - 1;
+    } else if (!connected && state_connected) {
+        split_stats.disconnects++;
+    }
+    state_connected = connected;
+    if (!connected || state_acked == state_version) {
+        return;
+    }
+    if (timer_elapsed32(state_last_sync) < MTK_SPLIT_STATE_INTERVAL_MS) {
+        return;
+    }
+    state_last_sync = timer_read32();
+
+    mtk_split_state_t state;
+    mtk_get_split_state(&state);
+    state.format  = MTK_SPLIT_STATE_FORMAT;
+    state.version = state_version;
+
+    uint8_t ack = 0;
+    if (split_exec(MTK_SPLIT_STATE, sizeof(state), &state, sizeof(ack), &ack) && ack == state.version) {
+        state_acked = state.version;
+    }
+}
+
+
+/****************************************************************************
+ * state_apply
+ *
+ * スレーブ側で、受け取ったスナップショットを設定と表示状態に反映する。
+ * ****************************************************************************/
+static void state_apply(void) {
+    if (!slave_state_received) {
+        return;
+    }
+    mtk_split_state_t state;
+    ATOMIC_BLOCK_FORCEON {
+        memcpy(&state, &slave_state, sizeof(state));
+        slave_state_received = false;
+    }
+    mtk_set_split_state(&state);
+}
+
+
+/****************************************************************************
+ * split_rate_update
+ *
+ * 1秒ごとにトランザクション数とバイト数の増分を毎秒の値として記録する。
+ * 往復時間の最小・平均・最大も直前の1秒間の値にする。
+ * ****************************************************************************/
+static void split_rate_update(void) {
+    if (timer_elapsed32(rate_start) < 1000) {
+        return;
+    }
+    uint32_t tps      = split_stats.transactions - rate_transactions;
+    rate_tps          = tps > UINT16_MAX ? UINT16_MAX : tps;
+    rate_bps          = split_stats.bytes - rate_bytes;
+    rate_transactions = split_stats.transactions;
+    rate_bytes        = split_stats.bytes;
+    rate_start        = timer_read32();
+
+    split_stats.rtt_min_us = rtt_count ? rtt_min_us : 0;
+    split_stats.rtt_avg_us = rtt_count ? rtt_sum_us / rtt_count : 0;
+    split_stats.rtt_max_us = rtt_max_us;
+    rtt_count              = 0;
+    rtt_sum_us             = 0;
+    rtt_min_us             = UINT16_MAX;
+    rtt_max_us             = 0;
+}
+
+
+/****************************************************************************
+ * mtk_split_init
+ *
+ * スレーブ側の処理をトランザクションに登録する。
+ * ****************************************************************************/
+void mtk_split_init(void) {
+    transaction_register_rpc(MTK_SPLIT_MOTION, motion_slave_handler);
+    transaction_register_rpc(MTK_SPLIT_STATE, state_slave_handler);
+    rate_start = timer_read32();
+}
+
+
+/****************************************************************************
+ * mtk_split_motion_sync
+ *
+ * MTK_SPLIT_MOTION_INTERVAL_MS ごとにスレーブ側の移動量を受け取り、remote_motion に足す。
+ * 静止中はヘッダの1バイトだけを要求し、移動が始まったら同じ周期のうちに移動量を取りに行く。
+ * 移動中は前回のサイズの長さで要求するので、1周期に1回のトランザクションで済む。
+ * スレーブとの接続が切れて戻った場合は、スレーブが再起動してシーケンス番号が0からやり直している
+ * 可能性があるので、受け取った番号を未受信に戻す（最初の移動量を重複として捨てないため）。
+ * ****************************************************************************/
+void mtk_split_motion_sync(void) {
+    if (!is_keyboard_master()) {
+        return;
+    }
+    split_rate_update();
+    if (timer_elapsed32(master_last_sync) < MTK_SPLIT_MOTION_INTERVAL_MS) {
+        return;
+    }
+    master_last_sync = timer_read32();
+
+    bool connected = is_transport_connected();
+    if (connected && !master_connected) {
+        master_ack  = MOTION_SEQ_NONE;
+        master_size = MOTION_EMPTY;
+    }
+    master_connected = connected;
+
+    uint8_t size = motion_exec(master_size);
+    if (master_size == MOTION_EMPTY && size != MOTION_EMPTY) {
+        size = motion_exec(size);
+    }
+    master_size = size;
+}
+
+
+/****************************************************************************
+ * mtk_split_state_changed
+ *
+ * 設定や表示状態が変わったことを記録する。値が実際に変わったときに setter から呼ぶ。
+ * ****************************************************************************/
+void mtk_split_state_changed(void) {
+    state_version++;
+}
+
+
+/****************************************************************************
+ * mtk_split_task
+ *
+ * housekeeping から呼ぶ定期処理。
+ * マスターは変更があればスナップショットを送り、スレーブは受け取ったものを反映する。
+ * ****************************************************************************/
+void mtk_split_task(void) {
+    if (is_keyboard_master()) {
+        state_sync();
+    } else {
+        state_apply();
+    }
+}
+
+
+/****************************************************************************
+ * mtk_split_get_stats
+ *
+ * 左右間の通信の統計（トランザクション数・転送バイト数・失敗数・再送数・
+ * 切断回数・往復時間）を取得する。
+ * ****************************************************************************/
+void mtk_split_get_stats(mtk_split_stats_t *stats) {
+    *stats = split_stats;
+}
+
+
+/****************************************************************************
+ * mtk_split_get_transaction_rate / mtk_split_get_byte_rate
+ *
+ * 直前の1秒間のトランザクション数とバイト数を取得する。
+ * ****************************************************************************/
+uint16_t mtk_split_get_transaction_rate(void) {
+    return rate_tps;
+}
+
+uint32_t mtk_split_get_byte_rate(void) {
+    return rate_bps;
+}
+
+
+/****************************************************************************
+ * mtk_split_hid_command
+ *
+ * raw HID で受け取った通信統計のコマンドを処理し、応答を data に書き込む。
+ *   data[1] = 0x00: 統計の取得 → data[2..5]: トランザクション数, data[6..9]: 転送バイト数,
+ *                               data[10..13]: 失敗数, data[14..15]: 毎秒トランザクション数,
+ *                               data[16..19]: 毎秒バイト数、いずれもリトルエンディアン
+ *   data[1] = 0x01: 統計のクリア
+ *   data[1] = 0x02: 通信の状態 → data[2..5]: 再送数, data[6..9]: 切断回数,
+ *                               data[10..11]: 往復時間の最小（us）, data[12..13]: 平均, data[14..15]: 最大,
+ *                               data[16]: 接続中
+ * ****************************************************************************/
+bool mtk_split_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 20 || data[0] != MTK_SPLIT_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case 0x00:
+            memcpy(&data[2], &split_stats.transactions, 4);
+            memcpy(&data[6], &split_stats.bytes, 4);
+            memcpy(&data[10], &split_stats.errors, 4);
+            memcpy(&data[14], &rate_tps, 2);
+            memcpy(&data[16], &rate_bps, 4);
+            break;
+        case 0x01:
+            split_stats       = (mtk_split_stats_t){0};
+            rate_transactions = 0;
+            rate_bytes        = 0;
+            break;
+        case 0x02:
+            memcpy(&data[2], &split_stats.retries, 4);
+            memcpy(&data[6], &split_stats.disconnects, 4);
+            memcpy(&data[10], &split_stats.rtt_min_us, 2);
+            memcpy(&data[12], &split_stats.rtt_avg_us, 2);
+            memcpy(&data[14], &split_stats.rtt_max_us, 2);
+            data[16] = is_transport_connected();
+            break;
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
+
+#endif // SPLIT_KEYBOARD
@@ -0,0 +1,126 @@
+/*
+ * mtk_split.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * 分割キーボードの左右間の通信（SPLIT_TRANSACTION_IDS_KB のトランザクション）。
+ * スレーブ側のトラックボールの移動量を専用のトランザクションでマスターに送り、
+ * remote_motion に溜める。QMK 標準のポインティングデバイスの同期はボタンだけに使う。
+ *
+ * ■移動量トランザクション（MTK_SPLIT_MOTION）
+ *   マスター → スレーブ: [0] 受け取った最後のシーケンス番号（確認応答）
+ *   スレーブ → マスター: [0] ヘッダ（bit0..1: 溜まっている移動量のサイズ、bit2..7: シーケンス番号）
+ *                        [1..] 移動量（int8 x, y または int16 x, y、リトルエンディアン）
+ *   応答の長さはマスターが前回のヘッダのサイズから決める（静止中はヘッダの1バイトだけ）。
+ *   移動量が応答に入りきらない場合は入る分だけ送り、残りはスレーブに残す。
+ *   スレーブは確認応答が届くまで送った移動量を保持し、届かなければ次の応答に足して送り直す。
+ *   マスターはスレーブとの接続が戻ったら確認応答を 0xFF（未受信）に戻す（スレーブの再起動で番号が戻るため）。
+ *
+ * ■設定と表示状態のトランザクション（MTK_SPLIT_STATE）
+ *   マスター → スレーブ: mtk_split_state_t（CPI・スクロールモード・自動マウスなどの設定と、
+ *                        打鍵数・最後に押したキー）
+ *   スレーブ → マスター: [0] 受け取った変更番号
+ *   setter で値が実際に変わったときだけ変更番号を進め、スレーブが受け取った番号と違う間だけ送る。
+ *   スレーブは受け取った内容を OLED の表示に使う。
+ *
+ * ■raw HID コマンド（data[0] = MTK_SPLIT_HID_ID、data[1] = サブコマンド）
+ *   0x00 統計     → data[2..5]: トランザクション数, data[6..9]: 転送バイト数, data[10..13]: 失敗数,
+ *                   data[14..15]: 毎秒トランザクション数, data[16..19]: 毎秒バイト数
+ *   0x01 統計のクリア
+ *   0x02 通信の状態 → data[2..5]: 再送数, data[6..9]: 切断回数,
+ *                     data[10..11]: 往復時間の最小（us）, data[12..13]: 平均, data[14..15]: 最大,
+ *                     data[16]: 接続中
+ *   往復時間は直前の1秒間の値。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#ifndef MTK_SPLIT_MOTION_INTERVAL_MS
+#    define MTK_SPLIT_MOTION_INTERVAL_MS  1   // 移動量トランザクションの間隔（ミリ秒）
+#endif
+
+#ifndef MTK_SPLIT_STATE_INTERVAL_MS
+#    define MTK_SPLIT_STATE_INTERVAL_MS   50  // 設定と表示状態を送る最短の間隔（ミリ秒）
+#endif
+
+#define MTK_SPLIT_STATE_FORMAT            1   // mtk_split_state_t の形式の番号（変えたら増やす）
+
+// mtk_split_state_t.flags
+#define MTK_SPLIT_STATE_SCROLL            0x01  // スクロールモード
+#define MTK_SPLIT_STATE_AUTO_MOUSE        0x02  // 自動マウスモード
+#define MTK_SPLIT_STATE_EDIT_LEFT         0x04  // 左側の設定を変更中
+#define MTK_SPLIT_STATE_ADJUST_L          0x08  // 左側の速度調整が有効
+#define MTK_SPLIT_STATE_ADJUST_R          0x10  // 右側の速度調整が有効
+#define MTK_SPLIT_STATE_SCROLL_ALWAYS_L   0x20  // 左側は常にスクロール
+#define MTK_SPLIT_STATE_SCROLL_ALWAYS_R   0x40  // 右側は常にスクロール
+
+#define MTK_SPLIT_HID_ID                  0xE3  // raw HID のコマンドID
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+// マスターからスレーブに送る設定と表示状態（リトルエンディアン、21バイト）
+typedef struct __attribute__((__packed__)) {
+    uint8_t  format;                 // MTK_SPLIT_STATE_FORMAT
+    uint8_t  version;                // 変更番号
+    uint16_t cpi[2];                 // CPI（左, 右）
+    uint8_t  speed_adjust_value[2];  // 速度調整値（左, 右）
+    uint8_t  scroll_snap_mode[2];    // スクロールスナップモード（左, 右）
+    uint8_t  scroll_div;             // スクロール分割値
+    uint16_t auto_mouse_time_out;    // 自動マウスのタイムアウト
+    uint8_t  flags;                  // MTK_SPLIT_STATE_*
+    uint32_t type_count;             // 打鍵数
+    uint16_t keylog_keycode;         // 最後に押したキーのキーコード
+    uint8_t  keylog_row;             // 同じく行
+    uint8_t  keylog_col;             // 同じく列
+} mtk_split_state_t;
+
+// 左右間の通信の統計（マスター側で数える）
+typedef struct {
+    uint32_t transactions;   // トランザクション数
+    uint32_t bytes;          // 転送バイト数（送信と受信の合計、トランザクションのデータ部分）
+    uint32_t errors;         // 失敗したトランザクション数
+    uint32_t retries;        // 前回が失敗したトランザクションの再送数
+    uint32_t disconnects;    // スレーブとの接続が切れた回数
+    uint16_t rtt_min_us;     // 直前の1秒間の往復時間の最小値（マイクロ秒）
+    uint16_t rtt_avg_us;     // 同じく平均値
+    uint16_t rtt_max_us;     // 同じく最大値
+} mtk_split_stats_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// トランザクションの登録（keyboard_post_init_kb から呼ぶ）
+void mtk_split_init(void);
+
+// スレーブ側の移動量を受け取って remote_motion に足す（マスターのポインタ処理から呼ぶ）
+void mtk_split_motion_sync(void);
+
+// 設定や表示状態が変わったことの記録（setter から呼ぶ）
+void mtk_split_state_changed(void);
+
+// スナップショットの作成（マスター）と反映（スレーブ）、mtk64erp.c で実装
+void mtk_get_split_state(mtk_split_state_t *state);
+void mtk_set_split_state(const mtk_split_state_t *state);
+
+// 定期処理（housekeeping_task_kb から呼ぶ）
+void mtk_split_task(void);
+
+// 通信の統計の取得
+void mtk_split_get_stats(mtk_split_stats_t *stats);
+
+// 1秒あたりのトランザクション数とバイト数
+uint16_t mtk_split_get_transaction_rate(void);
+uint32_t mtk_split_get_byte_rate(void);
+
+// raw HID のコマンド処理（MTK_SPLIT_HID_ID 以外は false を返す）
+bool mtk_split_hid_command(uint8_t *data, uint8_t length);
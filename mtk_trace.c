@@ -0,0 +1,155 @@
+/*
+ * mtk_trace.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールの移動量のトレース記録（フォーマットは mtk_trace.h を参照）。
+ */
+
+#include "mtk_trace.h"
+#include "mtk64erp.h"
+#include <string.h>
+
+_Static_assert((MTK_TRACE_SIZE & (MTK_TRACE_SIZE - 1)) == 0, "MTK_TRACE_SIZE must be a power of two");
+_Static_assert(sizeof(mtk_trace_record_t) == 18, "mtk_trace_record_t layout changed");
+
+// raw HID のサブコマンド
+enum {
+    MTK_TRACE_CMD_STATUS = 0x00,  // 状態の取得
+    MTK_TRACE_CMD_ARM    = 0x01,  // 記録開始
+    MTK_TRACE_CMD_DISARM = 0x02,  // 記録停止
+    MTK_TRACE_CMD_READ   = 0x03,  // レコードの読み出し
+};
+
+static mtk_trace_record_t trace_buf[MTK_TRACE_SIZE];  // リングバッファ
+static uint16_t           trace_head  = 0;            // 次に書き込む位置
+static uint16_t           trace_count = 0;            // 記録済みのレコード数
+static bool               trace_armed = false;        // 記録中フラグ
+static uint16_t           trace_state = 0xFFFF;       // 直前に記録したボタンとフラグ（0xFFFF: 未記録）
+
+
+/****************************************************************************
+ * mtk_trace_arm
+ *
+ * バッファをクリアして記録を開始する。
+ * ****************************************************************************/
+void mtk_trace_arm(void) {
+    trace_head  = 0;
+    trace_count = 0;
+    trace_state = 0xFFFF;
+    trace_armed = true;
+}
+
+
+/****************************************************************************
+ * mtk_trace_disarm
+ *
+ * 記録を停止する。記録済みのレコードは読み出せるよう残しておく。
+ * ****************************************************************************/
+void mtk_trace_disarm(void) {
+    trace_armed = false;
+}
+
+
+/****************************************************************************
+ * mtk_trace_is_armed
+ *
+ * 記録中かどうかを取得する。
+ * ****************************************************************************/
+bool mtk_trace_is_armed(void) {
+    return trace_armed;
+}
+
+
+/****************************************************************************
+ * mtk_trace_count
+ *
+ * 記録済みのレコード数を取得する（最大 MTK_TRACE_SIZE）。
+ * ****************************************************************************/
+uint16_t mtk_trace_count(void) {
+    return trace_count;
+}
+
+
+/****************************************************************************
+ * mtk_trace_record
+ *
+ * 1レポート分をリングバッファに記録する。
+ * pointing_device_task_kb から毎回呼ばれるため、記録停止中はすぐに戻り、
+ * 記録中もレコード1件の書き込みだけを行う。満杯になったら古いものから上書きする。
+ * 移動量がすべて 0 で、ボタンとフラグも直前の記録から変わらないレポートは記録しない
+ * （POINTING_DEVICE_TASK_THROTTLE_MS が 0 のため、止まっている間の呼び出しでバッファが埋まらないように）。
+ * 止まっていた時間は time_us の間隔から分かる。
+ * ****************************************************************************/
+void mtk_trace_record(int16_t dx, int16_t dy, const report_mouse_t *report, uint8_t flags) {
+    if (!trace_armed) {
+        return;
+    }
+
+    uint16_t state = report->buttons | (flags << 8);
+    if ((dx | dy | report->x | report->y | report->h | report->v) == 0 && state == trace_state) {
+        return;
+    }
+    trace_state = state;
+
+    mtk_trace_record_t *r = &trace_buf[trace_head];
+    r->time_us = mtk_timer_read_us();
+    r->dx      = dx;
+    r->dy      = dy;
+    r->x       = report->x;
+    r->y       = report->y;
+    r->h       = report->h;
+    r->v       = report->v;
+    r->buttons = report->buttons;
+    r->flags   = flags;
+
+    trace_head = (trace_head + 1) & (MTK_TRACE_SIZE - 1);
+    if (trace_count < MTK_TRACE_SIZE) {
+        trace_count++;
+    }
+}
+
+
+/****************************************************************************
+ * mtk_trace_hid_command
+ *
+ * raw HID で受け取ったトレースのコマンドを処理し、応答を data に書き込む。
+ * 応答の送信は呼び出し元で行う。
+ * ****************************************************************************/
+bool mtk_trace_hid_command(uint8_t *data, uint8_t length) {
+    if (length < 4 || data[0] != MTK_TRACE_HID_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case MTK_TRACE_CMD_STATUS:
+            data[2] = trace_armed;
+            data[3] = trace_count & 0xFF;
+            data[4] = trace_count >> 8;
+            data[5] = MTK_TRACE_SIZE & 0xFF;
+            data[6] = MTK_TRACE_SIZE >> 8;
+            data[7] = sizeof(mtk_trace_record_t);
+            break;
+        case MTK_TRACE_CMD_ARM:
+            mtk_trace_arm();
+            break;
+        case MTK_TRACE_CMD_DISARM:
+            mtk_trace_disarm();
+            break;
+        case MTK_TRACE_CMD_READ: {
+            // 古い方から数えた番号でレコードを返す
+            uint16_t index = data[2] | (data[3] << 8);
+            if (index >= trace_count || length < 4 + sizeof(mtk_trace_record_t)) {
+                data[1] = 0xFF;
+                break;
+            }
+            uint16_t pos = (trace_head - trace_count + index) & (MTK_TRACE_SIZE - 1);
+            memcpy(&data[4], &trace_buf[pos], sizeof(mtk_trace_record_t));
+            break;
+        }
+        default:
+            data[1] = 0xFF;  // 未対応のサブコマンド
+            break;
+    }
+    return true;
+}
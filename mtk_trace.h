@@ -0,0 +1,74 @@
+/*
+ * mtk_trace.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トラックボールの移動量のトレース記録。
+ * センサーの生の移動量と、変換後のマウスレポートを時刻付きでRAMのリングバッファに記録し、
+ * raw HID で読み出す。速度調整やスクロールスナップの調整用。
+ * 移動量がすべて 0 で、ボタンとフラグも変わらないレポートは記録しない。
+ *
+ * ■記録フォーマット（mtk_trace_record_t、リトルエンディアン、18バイト）
+ *   offset 0  uint32 time_us   記録時刻（マイクロ秒、RP2040 の TIMERAWL）
+ *   offset 4  int16  dx, dy    センサーの生の移動量
+ *   offset 8  int16  x, y      変換後のマウスレポートの移動量
+ *   offset 12 int16  h, v      変換後のマウスレポートのホイール量
+ *   offset 16 uint8  buttons   マウスボタン
+ *   offset 17 uint8  flags     bit0: スクロールモード
+ *
+ * ■raw HID コマンド（data[0] = MTK_TRACE_HID_ID、data[1] = サブコマンド）
+ *   0x00 状態     → data[2]: 記録中, data[3..4]: 記録数, data[5..6]: 容量, data[7]: レコード長
+ *   0x01 記録開始（バッファをクリアして開始）
+ *   0x02 記録停止
+ *   0x03 読み出し data[2..3]: 古い方からの番号 → data[4..]: レコード1件
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "report.h"             // report_mouse_t
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 定数定義
+
+#ifndef MTK_TRACE_SIZE
+#    define MTK_TRACE_SIZE         512   // 記録できるレコード数（2のべき乗）
+#endif
+
+#define MTK_TRACE_HID_ID           0xE0  // raw HID のコマンドID
+
+#define MTK_TRACE_FLAG_SCROLL      0x01  // スクロールモード中の記録
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 構造体定義
+
+typedef struct __attribute__((__packed__)) {
+    uint32_t time_us;   // 記録時刻（マイクロ秒）
+    int16_t  dx;        // センサーの生の移動量X
+    int16_t  dy;        // センサーの生の移動量Y
+    int16_t  x;         // マウスレポートの移動量X
+    int16_t  y;         // マウスレポートの移動量Y
+    int16_t  h;         // マウスレポートの水平ホイール量
+    int16_t  v;         // マウスレポートの垂直ホイール量
+    uint8_t  buttons;   // マウスボタン
+    uint8_t  flags;     // MTK_TRACE_FLAG_*
+} mtk_trace_record_t;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 関数プロトタイプ
+
+// 記録の開始・停止と状態の取得
+void mtk_trace_arm(void);
+void mtk_trace_disarm(void);
+bool mtk_trace_is_armed(void);
+uint16_t mtk_trace_count(void);
+
+// 1レポート分の記録（記録停止中と、動きも変化もないレポートは何もしない）
+void mtk_trace_record(int16_t dx, int16_t dy, const report_mouse_t *report, uint8_t flags);
+
+// raw HID のコマンド処理（MTK_TRACE_HID_ID 以外は false を返す）
+bool mtk_trace_hid_command(uint8_t *data, uint8_t length);
@@ -11,9 +11,33 @@ LTO_ENABLE = yes
 
 #  Trackball.
 POINTING_DEVICE_ENABLE = yes
-POINTING_DEVICE_DRIVER = pmw3389
+POINTING_DEVICE_DRIVER = custom   # PMW3389 を mtk_sensor.c で core 1 から読む
 SERIAL_DRIVER = vendor
 SPI_DRIVER_REQUIRED = yes
 USE_DEVICE_pmw3389 = yes
 
 
+
+# ポインタ処理（速度調整・スクロール）とトレース記録
+SRC += mtk_pointer.c
+SRC += mtk_trace.c
+SRC += mtk_sensor.c
+SRC += mtk_split.c
+
+# 行と列でピンを共有するマトリクスのスキャン（標準のスキャナと比べる場合は CUSTOM_MATRIX を外す）
+CUSTOM_MATRIX = lite
+SRC += mtk_matrix.c
+
+# キーごとのチャタリング除去（押下はすぐ、離しは DEBOUNCE ミリ秒後に反映）
+DEBOUNCE_TYPE = custom
+SRC += mtk_debounce.c
+
+# ループ時間とキー入力からレポートまでの時間の計測
+SRC += mtk_latency.c
+
+# OLED の転送を DMA で行い、メインループを止めない（QMK の I2C 転送に戻す場合は OLED_TRANSPORT を外す）
+OLED_TRANSPORT = custom
+SRC += mtk_oled.c
+
+# OLED 表示用の整数の書式化（snprintf の代わり）
+SRC += mtk_fmt.c
@@ -0,0 +1,81 @@
+/*
+ * tests/host.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテストの共通部分（host.h を参照）。
+ */
+
+#include "host.h"
+#include "timer.h"
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#    include <x86intrin.h>
+#endif
+
+uint32_t host_time_ms  = 0;
+unsigned host_checks   = 0;
+unsigned host_failures = 0;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// timer.h
+
+uint16_t timer_read(void) {
+    return (uint16_t)host_time_ms;
+}
+
+uint32_t timer_read32(void) {
+    return host_time_ms;
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return TIMER_DIFF_16(timer_read(), last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return TIMER_DIFF_32(timer_read32(), last);
+}
+
+
+/****************************************************************************
+ * host_summary
+ *
+ * 判定の結果を表示し、失敗があれば 1 を返す。
+ * ****************************************************************************/
+int host_summary(const char *name) {
+    printf("%s: %u checks, %u failed\n", name, host_checks, host_failures);
+    return host_failures == 0 ? 0 : 1;
+}
+
+
+/****************************************************************************
+ * host_cycles
+ *
+ * ベンチマーク用のサイクルカウンタを読む。
+ * ****************************************************************************/
+uint64_t host_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+
+/****************************************************************************
+ * host_bench_enabled
+ *
+ * 引数に --bench があればベンチマークも実行する。
+ * ****************************************************************************/
+bool host_bench_enabled(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+/*
+ * tests/host.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテストの共通部分。
+ * タイマーの代わりになる時刻、結果の判定、ベンチマーク用のサイクルカウンタをまとめている。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 時刻（timer_read などはこの値を返す）
+
+extern uint32_t host_time_ms;
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 判定
+
+extern unsigned host_checks;    // 判定した回数
+extern unsigned host_failures;  // 失敗した回数
+
+// 条件が偽なら場所とメッセージを表示して失敗を数える（テストは続ける）
+#define CHECK(cond, ...)                                                   \
+    do {                                                                   \
+        host_checks++;                                                     \
+        if (!(cond)) {                                                     \
+            host_failures++;                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed: ", __FILE__, __LINE__, #cond); \
+            fprintf(stderr, __VA_ARGS__);                                  \
+            fputc('\n', stderr);                                           \
+        }                                                                  \
+    } while (0)
+
+// 結果を表示し、終了コードを返す
+int host_summary(const char *name);
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ベンチマーク
+
+// サイクルカウンタ（x86 は TSC、それ以外はナノ秒）
+uint64_t host_cycles(void);
+
+// ベンチマークを実行するか（引数に --bench があるとき）
+bool host_bench_enabled(int argc, char **argv);
+
+// 最適化で計算が消えないよう値を使ったことにする
+#define HOST_KEEP(v) __asm__ volatile("" : : "r"(v) : "memory")
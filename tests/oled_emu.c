@@ -0,0 +1,250 @@
+/*
+ * tests/oled_emu.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * QMK の oled_driver.c のうち、描画バッファに書く部分をホストで再現する。
+ * カーソルの進め方・行末の扱い・oled_write_ln の空白埋めは QMK と同じにしている
+ * （I2C の転送とスクロールは扱わない）。フォントは config.h と同じ glcdfont.c を使う。
+ *
+ * 回転は描画バッファの並びだけに効く。90度・270度では1行が64ドット（10文字）で16行になり、
+ * 画面を回して読んだ向きはバッファの並びのままなので、画像もバッファの並びで書き出す。
+ */
+
+#include "oled_emu.h"
+#include <stdio.h>
+#include <string.h>
+#include "glcdfont.c"
+
+_Static_assert(sizeof(font) >= (OLED_FONT_END + 1 - OLED_FONT_START) * OLED_FONT_WIDTH, "font is smaller than OLED_FONT_END");
+
+static uint8_t         oled_buffer[OLED_MATRIX_SIZE];
+static uint16_t        oled_cursor         = 0;                   // 描画バッファ上のカーソルの位置
+static oled_rotation_t oled_rotation       = OLED_ROTATION_0;
+static uint8_t         oled_rotation_width = OLED_DISPLAY_WIDTH;  // 回転後の1行のドット数
+
+
+/****************************************************************************
+ * oled_init
+ *
+ * QMK と同じく oled_init_kb で回転を決め、描画バッファを消す。
+ * ****************************************************************************/
+bool oled_init(oled_rotation_t rotation) {
+    oled_rotation       = oled_init_kb(rotation);
+    oled_rotation_width = (oled_rotation & OLED_ROTATION_90) ? OLED_DISPLAY_HEIGHT : OLED_DISPLAY_WIDTH;
+    oled_clear();
+    return true;
+}
+
+
+void oled_clear(void) {
+    memset(oled_buffer, 0, sizeof(oled_buffer));
+    oled_cursor = 0;
+}
+
+
+/****************************************************************************
+ * oled_set_cursor
+ *
+ * 画面の外を指定した場合は先頭に戻る（QMK と同じ）。
+ * ****************************************************************************/
+void oled_set_cursor(uint8_t col, uint8_t line) {
+    uint16_t index = line * oled_rotation_width + col * OLED_FONT_WIDTH;
+    oled_cursor    = index >= OLED_MATRIX_SIZE ? 0 : index;
+}
+
+
+/****************************************************************************
+ * oled_advance_page
+ *
+ * clear_page が true なら行の残りを空白で埋めて次の行へ、false ならそのまま次の行へ進む。
+ * QMK と同じく、行頭で空白を埋めると1行分を埋める。
+ * ****************************************************************************/
+void oled_advance_page(bool clear_page) {
+    uint16_t index     = oled_cursor;
+    uint8_t  remaining = oled_rotation_width - (index % oled_rotation_width);
+
+    if (clear_page) {
+        remaining = remaining / OLED_FONT_WIDTH;
+        while (remaining--) {
+            oled_write_char(' ', false);
+        }
+    } else {
+        if (index + remaining >= OLED_MATRIX_SIZE) {
+            index     = 0;
+            remaining = 0;
+        }
+        oled_cursor = index + remaining;
+    }
+}
+
+
+/****************************************************************************
+ * oled_advance_char
+ *
+ * 1文字進める。行の残りが1文字に満たなければ次の行へ、最後まで行けば先頭に戻る。
+ * ****************************************************************************/
+void oled_advance_char(void) {
+    uint16_t next      = oled_cursor + OLED_FONT_WIDTH;
+    uint8_t  remaining = oled_rotation_width - (next % oled_rotation_width);
+
+    if (remaining < OLED_FONT_WIDTH) {
+        next += remaining;
+    }
+    oled_cursor = next >= OLED_MATRIX_SIZE ? 0 : next;
+}
+
+
+/****************************************************************************
+ * oled_write_char
+ *
+ * '\n' と '\r' は改行、フォントの範囲外の文字は空白として1文字を描く。
+ * 文字コードは RP2040 と同じく符号なしで扱う。
+ * ****************************************************************************/
+void oled_write_char(const char data, bool invert) {
+    const uint8_t c = (uint8_t)data;
+
+    if (c == '\n') {
+        oled_advance_page(true);
+        return;
+    }
+    if (c == '\r') {
+        oled_advance_page(false);
+        return;
+    }
+
+    uint8_t *cursor = &oled_buffer[oled_cursor];
+    if ((unsigned)c - OLED_FONT_START > OLED_FONT_END - OLED_FONT_START) {  // OLED_FONT_START〜OLED_FONT_END の外
+        memset(cursor, 0x00, OLED_FONT_WIDTH);
+    } else {
+        memcpy(cursor, &font[(c - OLED_FONT_START) * OLED_FONT_WIDTH], OLED_FONT_WIDTH);
+    }
+    if (invert) {
+        for (uint8_t i = 0; i < OLED_FONT_WIDTH; i++) {
+            cursor[i] = ~cursor[i];
+        }
+    }
+    oled_advance_char();
+}
+
+
+void oled_write(const char *data, bool invert) {
+    while (*data) {
+        oled_write_char(*data++, invert);
+    }
+}
+
+
+void oled_write_ln(const char *data, bool invert) {
+    oled_write(data, invert);
+    oled_advance_page(true);
+}
+
+
+/****************************************************************************
+ * oled_write_raw
+ *
+ * カーソルの位置から描画バッファにそのまま書く。カーソルは進めない（QMK と同じ）。
+ * ****************************************************************************/
+void oled_write_raw(const char *data, uint16_t size) {
+    if (oled_cursor + size > OLED_MATRIX_SIZE) {
+        size = OLED_MATRIX_SIZE - oled_cursor;
+    }
+    memcpy(&oled_buffer[oled_cursor], data, size);
+}
+
+
+uint8_t oled_max_chars(void) {
+    return oled_rotation_width / OLED_FONT_WIDTH;
+}
+
+
+uint8_t oled_max_lines(void) {
+    return (oled_rotation & OLED_ROTATION_90) ? OLED_DISPLAY_WIDTH / OLED_FONT_HEIGHT : OLED_DISPLAY_HEIGHT / OLED_FONT_HEIGHT;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// テストから画面を調べる
+
+const uint8_t *oled_emu_buffer(void) {
+    return oled_buffer;
+}
+
+
+uint8_t oled_emu_width(void) {
+    return oled_rotation_width;
+}
+
+
+uint8_t oled_emu_height(void) {
+    return OLED_MATRIX_SIZE * 8 / oled_rotation_width;
+}
+
+
+/****************************************************************************
+ * oled_emu_pixel
+ *
+ * 描画バッファの1バイトは縦8ドットで、下位ビットが上になる。
+ * ****************************************************************************/
+bool oled_emu_pixel(uint8_t x, uint8_t y) {
+    return (oled_buffer[(y / 8) * oled_rotation_width + x] >> (y % 8)) & 1;
+}
+
+
+/****************************************************************************
+ * oled_emu_write_pbm
+ *
+ * 1行を1ドット1文字（'1' が点灯）で書き出す。差分で見比べやすいように空白は入れない。
+ * ****************************************************************************/
+bool oled_emu_write_pbm(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        return false;
+    }
+    fprintf(out, "P1\n%u %u\n", oled_emu_width(), oled_emu_height());
+    for (uint8_t y = 0; y < oled_emu_height(); y++) {
+        for (uint8_t x = 0; x < oled_emu_width(); x++) {
+            fputc(oled_emu_pixel(x, y) ? '1' : '0', out);
+        }
+        fputc('\n', out);
+    }
+    return fclose(out) == 0;
+}
+
+
+/****************************************************************************
+ * oled_emu_compare_pbm
+ *
+ * コメント（'#' から行末まで）と空白を読み飛ばし、ドットを順に比べる。
+ * ****************************************************************************/
+size_t oled_emu_compare_pbm(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        return SIZE_MAX;
+    }
+
+    unsigned width, height;
+    if (fscanf(in, "P1 %u %u", &width, &height) != 2 || width != oled_emu_width() || height != oled_emu_height()) {
+        fclose(in);
+        return SIZE_MAX;
+    }
+
+    size_t diffs = 0;
+    for (unsigned i = 0; i < width * height; i++) {
+        int c;
+        while ((c = fgetc(in)) == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '#') {
+            if (c == '#') {
+                while ((c = fgetc(in)) != '\n' && c != EOF) {
+                }
+            }
+        }
+        if (c != '0' && c != '1') {
+            fclose(in);
+            return SIZE_MAX;
+        }
+        diffs += (c == '1') != oled_emu_pixel(i % width, i / width);
+    }
+    fclose(in);
+    return diffs;
+}
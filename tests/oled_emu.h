@@ -0,0 +1,31 @@
+/*
+ * tests/oled_emu.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * QMK の oled_driver の描画バッファをホストで再現する（oled_emu.c）。
+ * 描画の関数は stub/oled_driver.h で宣言し、ここではテストから画面を調べる関数を宣言する。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "oled_driver.h"
+
+// 描画バッファ（OLED_MATRIX_SIZE バイト）
+const uint8_t *oled_emu_buffer(void);
+
+// 回転後の画面の幅と高さ（ドット）。90度・270度では 64×128 になる
+uint8_t oled_emu_width(void);
+uint8_t oled_emu_height(void);
+
+// 回転後の画面の (x, y) のドットが点灯しているか
+bool oled_emu_pixel(uint8_t x, uint8_t y);
+
+// 画面を PBM（P1）で書き出す。失敗したら false
+bool oled_emu_write_pbm(const char *path);
+
+// PBM（P1）の画像と画面を比べ、異なるドットの数を返す（読めない・大きさが違う場合は SIZE_MAX）
+size_t oled_emu_compare_pbm(const char *path);
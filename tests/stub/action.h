@@ -0,0 +1,11 @@
+/*
+ * tests/stub/action.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の action.h。keyrecord_t は quantum.h で定義する。
+ */
+
+#pragma once
+
+#include "quantum.h"
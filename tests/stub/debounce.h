@@ -0,0 +1,17 @@
+/*
+ * tests/stub/debounce.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の debounce.h。QMK の DEBOUNCE_TYPE = custom で実装する関数。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+void debounce_init(uint8_t num_rows);
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+void debounce_free(void);
@@ -0,0 +1,15 @@
+/*
+ * tests/stub/drivers/sensors/pmw3389.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の pmw3389.h。CPI の範囲は QMK の PMW3389 のドライバと同じ。
+ * mtk64erp.c は "../../drivers/sensors/pmw3389.h" を読むので、
+ * Makefile ではこのディレクトリを -I に加える（../../ でこのディレクトリに戻る）。
+ */
+
+#pragma once
+
+#define PMW33XX_CPI_MIN  50
+#define PMW33XX_CPI_MAX  16000
+#define PMW33XX_CPI_STEP 50
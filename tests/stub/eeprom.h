@@ -0,0 +1,14 @@
+/*
+ * tests/stub/eeprom.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の eeprom.h。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+uint8_t eeprom_read_byte(const uint8_t *addr);
+void    eeprom_update_byte(uint8_t *addr, uint8_t value);
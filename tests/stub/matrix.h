@@ -0,0 +1,16 @@
+/*
+ * tests/stub/matrix.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の matrix.h。マトリクスの大きさは keyboard.json と同じ（片手7行×7列の分割キーボード）。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define MATRIX_ROWS 14
+#define MATRIX_COLS 7
+
+typedef uint8_t matrix_row_t;
@@ -0,0 +1,47 @@
+/*
+ * tests/stub/oled_driver.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の oled_driver.h。OLED_DISPLAY_128X64 の場合と同じ大きさ。
+ * 描画の関数は oled_emu.c で描画バッファに書く。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OLED_DISPLAY_WIDTH  128
+#define OLED_DISPLAY_HEIGHT 64
+#define OLED_MATRIX_SIZE    (OLED_DISPLAY_HEIGHT / 8 * OLED_DISPLAY_WIDTH)  // 1バイトが縦8ドット
+#define OLED_FONT_WIDTH     6
+#define OLED_FONT_HEIGHT    8
+#define OLED_FONT_START     0
+#define OLED_FONT_END       223
+
+typedef enum {
+    OLED_ROTATION_0   = 0,
+    OLED_ROTATION_90  = 1,
+    OLED_ROTATION_180 = 2,
+    OLED_ROTATION_270 = 3,
+} oled_rotation_t;
+
+bool            oled_init(oled_rotation_t rotation);
+oled_rotation_t oled_init_kb(oled_rotation_t rotation);
+bool            oled_task_kb(void);
+void            oled_clear(void);
+void            oled_set_cursor(uint8_t col, uint8_t line);
+void            oled_advance_page(bool clear_page);
+void            oled_advance_char(void);
+void            oled_write_char(const char data, bool invert);
+void            oled_write(const char *data, bool invert);
+void            oled_write_ln(const char *data, bool invert);
+void            oled_write_raw(const char *data, uint16_t size);
+uint8_t         oled_max_chars(void);
+uint8_t         oled_max_lines(void);
+
+// AVR 以外では _P の関数は通常の関数と同じ（QMK と同じ）
+#define oled_write_P(data, invert)    oled_write(data, invert)
+#define oled_write_ln_P(data, invert) oled_write_ln(data, invert)
+#define oled_write_raw_P(data, size)  oled_write_raw(data, size)
@@ -0,0 +1,13 @@
+/*
+ * tests/stub/print.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の print.h。デバッグ出力は捨てる。
+ */
+
+#pragma once
+
+#define print(s)       ((void)0)
+#define dprintf(...)   ((void)0)
+#define uprintf(...)   ((void)0)
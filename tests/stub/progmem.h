@@ -0,0 +1,13 @@
+/*
+ * tests/stub/progmem.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の progmem.h。ホストではフラッシュとRAMを区別しない。
+ */
+
+#pragma once
+
+#define PROGMEM
+#define PSTR(s)          s
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
@@ -0,0 +1,86 @@
+/*
+ * tests/stub/quantum.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の quantum.h。mtk64erp.h の宣言と、mtk64erp.c から呼ぶ QMK の関数だけを宣言する。
+ * 関数の中身は使うテストで定義する。
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "progmem.h"
+#include "report.h"
+#include "timer.h"
+#include "matrix.h"
+#include "split_util.h"
+#include "oled_driver.h"
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    uint16_t time;
+} keyevent_t;
+
+typedef struct {
+    keyevent_t event;
+} keyrecord_t;
+
+// キーコードの範囲（QMK の keycodes.h と同じ値）
+#define QK_MODS          0x0100
+#define QK_MODS_MAX      0x1FFF
+#define QK_MOD_TAP       0x2000
+#define QK_MOD_TAP_MAX   0x3FFF
+#define QK_LAYER_TAP     0x4000
+#define QK_LAYER_TAP_MAX 0x4FFF
+#define QK_KB_0          0x7E00
+
+// EEPROM のキーボード用の領域
+#define EECONFIG_KEYBOARD ((uint32_t *)32)
+
+// レイヤ
+typedef uint32_t layer_state_t;
+extern layer_state_t layer_state;
+
+uint8_t get_highest_layer(layer_state_t state);
+bool    layer_state_is(uint8_t layer);
+void    layer_on(uint8_t layer);
+void    layer_off(uint8_t layer);
+layer_state_t layer_state_set_user(layer_state_t state);
+
+// 左右・キー入力・ユーザー定義の処理
+bool is_keyboard_master(void);
+bool process_record_user(uint16_t keycode, keyrecord_t *record);
+void post_process_record_user(uint16_t keycode, keyrecord_t *record);
+void keyboard_post_init_user(void);
+void housekeeping_task_user(void);
+void matrix_scan_user(void);
+
+// EEPROM の設定
+uint32_t eeconfig_read_kb(void);
+void     eeconfig_init_user(void);
+void     eeconfig_read_kb_datablock(void *data);
+void     eeconfig_update_kb_datablock(const void *data);
+
+// RGB ライト
+uint8_t rgblight_get_mode(void);
+uint8_t rgblight_get_hue(void);
+uint8_t rgblight_get_sat(void);
+uint8_t rgblight_get_val(void);
+
+// ポインティングデバイス（POINTING_DEVICE_COMBINED と自動マウスレイヤ）
+report_mouse_t pointing_device_combine_reports(report_mouse_t left_report, report_mouse_t right_report);
+report_mouse_t pointing_device_task_combined_user(report_mouse_t left_report, report_mouse_t right_report);
+void           pointing_device_set_cpi_on_side(bool left, uint16_t cpi);
+uint16_t       pointing_device_get_hires_scroll_resolution(void);
+void           set_auto_mouse_enable(bool enable);
+void           set_auto_mouse_timeout(uint16_t timeout);
+layer_state_t  remove_auto_mouse_layer(layer_state_t state, bool force);
@@ -0,0 +1,32 @@
+/*
+ * tests/stub/report.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の report.h。QMK の report_mouse_t と同じ並びの構造体だけを定義する。
+ * MOUSE_EXTENDED_REPORT / WHEEL_EXTENDED_REPORT の有無で型の幅が変わるのも QMK と同じ。
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef MOUSE_EXTENDED_REPORT
+typedef int16_t mouse_xy_report_t;
+#else
+typedef int8_t mouse_xy_report_t;
+#endif
+
+#ifdef WHEEL_EXTENDED_REPORT
+typedef int16_t mouse_hv_report_t;
+#else
+typedef int8_t mouse_hv_report_t;
+#endif
+
+typedef struct {
+    uint8_t           buttons;
+    mouse_xy_report_t x;
+    mouse_xy_report_t y;
+    mouse_hv_report_t v;
+    mouse_hv_report_t h;
+} report_mouse_t;
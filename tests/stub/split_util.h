@@ -0,0 +1,13 @@
+/*
+ * tests/stub/split_util.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の split_util.h。左右の判定はテストで定義する。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+bool is_keyboard_left(void);
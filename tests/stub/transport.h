@@ -0,0 +1,13 @@
+/*
+ * tests/stub/transport.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ホストテスト用の transport.h。左右の接続状態はテストで定義する。
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+bool is_transport_connected(void);
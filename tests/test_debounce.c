@@ -0,0 +1,298 @@
+/*
+ * tests/test_debounce.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * mtk_debounce.c のホストテスト。
+ * 押下のチャタリング・離しのチャタリング・スキャンの停止などのパターンを通し、
+ * キーごとの素直な実装（押下はすぐ、離しは DEBOUNCE ミリ秒後）と結果を比べる。
+ */
+
+#include "host.h"
+#include "quantum.h"
+#include "debounce.h"
+#include "mtk_debounce.h"
+#include <string.h>
+
+#define ROWS (MATRIX_ROWS / 2)  // 片手分の行数（debounce に渡す num_rows）
+#define KEYS (ROWS * MATRIX_COLS)
+
+bool is_keyboard_left(void) {
+    return true;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 比べる実装（キーごとのカウンタ）
+
+static bool     ref_cooked[KEYS];
+static uint8_t  ref_count[KEYS];
+static uint16_t ref_last;
+
+static void ref_init(void) {
+    memset(ref_cooked, 0, sizeof(ref_cooked));
+    memset(ref_count, 0, sizeof(ref_count));
+    ref_last = timer_read();
+}
+
+
+/****************************************************************************
+ * ref_debounce
+ *
+ * mtk_debounce.c と同じ規則をキーごとに処理する。
+ * 押されているキーはすぐに押下とし、カウンタを0に戻す。離れているキーは
+ * 前回からの経過ミリ秒だけカウンタを進め、DEBOUNCE に達したら離しとする。
+ * ****************************************************************************/
+static void ref_debounce(const bool raw[KEYS]) {
+    uint16_t now     = timer_read();
+    uint16_t elapsed = now - ref_last;
+    ref_last         = now;
+
+    for (int k = 0; k < KEYS; k++) {
+        if (raw[k]) {
+            ref_cooked[k] = true;
+            ref_count[k]  = 0;
+        } else if (ref_cooked[k]) {
+            ref_count[k] = ref_count[k] + elapsed > DEBOUNCE ? DEBOUNCE : ref_count[k] + elapsed;
+            if (ref_count[k] >= DEBOUNCE) {
+                ref_cooked[k] = false;
+                ref_count[k]  = 0;
+            }
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// テスト用のマトリクス
+
+static matrix_row_t raw_rows[ROWS];
+static matrix_row_t cooked_rows[ROWS];
+static matrix_row_t last_rows[ROWS];
+static bool         raw_keys[KEYS];
+
+static void matrix_reset(void) {
+    memset(raw_rows, 0, sizeof(raw_rows));
+    memset(cooked_rows, 0, sizeof(cooked_rows));
+    memset(last_rows, 0, sizeof(last_rows));
+    memset(raw_keys, 0, sizeof(raw_keys));
+    debounce_init(ROWS);
+    ref_init();
+}
+
+static void key_set(int key, bool pressed) {
+    raw_keys[key] = pressed;
+    if (pressed) {
+        raw_rows[key / MATRIX_COLS] |= 1 << (key % MATRIX_COLS);
+    } else {
+        raw_rows[key / MATRIX_COLS] &= ~(1 << (key % MATRIX_COLS));
+    }
+}
+
+static bool key_cooked(int key) {
+    return (cooked_rows[key / MATRIX_COLS] >> (key % MATRIX_COLS)) & 1;
+}
+
+
+/****************************************************************************
+ * scan
+ *
+ * 1回分のスキャン結果を debounce と比べる実装に通し、結果が一致するか確かめる。
+ * changed はマトリクスのスキャンと同じく前回のスキャン結果から変わったときだけ立てる。
+ * ****************************************************************************/
+static void scan(const char *pattern, int step) {
+    bool changed = memcmp(raw_rows, last_rows, sizeof(raw_rows)) != 0;
+    memcpy(last_rows, raw_rows, sizeof(raw_rows));
+
+    matrix_row_t before[ROWS];
+    memcpy(before, cooked_rows, sizeof(before));
+    bool reported = debounce(raw_rows, cooked_rows, ROWS, changed);
+    ref_debounce(raw_keys);
+
+    for (int k = 0; k < KEYS; k++) {
+        CHECK(key_cooked(k) == ref_cooked[k], "%s step %d key %d: cooked %d, expected %d", pattern, step, k, key_cooked(k), ref_cooked[k]);
+    }
+    CHECK(reported == (memcmp(before, cooked_rows, sizeof(before)) != 0), "%s step %d: change not reported", pattern, step);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// パターン
+
+/****************************************************************************
+ * test_press_bounce
+ *
+ * 押下のチャタリング：最初の接触ですぐに押下になり、途中で離れても押されたまま。
+ * ****************************************************************************/
+static void test_press_bounce(void) {
+    static const bool bounce[] = {1, 0, 1, 0, 0, 1, 0, 1, 1, 1, 1, 1};
+    matrix_reset();
+
+    for (int i = 0; i < (int)sizeof(bounce); i++) {
+        key_set(10, bounce[i]);
+        scan("press bounce", i);
+        CHECK(key_cooked(10), "press bounce step %d: released while bouncing", i);
+        host_time_ms++;
+    }
+}
+
+
+/****************************************************************************
+ * test_release_bounce
+ *
+ * 離しのチャタリング：最後に離れてから DEBOUNCE ミリ秒（スキャンの間隔の分だけ早まる）で離しになる。
+ * ****************************************************************************/
+static void test_release_bounce(void) {
+    static const bool bounce[] = {0, 1, 0, 1, 1, 0, 1, 0};
+    matrix_reset();
+    key_set(48, true);
+    scan("release bounce", -1);
+    host_time_ms++;
+
+    for (int i = 0; i < (int)sizeof(bounce); i++) {
+        key_set(48, bounce[i]);
+        scan("release bounce", i);
+        CHECK(key_cooked(48), "release bounce step %d: released while bouncing", i);
+        host_time_ms++;
+    }
+
+    // 最後に離れたのは1ミリ秒前のスキャン
+    int released = -1;
+    for (int t = 0; t < 2 * DEBOUNCE && released < 0; t++) {
+        scan("release bounce", 100 + t);
+        if (!key_cooked(48)) {
+            released = t + 1;
+        }
+        host_time_ms++;
+    }
+    CHECK(released == DEBOUNCE - 1, "released %d ms after the last bounce, expected %d", released, DEBOUNCE - 1);
+}
+
+
+/****************************************************************************
+ * test_independent_keys
+ *
+ * あるキーがチャタリングしている間も、他のキーの押下・離しは遅れない。
+ * ****************************************************************************/
+static void test_independent_keys(void) {
+    matrix_reset();
+    key_set(0, true);
+    scan("independent", 0);
+    host_time_ms++;
+
+    for (int i = 0; i < 20; i++) {
+        key_set(0, i & 1);          // キー0はずっとチャタリング
+        key_set(20, i == 3);        // キー20は1回だけ押して離す
+        scan("independent", i + 1);
+        if (i == 3) {
+            CHECK(key_cooked(20), "key 20 press delayed by key 0 bouncing");
+        }
+        if (i == 3 + DEBOUNCE) {
+            CHECK(!key_cooked(20), "key 20 release delayed by key 0 bouncing");
+        }
+        host_time_ms++;
+    }
+}
+
+
+/****************************************************************************
+ * test_scan_timing
+ *
+ * 1ミリ秒に何回スキャンしても離しは早まらず、スキャンが止まって時間が空いた場合は
+ * 次のスキャンでまとめて進める。片手分のすべてのキー（最後の行も）を同時に扱える。
+ * ****************************************************************************/
+static void test_scan_timing(void) {
+    matrix_reset();
+    for (int k = 0; k < KEYS; k++) {
+        key_set(k, true);
+    }
+    scan("all keys", 0);
+    for (int k = 0; k < KEYS; k++) {
+        CHECK(key_cooked(k), "key %d (row %d) not pressed", k, k / MATRIX_COLS);
+    }
+    host_time_ms++;
+
+    for (int k = 0; k < KEYS; k++) {
+        key_set(k, false);
+    }
+    for (int i = 0; i < 50; i++) {
+        scan("many scans per ms", i);   // 時刻を進めずにスキャン
+    }
+    CHECK(key_cooked(KEYS - 1), "release confirmed without time passing");
+
+    host_time_ms += 3 * DEBOUNCE;       // スキャンが止まっていた
+    scan("stalled scan", 0);
+    for (int k = 0; k < KEYS; k++) {
+        CHECK(!key_cooked(k), "key %d not released after the stall", k);
+    }
+}
+
+
+/****************************************************************************
+ * test_random_bounce
+ *
+ * すべてのキーをランダムにチャタリングさせ、スキャンの間隔（0〜3ミリ秒）もばらつかせて
+ * 比べる実装と一致し続けることを確かめる。
+ * ****************************************************************************/
+static void test_random_bounce(void) {
+    uint32_t seed = 12345;
+    matrix_reset();
+
+    for (int step = 0; step < 20000; step++) {
+        seed = seed * 1103515245u + 12345u;
+        // 1スキャンで数キーだけ変化させる
+        for (int n = (seed >> 28) & 3; n > 0; n--) {
+            seed = seed * 1103515245u + 12345u;
+            int key = (seed >> 16) % KEYS;
+            key_set(key, !raw_keys[key]);
+        }
+        scan("random", step);
+        host_time_ms += (seed >> 8) & 3;
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ベンチマーク
+
+/****************************************************************************
+ * bench_debounce
+ *
+ * すべてのキーが離しの確定待ちのときの debounce 1回あたりのサイクル数を計測する。
+ * ****************************************************************************/
+static void bench_debounce(void) {
+    const int calls = 200000;
+    uint64_t  best  = UINT64_MAX;
+
+    for (int round = 0; round < 5; round++) {
+        matrix_reset();
+        memset(raw_rows, 0x7F, sizeof(raw_rows));
+        debounce(raw_rows, cooked_rows, ROWS, true);
+        memset(raw_rows, 0, sizeof(raw_rows));
+
+        uint64_t start = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            // 離れた直後と、チャタリングで押し直した状態を交互に
+            raw_rows[i % ROWS] ^= 0x55;
+            HOST_KEEP(debounce(raw_rows, cooked_rows, ROWS, true));
+            host_time_ms++;
+        }
+        uint64_t cycles = host_cycles() - start;
+        best            = cycles < best ? cycles : best;
+    }
+    printf("bench debounce (%d keys): %.1f cycles/call\n", KEYS, (double)best / calls);
+}
+
+
+int main(int argc, char **argv) {
+    test_press_bounce();
+    test_release_bounce();
+    test_independent_keys();
+    test_scan_timing();
+    test_random_bounce();
+
+    if (host_bench_enabled(argc, argv)) {
+        bench_debounce();
+    }
+    return host_summary("test_debounce");
+}
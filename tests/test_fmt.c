@@ -0,0 +1,183 @@
+/*
+ * tests/test_fmt.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * mtk_fmt.c のホストテスト。
+ * 各関数の結果を同じ指定の snprintf と、バッファの大きさ（切り捨て）も含めて比べる。
+ */
+
+#include "host.h"
+#include "mtk_fmt.h"
+#include <string.h>
+
+#define BUF_SIZE 24  // 比べるバッファの最大の大きさ
+
+static const int32_t values[] = {
+    0, 1, -1, 9, -9, 10, -10, 99, 100, -99, -100, 999, 1000, -1000,
+    12345, -12345, 65535, 65536, INT16_MAX, INT16_MIN, INT32_MAX, INT32_MIN,
+};
+
+
+/****************************************************************************
+ * check_same
+ *
+ * mtk_fmt の結果（a, n）と snprintf の結果（b）を比べる。
+ * 終端文字より後ろに書いていないことも確かめる（バッファは 'X' で埋めておく）。
+ * ****************************************************************************/
+static void check_same(const char *what, uint8_t size, const char *a, uint8_t n, const char *b) {
+    CHECK(memcmp(a, b, BUF_SIZE) == 0, "%s size %u: '%s' vs snprintf '%s'", what, size, size ? a : "", size ? b : "");
+    CHECK(size == 0 || n == strlen(b), "%s size %u: returned %u for '%s'", what, size, n, b);
+}
+
+
+/****************************************************************************
+ * test_dec
+ *
+ * "%d"・"%Nd"・"%-Nd"・"%Nu"・"%-Nu" と比べる（幅 0〜8、バッファ 0〜BUF_SIZE バイト）。
+ * ****************************************************************************/
+static void test_dec(void) {
+    uint32_t seed = 99;
+
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]) + 200; i++) {
+        int32_t v;
+        if (i < sizeof(values) / sizeof(values[0])) {
+            v = values[i];
+        } else {
+            seed = seed * 1103515245u + 12345u;
+            v    = (int32_t)(seed ^ (seed << 7)) >> ((seed >> 27) & 31);
+        }
+
+        for (uint8_t width = 0; width <= 8; width++) {
+            for (int left = 0; left <= 1; left++) {
+                char fmt_d[8], fmt_u[8];
+                snprintf(fmt_d, sizeof(fmt_d), left ? "%%-%ud" : "%%%ud", width);
+                snprintf(fmt_u, sizeof(fmt_u), left ? "%%-%uu" : "%%%uu", width);
+
+                for (uint8_t size = 0; size <= BUF_SIZE; size++) {
+                    char    a[BUF_SIZE], b[BUF_SIZE];
+                    uint8_t n;
+
+                    memset(a, 'X', sizeof(a));
+                    memset(b, 'X', sizeof(b));
+                    n = mtk_fmt_dec(a, size, v, width, left);
+                    snprintf(b, size, fmt_d, (int)v);
+                    check_same(fmt_d, size, a, n, b);
+
+                    memset(a, 'X', sizeof(a));
+                    memset(b, 'X', sizeof(b));
+                    n = mtk_fmt_udec(a, size, (uint32_t)v, width, left);
+                    snprintf(b, size, fmt_u, (unsigned)v);
+                    check_same(fmt_u, size, a, n, b);
+                }
+            }
+        }
+    }
+}
+
+
+/****************************************************************************
+ * test_hex_str
+ *
+ * "%0Nx"（1〜8桁）と "%s" と比べる。
+ * ****************************************************************************/
+static void test_hex_str(void) {
+    static const char *strs[] = {"", "L", "CPI:", "SCROLL SNAP", "0123456789abcdefghijklmnopqrstuvwxyz"};
+
+    for (unsigned i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (uint8_t digits = 1; digits <= 8; digits++) {
+            char fmt[8];
+            snprintf(fmt, sizeof(fmt), "%%0%ux", digits);
+            for (uint8_t size = 0; size <= BUF_SIZE; size++) {
+                char a[BUF_SIZE], b[BUF_SIZE];
+                memset(a, 'X', sizeof(a));
+                memset(b, 'X', sizeof(b));
+                uint8_t n = mtk_fmt_hex(a, size, (uint32_t)values[i], digits);
+                snprintf(b, size, fmt, (unsigned)values[i]);
+                check_same(fmt, size, a, n, b);
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+        for (uint8_t size = 0; size <= BUF_SIZE; size++) {
+            char a[BUF_SIZE], b[BUF_SIZE];
+            memset(a, 'X', sizeof(a));
+            memset(b, 'X', sizeof(b));
+            uint8_t n = mtk_fmt_str(a, size, strs[i]);
+            snprintf(b, size, "%s", strs[i]);
+            check_same("%s", size, a, n, b);
+        }
+    }
+}
+
+
+/****************************************************************************
+ * test_chain
+ *
+ * 戻り値で buf と size をずらして続けて書くと、1回の snprintf と同じ結果になる
+ * （OLED の行を組み立てるときの使い方）。
+ * ****************************************************************************/
+static void test_chain(void) {
+    for (uint8_t size = 1; size <= BUF_SIZE; size++) {
+        char    a[BUF_SIZE], b[BUF_SIZE];
+        uint8_t n = 0;
+        memset(a, 'X', sizeof(a));
+        memset(b, 'X', sizeof(b));
+        n += mtk_fmt_str(a + n, size - n, "CPI:");
+        n += mtk_fmt_udec(a + n, size - n, 1600, 5, false);
+        n += mtk_fmt_str(a + n, size - n, " ");
+        n += mtk_fmt_dec(a + n, size - n, -12, 3, true);
+        n += mtk_fmt_hex(a + n, size - n, 0xE2, 2);
+        snprintf(b, size, "CPI:%5u %-3d%02x", 1600u, -12, 0xE2u);
+        check_same("chain", size, a, n, b);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ベンチマーク
+
+/****************************************************************************
+ * bench_fmt
+ *
+ * OLED でよく使う "%5u" と "%-3d" を mtk_fmt と snprintf で書いたときのサイクル数を比べる。
+ * ****************************************************************************/
+static void bench_fmt(void) {
+    const int calls = 200000;
+    uint64_t  best_fmt = UINT64_MAX, best_snprintf = UINT64_MAX;
+    char      buf[8];
+
+    for (int round = 0; round < 5; round++) {
+        uint64_t start = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            mtk_fmt_udec(buf, sizeof(buf), (uint32_t)i & 0xFFFF, 5, false);
+            HOST_KEEP(buf[0]);
+            mtk_fmt_dec(buf, sizeof(buf), (i & 0xFF) - 128, 3, true);
+            HOST_KEEP(buf[0]);
+        }
+        uint64_t mid = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            snprintf(buf, sizeof(buf), "%5u", (unsigned)i & 0xFFFF);
+            HOST_KEEP(buf[0]);
+            snprintf(buf, sizeof(buf), "%-3d", (i & 0xFF) - 128);
+            HOST_KEEP(buf[0]);
+        }
+        uint64_t end  = host_cycles();
+        best_fmt      = mid - start < best_fmt ? mid - start : best_fmt;
+        best_snprintf = end - mid < best_snprintf ? end - mid : best_snprintf;
+    }
+    printf("bench fmt \"%%5u\"+\"%%-3d\": mtk_fmt %.1f cycles, snprintf %.1f cycles\n", (double)best_fmt / calls, (double)best_snprintf / calls);
+}
+
+
+int main(int argc, char **argv) {
+    test_dec();
+    test_hex_str();
+    test_chain();
+
+    if (host_bench_enabled(argc, argv)) {
+        bench_fmt();
+    }
+    return host_summary("test_fmt");
+}
@@ -0,0 +1,459 @@
+/*
+ * tests/test_oled.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * mtk64erp.c の OLED 表示のホストテスト。
+ * oled_task_kb で描いた画面（oled_emu.c の描画バッファ）を data/oled_*.pbm の画像と比べる。
+ * 実際に描いた画像は build/ に書き出すので、違う場合は見比べて確かめ、
+ * 意図した変更なら make update で data/ の画像を作り直す。
+ * 部分更新（変わった行だけの描画）の結果が全行の描画と同じになることも確かめる。
+ */
+
+#include "host.h"
+#include "oled_emu.h"
+#include "../mtk64erp.c"
+
+#define GOLDEN_DIR "data"   // 期待する画像
+#define ACTUAL_DIR "build"  // 描いた画像の書き出し先
+
+
+//////////////////////////////////////////////////////////////////////////////
+// QMK とハードウェアのモジュールの代わり
+//
+// 表示に使う値はテストで決め、それ以外は何もしない。
+
+layer_state_t layer_state = 0;
+
+static bool     keyboard_master = true;   // is_keyboard_master の値
+static bool     keyboard_left   = false;  // is_keyboard_left の値
+static uint8_t  rgb_values[4];            // モード・色相・彩度・明度
+static uint8_t  eeprom[64];
+
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? 31 - __builtin_clz(state) : 0;
+}
+
+bool layer_state_is(uint8_t layer) {
+    return layer_state ? (layer_state >> layer) & 1 : layer == 0;
+}
+
+void layer_on(uint8_t layer) {
+    layer_state |= 1u << layer;
+}
+
+void layer_off(uint8_t layer) {
+    layer_state &= ~(1u << layer);
+}
+
+layer_state_t layer_state_set_user(layer_state_t state) {
+    return state;
+}
+
+bool is_keyboard_master(void) {
+    return keyboard_master;
+}
+
+bool is_keyboard_left(void) {
+    return keyboard_left;
+}
+
+bool is_transport_connected(void) {
+    return true;
+}
+
+uint8_t rgblight_get_mode(void) {
+    return rgb_values[0];
+}
+
+uint8_t rgblight_get_hue(void) {
+    return rgb_values[1];
+}
+
+uint8_t rgblight_get_sat(void) {
+    return rgb_values[2];
+}
+
+uint8_t rgblight_get_val(void) {
+    return rgb_values[3];
+}
+
+void post_process_record_user(uint16_t keycode, keyrecord_t *record) {}
+void keyboard_post_init_user(void) {}
+void housekeeping_task_user(void) {}
+void matrix_scan_user(void) {}
+void eeconfig_init_user(void) {}
+
+uint32_t eeconfig_read_kb(void) {
+    return 0;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+    return eeprom[(uintptr_t)addr % sizeof(eeprom)];
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+    eeprom[(uintptr_t)addr % sizeof(eeprom)] = value;
+}
+
+void eeconfig_read_kb_datablock(void *data) {
+    memset(data, 0, EECONFIG_KB_DATA_SIZE);
+}
+
+void eeconfig_update_kb_datablock(const void *data) {}
+
+report_mouse_t pointing_device_combine_reports(report_mouse_t left_report, report_mouse_t right_report) {
+    return left_report;
+}
+
+report_mouse_t pointing_device_task_combined_user(report_mouse_t left_report, report_mouse_t right_report) {
+    return pointing_device_combine_reports(left_report, right_report);
+}
+
+void pointing_device_set_cpi_on_side(bool left, uint16_t cpi) {}
+
+uint16_t pointing_device_get_hires_scroll_resolution(void) {
+    return POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER;
+}
+
+void set_auto_mouse_enable(bool enable) {}
+void set_auto_mouse_timeout(uint16_t timeout) {}
+
+layer_state_t remove_auto_mouse_layer(layer_state_t state, bool force) {
+    return state;
+}
+
+bool mtk_sensor_set_rest(bool enabled) {
+    return true;
+}
+void mtk_sensor_set_rest_times(uint32_t rest2_ms, uint32_t rest3_ms) {}
+void mtk_oled_task(void) {}
+void mtk_oled_frame(void) {}
+void mtk_split_init(void) {}
+void mtk_split_motion_sync(void) {}
+void mtk_split_state_changed(void) {}
+void mtk_split_task(void) {}
+void mtk_latency_scan(void) {}
+void mtk_latency_record(keyrecord_t *record) {}
+void mtk_matrix_count_scan(void) {}
+
+// 診断ページの値（桁数の違う値を並べる）
+void mtk_split_get_stats(mtk_split_stats_t *stats) {
+    *stats = (mtk_split_stats_t){.errors = 3, .retries = 2, .disconnects = 1, .rtt_min_us = 181, .rtt_avg_us = 215, .rtt_max_us = 1390};
+}
+
+uint16_t mtk_split_get_transaction_rate(void) {
+    return 1000;
+}
+
+uint32_t mtk_split_get_byte_rate(void) {
+    return 23000;
+}
+
+uint16_t mtk_matrix_get_scan_rate(void) {
+    return 9804;
+}
+
+uint16_t mtk_matrix_get_scan_time(bool max) {
+    return max ? 95 : 62;
+}
+
+uint16_t mtk_debounce_get_avg_ns(void) {
+    return 740;
+}
+
+uint16_t mtk_debounce_get_max_us(void) {
+    return 4;
+}
+
+void mtk_latency_get_stats(mtk_latency_stats_t *stats) {
+    *stats = (mtk_latency_stats_t){.loop_max_us = 410, .histogram = {120, 340, 55, 12, 3, 1, 0}};
+}
+
+void mtk_oled_get_stats(mtk_oled_stats_t *stats) {
+    *stats = (mtk_oled_stats_t){.stall_max_us = 12};
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 画面の準備と描画
+
+/****************************************************************************
+ * screen_setup
+ *
+ * 左右・マスターと表示の向きを決めて OLED を初期化し、表示する値を決まった値にする。
+ * oled_task_kb は前回の描画からの経過時間で描画するので時刻は戻さず、次の分の始めまで進める。
+ * ****************************************************************************/
+static void screen_setup(bool master, bool left, uint8_t orient) {
+    keyboard_master = master;
+    keyboard_left   = left;
+    host_time_ms    = (host_time_ms / 60000 + 1) * 60000;
+
+    mtk_set_oled_orient_value(orient);
+    oled_init(OLED_ROTATION_0);
+    oled_page   = MTK_OLED_PAGE_MAIN;
+    oled_redraw = true;
+
+    layer_state = 1u << 3;
+    memcpy(rgb_values, (const uint8_t[]){5, 170, 255, 120}, sizeof(rgb_values));
+    mtk_set_cpi(MTK_SIDE_LEFT, 800);
+    mtk_set_cpi(MTK_SIDE_RIGHT, 1600);
+    mtk_set_edit_side(MTK_SIDE_RIGHT);
+    mtk_set_speed_adjust_value(MTK_SIDE_RIGHT, 12);
+    mtk_set_scrollsnap_mode(MTK_SIDE_RIGHT, MTK_SCROLLSNAP_MODE_VERTICAL);
+    mtk_set_scroll_mode(false);
+    mtk_set_auto_mouse_mode(true);
+    mtk_config.motion.x = 37;
+    mtk_config.motion.y = -5;
+    type_count          = 7345;
+}
+
+
+/****************************************************************************
+ * screen_frame
+ *
+ * oled_task_kb の更新間隔（100ミリ秒）より進めて1回描画する。
+ * ****************************************************************************/
+static void screen_frame(void) {
+    host_time_ms += 101;
+    oled_task_kb();
+}
+
+
+/****************************************************************************
+ * press_key
+ *
+ * キーを押して離す（process_record_kb を通すのでキーログと打鍵数も進む）。
+ * ****************************************************************************/
+static void press_key(uint16_t keycode, uint8_t row, uint8_t col) {
+    keyrecord_t record = {.event = {.key = {.col = col, .row = row}, .pressed = true, .time = (uint16_t)host_time_ms}};
+    process_record_kb(keycode, &record);
+    host_time_ms += 37 + 11 * (keycode & 7);
+    record.event.pressed = false;
+    process_record_kb(keycode, &record);
+}
+
+
+/****************************************************************************
+ * press_keys
+ *
+ * キーログに文字キー・モッドタップ・レイヤタップを積む。
+ * ****************************************************************************/
+static void press_keys(void) {
+    press_key(0x04, 1, 2);    // a
+    press_key(0x2016, 2, 3);  // モッドタップの s
+    press_key(0x4128, 3, 6);  // レイヤタップの Enter
+    press_key(0x1E, 0, 1);    // 1
+}
+
+
+/****************************************************************************
+ * check_screen
+ *
+ * 画面を build/oled_<name>.pbm に書き出し、data/oled_<name>.pbm と比べる。
+ * update が true なら data/ の画像を作り直す。
+ * ****************************************************************************/
+static bool update_golden = false;
+
+static void check_screen(const char *name) {
+    char actual[64], golden[64];
+    snprintf(actual, sizeof(actual), ACTUAL_DIR "/oled_%s.pbm", name);
+    snprintf(golden, sizeof(golden), GOLDEN_DIR "/oled_%s.pbm", name);
+
+    CHECK(oled_emu_write_pbm(update_golden ? golden : actual), "cannot write the image for %s", name);
+    if (update_golden) {
+        return;
+    }
+    size_t diffs = oled_emu_compare_pbm(golden);
+    CHECK(diffs != SIZE_MAX, "cannot read %s (or the size differs)", golden);
+    CHECK(diffs == 0 || diffs == SIZE_MAX, "%s: %zu pixels differ from %s", actual, diffs, golden);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// テスト
+
+/****************************************************************************
+ * test_main_screens
+ *
+ * マスターの通常の表示（横・縦）と、スレーブのレイヤ表示・ロゴを画像と比べる。
+ * ****************************************************************************/
+static void test_main_screens(void) {
+    screen_setup(true, false, 0);
+    press_keys();
+    screen_frame();
+    check_screen("master_hor");
+
+    screen_setup(true, true, 1);
+    press_keys();
+    screen_frame();
+    check_screen("master_ver");
+
+    screen_setup(false, true, 0);
+    screen_frame();
+    check_screen("slave_layer");
+
+    screen_setup(false, true, 0);
+    layer_state = 0;
+    anim_frame  = 0;
+    for (int i = 0; i < 4; i++) {
+        screen_frame();  // ロゴは300ミリ秒ごとに1コマ進む
+    }
+    check_screen("slave_logo");
+}
+
+
+/****************************************************************************
+ * test_diag_pages
+ *
+ * OLED_PG キーで切り替える診断ページを画像と比べる。
+ * レイテンシのページとキーログのページは横表示（2列・時間つき）でも比べる。
+ * ****************************************************************************/
+static void test_diag_pages(void) {
+    static const struct {
+        uint8_t     page;
+        uint8_t     orient;
+        const char *name;
+    } pages[] = {
+        {MTK_OLED_PAGE_SPLIT, 1, "page_split"},
+        {MTK_OLED_PAGE_MATRIX, 1, "page_matrix"},
+        {MTK_OLED_PAGE_LATENCY, 1, "page_latency_ver"},
+        {MTK_OLED_PAGE_LATENCY, 0, "page_latency_hor"},
+        {MTK_OLED_PAGE_KEYLOG, 1, "page_keylog_ver"},
+        {MTK_OLED_PAGE_KEYLOG, 0, "page_keylog_hor"},
+    };
+
+    for (unsigned i = 0; i < sizeof(pages) / sizeof(pages[0]); i++) {
+        screen_setup(true, false, pages[i].orient);
+        press_keys();
+        while (oled_page != pages[i].page) {
+            press_key(OLED_PG, 4, 0);
+        }
+        screen_frame();
+        check_screen(pages[i].name);
+    }
+}
+
+
+/****************************************************************************
+ * check_partial
+ *
+ * 変更後の部分更新の画面と、画面を消して全行を描き直した画面が同じか確かめる。
+ * 違う場合は最初に違うバイトの位置（文字の行と x 座標）を表示する。
+ * ****************************************************************************/
+static void check_partial(const char *screen, const char *change) {
+    uint8_t partial[OLED_MATRIX_SIZE];
+
+    screen_frame();
+    memcpy(partial, oled_emu_buffer(), sizeof(partial));
+    oled_clear();
+    oled_redraw = true;
+    screen_frame();
+    uint16_t i = 0;
+    while (i < sizeof(partial) && partial[i] == oled_emu_buffer()[i]) {
+        i++;
+    }
+    CHECK(i == sizeof(partial), "%s: partial redraw after %s differs from a full redraw (line %u, x %u)", screen, change, i / oled_emu_width(), i % oled_emu_width());
+}
+
+
+/****************************************************************************
+ * test_partial_redraw
+ *
+ * 表示する値を1つずつ変えて、依存する状態（MTK_OLED_DEP_*）の指定に漏れがないことを確かめる。
+ * ****************************************************************************/
+static void test_partial_redraw(void) {
+    static const struct {
+        bool        master;
+        bool        left;
+        uint8_t     orient;
+        const char *name;
+    } screens[] = {
+        {true, false, 0, "master_hor"},
+        {true, true, 1, "master_ver"},
+        {false, true, 0, "slave_layer"},
+    };
+
+    for (unsigned i = 0; i < sizeof(screens) / sizeof(screens[0]); i++) {
+        const char *name = screens[i].name;
+        screen_setup(screens[i].master, screens[i].left, screens[i].orient);
+        screen_frame();
+
+        layer_state = 1u << 5;
+        check_partial(name, "a layer change");
+        mtk_set_cpi(MTK_SIDE_RIGHT, 2400);
+        check_partial(name, "a CPI change");
+        mtk_set_edit_side(MTK_SIDE_LEFT);
+        check_partial(name, "an edit side change");
+        mtk_set_speed_adjust_value(MTK_SIDE_LEFT, 7);
+        check_partial(name, "a speed adjust change");
+        mtk_set_auto_mouse_mode(false);
+        check_partial(name, "an auto mouse change");
+        mtk_set_scroll_mode(true);
+        check_partial(name, "a scroll mode change");
+        mtk_set_scrollsnap_mode(MTK_SIDE_LEFT, MTK_SCROLLSNAP_MODE_FREE);
+        check_partial(name, "a scroll snap change");
+        press_key(0x05, 2, 4);
+        check_partial(name, "a key press");
+        type_count = 9001;
+        check_partial(name, "a type count level change");
+        rgb_values[1] = 20;
+        check_partial(name, "an RGB change");
+        mtk_config.motion.x = -120;
+        check_partial(name, "a motion change");
+        host_time_ms += 60000;
+        check_partial(name, "an uptime change");
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ベンチマーク
+
+/****************************************************************************
+ * bench_frame
+ *
+ * 縦表示で全行を描き直すフレームと、打鍵数だけが変わったフレームのサイクル数を比べる。
+ * ****************************************************************************/
+static void bench_frame(void) {
+    const int calls = 20000;
+    uint64_t  best_full = UINT64_MAX, best_partial = UINT64_MAX;
+
+    screen_setup(true, true, 1);
+    for (int round = 0; round < 5; round++) {
+        uint64_t start = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            oled_redraw = true;
+            screen_frame();
+        }
+        uint64_t mid = host_cycles();
+        for (int i = 0; i < calls; i++) {
+            type_count++;
+            screen_frame();
+        }
+        uint64_t end = host_cycles();
+        best_full    = mid - start < best_full ? mid - start : best_full;
+        best_partial = end - mid < best_partial ? end - mid : best_partial;
+    }
+    printf("bench oled frame (vertical): full %.1f cycles, type count only %.1f cycles\n", (double)best_full / calls, (double)best_partial / calls);
+}
+
+
+int main(int argc, char **argv) {
+    host_time_ms = 125 * 60000;  // 稼働時間が3桁になる時刻から始める
+    for (int i = 1; i < argc; i++) {
+        update_golden |= strcmp(argv[i], "--update") == 0;
+    }
+
+    test_main_screens();
+    test_diag_pages();
+    if (update_golden) {
+        return host_summary("test_oled --update");
+    }
+    test_partial_redraw();
+
+    if (host_bench_enabled(argc, argv)) {
+        bench_frame();
+    }
+    return host_summary("test_oled");
+}
@@ -0,0 +1,677 @@
+/*
+ * tests/test_pointer.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * mtk_pointer.c のホストテスト。
+ * static 関数も直接確かめられるよう、mtk_pointer.c をこのファイルに取り込んでビルドする。
+ *
+ *   test_pointer                 テストを実行
+ *   test_pointer --bench         テストとベンチマークを実行
+ *   test_pointer --replay FILE   移動量のファイルを mtk_pointer_task に通し、出力を表示
+ *   test_pointer --trace FILE    トレース記録のダンプを通し直し、記録と違うレコードを表示
+ */
+
+#include "host.h"
+#include "trace_reader.h"
+#include "../mtk_pointer.c"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 共通
+
+#define BENCH_CALLS  200000  // ベンチマーク1回の計測での呼び出し回数
+#define BENCH_ROUNDS 5       // ベンチマークの計測回数（最小値を採る）
+
+/****************************************************************************
+ * default_config
+ *
+ * mtk64erp.c のデフォルト設定（mtk_config）と同じポインタ処理の設定を作る。
+ * ****************************************************************************/
+static mtk_pointer_config_t default_config(bool scroll_mode) {
+    return (mtk_pointer_config_t){
+        .cpi                  = 1000,
+        .speed_adjust_enabled = true,
+        .speed_adjust_value   = 15,
+        .scroll_mode          = scroll_mode,
+        .scroll_direction     = false,
+        .scroll_div           = 10,
+        .scroll_snap_mode     = MTK_SCROLLSNAP_MODE_VERTICAL,
+        .scroll_resolution    = 120,
+        .inertia_enabled      = true,
+        .inertia_friction     = 235,
+    };
+}
+
+
+/****************************************************************************
+ * pointer_step
+ *
+ * センサーの移動量1回分を mtk_pointer_task に通し、時刻を1ミリ秒進める
+ * （POINTING_DEVICE_TASK_THROTTLE_MS が 0 のため、実機でもほぼ毎ミリ秒呼ばれる）。
+ * ****************************************************************************/
+static report_mouse_t pointer_step(mtk_pointer_t *p, const mtk_pointer_config_t *c, int16_t dx, int16_t dy) {
+    report_mouse_t report = {0};
+    report.x = dx;
+    report.y = dy;
+    report   = mtk_pointer_task(p, c, report);
+    host_time_ms++;
+    return report;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 速度調整テーブル
+
+#define ACCEL_CPI_MIN   100    // 比べるCPIの範囲（PMW33XX_CPI_STEP 単位で設定できる範囲）
+#define ACCEL_CPI_MAX   12000
+#define ACCEL_CPI_STEP  100
+#define ACCEL_SPEED_MIN 8      // 比べる速度調整値の範囲（MTK_SPEED_ADJUST_MIN〜MAX）
+#define ACCEL_SPEED_MAX 20
+
+/****************************************************************************
+ * accel_pow
+ *
+ * 速度調整テーブルにする前の計算式（pow() による c * (|d| / c)^e、c = cpi / 20）。
+ * 結果は速度調整テーブルと同じく INT16_MAX で頭打ちにする。
+ * ****************************************************************************/
+static double accel_pow(int16_t delta, uint16_t cpi, uint8_t speed_adjust_value) {
+    double e = speed_adjust_value / 10.0;
+    double v = pow(fabs((double)delta), e) / pow(cpi / 20, e) * cpi / 20;
+    v        = v > INT16_MAX ? INT16_MAX : v;
+    return delta < 0 ? -v : v;
+}
+
+
+/****************************************************************************
+ * accel_delta_next
+ *
+ * 比べる移動量の列。0〜2048 はすべて、それより大きい値は間引いて INT16_MAX まで。
+ * ****************************************************************************/
+static int32_t accel_delta_next(int32_t d) {
+    return d < 2048 ? d + 1 : (d < INT16_MAX - 7 ? d + 7 : (d < INT16_MAX ? INT16_MAX : INT32_MAX));
+}
+
+
+/****************************************************************************
+ * test_accel_matches_pow
+ *
+ * 移動量 × CPI × 速度調整値を総当たりし、テーブルを引いて丸めた値が
+ * pow() の計算式を丸めた値と 1 以内で一致することを確かめる（正負とも、X/Y とも）。
+ * ****************************************************************************/
+static void test_accel_matches_pow(void) {
+    static mtk_pointer_t p;
+    unsigned             compared = 0;
+    int32_t              worst    = 0;
+
+    for (uint16_t cpi = ACCEL_CPI_MIN; cpi <= ACCEL_CPI_MAX; cpi += ACCEL_CPI_STEP) {
+        for (uint8_t speed = ACCEL_SPEED_MIN; speed <= ACCEL_SPEED_MAX; speed++) {
+            accel_lut_update(&p, cpi, speed);
+            for (int32_t d = 0; d <= INT16_MAX; d = accel_delta_next(d)) {
+                for (int sign = 1; sign >= -1; sign -= 2) {
+                    int16_t delta    = (int16_t)(d * sign);
+                    int32_t expected = (int32_t)lround(accel_pow(delta, cpi, speed));
+                    for (uint8_t axis = 0; axis < 2; axis++) {
+                        int32_t diff = accel_round(accel_apply(&p, axis, delta)) - expected;
+                        diff         = diff < 0 ? -diff : diff;
+                        worst        = diff > worst ? diff : worst;
+                        CHECK(diff <= 1, "cpi %u speed %u delta %d axis %u: lut %d pow %d", cpi, speed, delta, axis,
+                              accel_round(accel_apply(&p, axis, delta)), expected);
+                        compared++;
+                    }
+                }
+            }
+        }
+    }
+    printf("accel: %u values compared with pow(), worst difference %d\n", compared, worst);
+}
+
+
+/****************************************************************************
+ * bench_accel
+ *
+ * 1軸分の速度調整を pow() の計算式とテーブルで比べたサイクル数を計測する。
+ * ホストは FPU を持つため、FPU のない RP2040 では差はこれより大きい。
+ * ****************************************************************************/
+static void bench_accel(void) {
+    static mtk_pointer_t p;
+    static int16_t       deltas[1024];
+    uint32_t             seed = 7;
+    for (int i = 0; i < 1024; i++) {
+        seed      = seed * 1103515245u + 12345u;
+        deltas[i] = (int16_t)((seed >> 16) % 1024) - 512;
+    }
+    accel_lut_update(&p, 1000, 15);
+
+    uint64_t best_pow = UINT64_MAX, best_lut = UINT64_MAX;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint64_t start = host_cycles();
+        for (int i = 0; i < BENCH_CALLS; i++) {
+            HOST_KEEP((int32_t)roundf((float)accel_pow(deltas[i & 1023], 1000, 15)));
+        }
+        uint64_t mid = host_cycles();
+        for (int i = 0; i < BENCH_CALLS; i++) {
+            HOST_KEEP(accel_round(accel_apply(&p, 0, deltas[i & 1023])));
+        }
+        uint64_t end = host_cycles();
+        best_pow     = mid - start < best_pow ? mid - start : best_pow;
+        best_lut     = end - mid < best_lut ? end - mid : best_lut;
+    }
+    printf("bench accel pow(): %.1f cycles/axis, table: %.1f cycles/axis\n", (double)best_pow / BENCH_CALLS, (double)best_lut / BENCH_CALLS);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 端数の繰り越し
+
+/****************************************************************************
+ * test_carry_slow_motion
+ *
+ * 1カウントに満たない移動量（Q8）を繰り返し送ると、端数が溜まって出力される。
+ * 出力の合計は入力の合計を丸めた値と一致し、方向が反転したら逆方向の端数は捨てられる。
+ * ****************************************************************************/
+static void test_carry_slow_motion(void) {
+    // 0.1〜0.45 カウントの動きを繰り返すゆっくりとした移動
+    static const int32_t steps[] = {26, 51, 77, 102, 115, 38, 64};
+    const int            n       = sizeof(steps) / sizeof(steps[0]);
+
+    for (int8_t dir = 1; dir >= -1; dir -= 2) {
+        mtk_pointer_t p = {0};
+        int32_t       in = 0, out = 0, first = -1;
+        for (int i = 0; i < 200; i++) {
+            int32_t q = steps[i % n] * dir;
+            int32_t r = motion_carry_apply(&p, 0, dir, q);
+            in += q;
+            out += r;
+            CHECK(r == 0 || r == dir, "step %d emitted %d", i, r);
+            if (r != 0 && first < 0) {
+                first = i;
+            }
+            // 出力は常に入力の合計を丸めた値に追従する
+            CHECK(out == accel_round(in), "step %d: out %d, in %d/256", i, out, in);
+        }
+        CHECK(first >= 0 && first <= 3, "first output after %d steps", first);
+    }
+
+    // 方向が反転したら逆方向の端数は持ち越さない
+    mtk_pointer_t p = {0};
+    CHECK(motion_carry_apply(&p, 1, 1, 100) == 0, "0.4 count emitted");
+    CHECK(motion_carry_apply(&p, 1, -1, -100) == 0, "reversal emitted the stale carry");
+    CHECK(motion_carry_apply(&p, 1, -1, -100) == -1, "reversed carry not accumulated");
+}
+
+
+/****************************************************************************
+ * test_carry_slow_replay
+ *
+ * 1カウントずつのゆっくりした動きをカーソル移動で通し、速度調整で増えた分の端数も
+ * 失われずに出力されることを確かめる（1カウント = 1 + f(1) の合計と一致する）。
+ * ****************************************************************************/
+static void test_carry_slow_replay(void) {
+    mtk_pointer_config_t c = default_config(false);
+    mtk_pointer_t        p = {0};
+    mtk_pointer_init(&p);
+
+    int32_t out = 0;
+    for (int i = 0; i < 500; i++) {
+        report_mouse_t r = pointer_step(&p, &c, (i % 4) == 0 ? 1 : 0, 0);
+        out += r.y;
+    }
+    int32_t in = 125 * ((1 << MTK_ACCEL_FRAC_BITS) + accel_apply(&p, 0, 1));
+    CHECK(-out == accel_round(in), "125 single counts emitted %d, expected %d", -out, accel_round(in));
+    CHECK(-out > 125, "speed-adjusted fraction lost (%d)", -out);
+}
+
+
+/****************************************************************************
+ * test_carry_saturation
+ *
+ * レポートの範囲（MTK_XY_REPORT_MAX）を超えた分は次のレポート以降に分けて送られ、
+ * 合計は入力と一致する。繰り越しの上限（MTK_MOTION_CARRY_REPORTS 回分）を超えた分だけが捨てられる。
+ * ****************************************************************************/
+static void test_carry_saturation(void) {
+    const int32_t one = 1 << MTK_ACCEL_FRAC_BITS;
+
+    for (int8_t dir = 1; dir >= -1; dir -= 2) {
+        mtk_pointer_t p   = {0};
+        int32_t       q   = (3 * MTK_XY_REPORT_MAX * one + 100) * dir;
+        int32_t       out = motion_carry_apply(&p, 0, dir, q);
+        CHECK(out == MTK_XY_REPORT_MAX * dir, "first report %d", out);
+        for (int i = 0; i < 4; i++) {
+            int32_t r = motion_carry_apply(&p, 0, 0, 0);
+            CHECK(abs(r) <= MTK_XY_REPORT_MAX, "report %d out of range", r);
+            out += r;
+        }
+        CHECK(out == 3 * MTK_XY_REPORT_MAX * dir, "3x max emitted %d", out);
+        CHECK(p.carry[0] == 100 * dir, "fraction %d left", p.carry[0]);
+    }
+
+    // 上限を超えた分は捨てる
+    mtk_pointer_t p   = {0};
+    int32_t       out = motion_carry_apply(&p, 1, 1, (MTK_MOTION_CARRY_REPORTS + 10) * MTK_XY_REPORT_MAX * one);
+    for (int i = 0; i < MTK_MOTION_CARRY_REPORTS + 10; i++) {
+        out += motion_carry_apply(&p, 1, 0, 0);
+    }
+    CHECK(out == MTK_MOTION_CARRY_REPORTS * MTK_XY_REPORT_MAX, "carry limit emitted %d", out);
+}
+
+
+/****************************************************************************
+ * test_flick_distance
+ *
+ * レポートの範囲を超える速いフリックをカーソル移動で通し、出力の合計が
+ * 速度調整後の移動量の合計と一致することを確かめる（範囲で頭打ちになっても失われない）。
+ * ****************************************************************************/
+static void test_flick_distance(void) {
+    // 速度調整後に MTK_XY_REPORT_MAX を超え、レポートの型にも収まる移動量
+    const int16_t        d = MTK_XY_REPORT_MAX < 128 ? 100 : 6000;
+    mtk_pointer_config_t c = default_config(false);
+    mtk_pointer_t        p = {0};
+    mtk_pointer_init(&p);
+
+    int32_t out = 0, peak = 0;
+    for (int i = 0; i < 200; i++) {
+        report_mouse_t r = pointer_step(&p, &c, i < 5 ? d : 0, i < 5 ? -d / 2 : 0);
+        out += -r.y;
+        peak = abs(r.y) > peak ? abs(r.y) : peak;
+        CHECK(abs(r.x) <= MTK_XY_REPORT_MAX && abs(r.y) <= MTK_XY_REPORT_MAX, "report %d %d out of range", r.x, r.y);
+    }
+    int32_t in = accel_round(5 * (d * (1 << MTK_ACCEL_FRAC_BITS) + accel_apply(&p, 0, d)));
+    CHECK(peak == MTK_XY_REPORT_MAX, "flick did not saturate (peak %d)", peak);
+    CHECK(out == in, "flick emitted %d, expected %d", out, in);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// スクロールの分解能
+
+/****************************************************************************
+ * test_scroll_resolution
+ *
+ * 分解能 1（高分解能無効）と 120（POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER）で scroll_to_wheel を通し、
+ * 1ノッチ分（scroll_div * 8 カウント）の移動がそれぞれ 1 と 120 の送信単位になることと、
+ * 1ノッチに満たない移動の端数が繰り越されて出力の合計が入力の合計に追従することを確かめる。
+ * ****************************************************************************/
+static void test_scroll_resolution(void) {
+    static const uint16_t resolutions[] = {1, 120};
+    const int16_t         div           = 10 * 8;  // default_config の scroll_div
+
+    for (unsigned r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++) {
+        const int32_t res = resolutions[r];
+
+        for (int8_t dir = 1; dir >= -1; dir -= 2) {
+            // 1ノッチ
+            int32_t acc = div * res * dir;
+            int32_t out = scroll_to_wheel(&acc, div);
+            CHECK(out == res * dir && acc == 0, "resolution %d: one notch sent %d, left %d", res, out, acc);
+
+            // 1ノッチに満たない移動を繰り返す
+            int32_t in = 0;
+            out        = 0;
+            acc        = 0;
+            for (int i = 0; i < 100; i++) {
+                int32_t counts = (i % 3 + 1) * 7 * dir;  // 7〜21 カウント
+                in += counts;
+                acc += counts * res;
+                out += scroll_to_wheel(&acc, div);
+                CHECK(out == in * res / div, "resolution %d step %d: sent %d, expected %d", res, i, out, in * res / div);
+                CHECK(acc == in * res - out * div, "resolution %d step %d: remainder %d lost", res, i, acc);
+            }
+            CHECK(res > 1 || abs(out) > 1, "resolution %d: fractions never carried over", res);
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// 慣性スクロール
+
+/****************************************************************************
+ * test_inertia_decay
+ *
+ * inertia_coast を繰り返すと速度は1tickごとに friction / 256 倍に減衰し、
+ * 出力の合計は減衰前の速度の合計（Q4）から端数を除いた値と一致する。
+ * 速度が INT16_MAX でも端数を足したときにあふれない。
+ * ****************************************************************************/
+static void test_inertia_decay(void) {
+    const uint8_t friction = 235;
+
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        int16_t velocity = (int16_t)(sign * 400 * (1 << MTK_INERTIA_FRAC_BITS));
+        int16_t frac     = 0;
+        double  model    = velocity;
+        int64_t sum      = 0, out = 0;
+
+        for (int tick = 0; tick < 200 && velocity != 0; tick++) {
+            sum += velocity;
+            out += inertia_coast(&velocity, &frac, friction);
+            model *= friction / 256.0;
+            // 切り捨ての誤差は1tickにつき1未満
+            CHECK(fabs(velocity - model) <= tick + 1, "tick %d: velocity %d, model %.1f", tick, velocity, model);
+            CHECK(abs(frac) < (1 << MTK_INERTIA_FRAC_BITS), "tick %d: frac %d", tick, frac);
+        }
+        CHECK(velocity == 0, "velocity did not decay to 0 (%d)", velocity);
+        CHECK(out * (1 << MTK_INERTIA_FRAC_BITS) + frac == sum, "coasted %lld counts + %d/16 for %lld/16", (long long)out, frac, (long long)sum);
+    }
+
+    int16_t velocity = INT16_MAX, frac = (1 << MTK_INERTIA_FRAC_BITS) - 1;
+    int16_t out      = inertia_coast(&velocity, &frac, friction);
+    CHECK(out == 2048 && frac == 14, "max velocity coasted %d, frac %d", out, frac);
+    velocity = -INT16_MAX;
+    frac     = -((1 << MTK_INERTIA_FRAC_BITS) - 1);
+    out      = inertia_coast(&velocity, &frac, friction);
+    CHECK(out == -2048 && frac == -14, "min velocity coasted %d, frac %d", out, frac);
+}
+
+
+/****************************************************************************
+ * test_inertia_release
+ *
+ * スクロールモードでボールを弾いて離すと、MTK_INERTIA_RELEASE_MS 後から慣性で
+ * スクロールが続き、tickごとの量は減っていき、速度が1カウント/tickを下回ると止まる。
+ * ****************************************************************************/
+static void test_inertia_release(void) {
+    mtk_pointer_config_t c = default_config(true);
+    mtk_pointer_t        p = {0};
+    mtk_pointer_init(&p);
+    host_time_ms = 1000;
+
+    for (int i = 0; i < 30; i++) {
+        pointer_step(&p, &c, -40, 0);
+    }
+    uint32_t release = host_time_ms;
+
+    int32_t  window[300] = {0};  // tickごとのスクロール量
+    uint32_t last        = 0;
+    for (uint32_t t = 0; t < 3000; t++) {
+        report_mouse_t r = pointer_step(&p, &c, 0, 0);
+        CHECK(r.h == 0, "snapped scroll leaked h %d", r.h);
+        if (r.v != 0) {
+            window[t / MTK_INERTIA_TICK_MS] += abs(r.v);
+            last = t;
+        }
+    }
+    CHECK(window[0] == 0 && window[MTK_INERTIA_RELEASE_MS / MTK_INERTIA_TICK_MS + 1] > 0, "coasting did not start after release (%d)", window[4]);
+    CHECK(!p.inertia_coasting && last < 1500, "coasting lasted %u ms after release at %u", last, release);
+
+    int first = MTK_INERTIA_RELEASE_MS / MTK_INERTIA_TICK_MS + 1;
+    for (int w = first + 1; w < 300; w++) {
+        // 端数の繰り越しで前のtickより2単位まで多くなることがある
+        CHECK(window[w] <= window[w - 1] + 2, "tick %d scrolled %d after %d", w, window[w], window[w - 1]);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// スクロールスナップ
+
+/****************************************************************************
+ * snap_step
+ *
+ * scroll_snap_update を1回呼び、時刻を1ミリ秒進める。h, v は軸外を捨てたあとの値になる。
+ * ****************************************************************************/
+static uint8_t snap_step(mtk_pointer_t *p, int16_t *h, int16_t *v, uint8_t mode) {
+    uint8_t applied = scroll_snap_update(p, h, v, mode);
+    host_time_ms++;
+    return applied;
+}
+
+
+/****************************************************************************
+ * test_snap_breakout
+ *
+ * スナップ軸で動かしている間の軸外の揺れは捨てられ、軸外の動きが続いて
+ * テンションが MTK_SCROLLSNAP_TENSION_THRESHOLD に達するとスナップが外れる。
+ * 外れたあとはスナップ軸だけを動かしても、止まるまでは外れたまま。
+ * ****************************************************************************/
+static void test_snap_breakout(void) {
+    static const uint8_t modes[] = {MTK_SCROLLSNAP_MODE_VERTICAL, MTK_SCROLLSNAP_MODE_HORIZONTAL};
+
+    for (uint8_t m = 0; m < 2; m++) {
+        const uint8_t mode = modes[m];
+        mtk_pointer_t p    = {0};
+        host_time_ms       = 1000;
+
+        // スナップ軸の動き + 軸外の小さな揺れ
+        for (int i = 0; i < 50; i++) {
+            int16_t on = 4, off = (i % 3) - 1;
+            int16_t h = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? off : on;
+            int16_t v = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? on : off;
+            CHECK(snap_step(&p, &h, &v, mode) == mode, "mode %u: jitter broke the snap at %d", mode, i);
+            CHECK((mode == MTK_SCROLLSNAP_MODE_VERTICAL ? h : v) == 0, "mode %u: off-axis jitter leaked", mode);
+        }
+
+        // 軸外に動かし続けるとテンションが溜まって外れる
+        int broke = -1;
+        for (int i = 0; i < 20 && broke < 0; i++) {
+            int16_t h = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? 3 : 1;
+            int16_t v = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? 1 : 3;
+            if (snap_step(&p, &h, &v, mode) == MTK_SCROLLSNAP_MODE_FREE) {
+                broke = i;
+                CHECK(h != 0 && v != 0, "mode %u: break-out report dropped an axis", mode);
+            }
+        }
+        // テンションの下限（-MTK_SCROLLBALL_INHIVITOR）から 2/report で閾値まで
+        int expected = (MTK_SCROLLSNAP_TENSION_THRESHOLD + MTK_SCROLLBALL_INHIVITOR + 1) / 2 - 1;
+        CHECK(broke == expected, "mode %u: broke out after %d reports, expected %d", mode, broke, expected);
+
+        // 外れている間はスナップ軸だけの動きでも外れたまま
+        for (int i = 0; i < 20; i++) {
+            int16_t h = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? 0 : 5;
+            int16_t v = mode == MTK_SCROLLSNAP_MODE_VERTICAL ? 5 : 0;
+            CHECK(snap_step(&p, &h, &v, mode) == MTK_SCROLLSNAP_MODE_FREE, "mode %u: re-snapped while moving", mode);
+        }
+    }
+
+    // FREE はそのまま
+    mtk_pointer_t p = {0};
+    int16_t       h = 7, v = 3;
+    CHECK(snap_step(&p, &h, &v, MTK_SCROLLSNAP_MODE_FREE) == MTK_SCROLLSNAP_MODE_FREE && h == 7 && v == 3, "free mode changed the motion");
+}
+
+
+/****************************************************************************
+ * test_snap_resnap
+ *
+ * スナップが外れたあと、ボールが MTK_SCROLLSNAP_RESET_TIMER の間止まるとテンションが戻り、
+ * 次の動きから再びスナップする。それより短い停止では外れたまま。
+ * スクロールモードのレポートで、軸外のホイール（h）が外れている間だけ出ることも確かめる。
+ * ****************************************************************************/
+static void test_snap_resnap(void) {
+    mtk_pointer_config_t c = default_config(true);
+    mtk_pointer_t        p = {0};
+    c.inertia_enabled      = false;
+    mtk_pointer_init(&p);
+    host_time_ms = 1000;
+
+    // 斜めに動かしてスナップを外す（センサーの y が h、x が v になる）
+    int32_t h = 0;
+    for (int i = 0; i < 40; i++) {
+        h += abs(pointer_step(&p, &c, -2, -6).h);
+    }
+    CHECK(h > 0 && p.scroll_snap_tension_h >= MTK_SCROLLSNAP_TENSION_THRESHOLD, "diagonal scroll did not break out (h %d)", h);
+
+    // 短い停止では外れたまま
+    for (int i = 0; i < MTK_SCROLLSNAP_RESET_TIMER - 10; i++) {
+        pointer_step(&p, &c, 0, 0);
+    }
+    h = 0;
+    for (int i = 0; i < 10; i++) {
+        h += abs(pointer_step(&p, &c, -6, -2).h);
+    }
+    CHECK(h > 0, "short pause re-snapped");
+
+    // MTK_SCROLLSNAP_RESET_TIMER 止まると再びスナップする
+    for (int i = 0; i < MTK_SCROLLSNAP_RESET_TIMER; i++) {
+        pointer_step(&p, &c, 0, 0);
+    }
+    h = 0;
+    int32_t v = 0;
+    for (int i = 0; i < 10; i++) {
+        report_mouse_t r = pointer_step(&p, &c, -6, -2);
+        h += abs(r.h);
+        v += abs(r.v);
+    }
+    CHECK(h == 0 && v > 0, "did not re-snap after the reset time (h %d, v %d)", h, v);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// リプレイ
+
+/****************************************************************************
+ * replay_file
+ *
+ * 移動量のファイル（tests/data/pointer_replay.txt の形式）を mtk_pointer_task に通し、
+ * 0 でない出力を「時刻 x y h v」の形式で out に書く。
+ * 行のない時刻も移動量 0 で呼び出すため、慣性スクロールやスナップの時間経過も再現される。
+ * ****************************************************************************/
+static int replay_file(const char *path, FILE *out) {
+    FILE *in = fopen(path, "r");
+    if (in == NULL) {
+        perror(path);
+        return 1;
+    }
+
+    mtk_pointer_t p = {0};
+    mtk_pointer_init(&p);
+    host_time_ms = 0;
+
+    bool     scroll = false;
+    uint32_t t      = 0;
+    int64_t  sum[4] = {0};
+    char     line[128];
+    bool     eof    = false;
+
+    while (!eof) {
+        long     lt = 0;
+        int      dx = 0, dy = 0, s = 0;
+        uint32_t until;
+
+        if (fgets(line, sizeof(line), in) == NULL) {
+            // 最後の行のあとも慣性が止まるまで時間を進める
+            eof   = true;
+            until = t + 1000;
+        } else if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        } else if (sscanf(line, "%ld %d %d %d", &lt, &dx, &dy, &s) != 4 || (uint32_t)lt < t) {
+            fprintf(stderr, "%s: bad line: %s", path, line);
+            fclose(in);
+            return 1;
+        } else {
+            until = (uint32_t)lt;
+        }
+
+        // 行のない時刻は移動量 0 のレポート
+        for (; t <= until; t++) {
+            mtk_pointer_config_t c = default_config(scroll);
+            report_mouse_t       r;
+            if (!eof && t == until) {
+                scroll = s != 0;
+                c      = default_config(scroll);
+                r      = pointer_step(&p, &c, dx, dy);
+            } else {
+                r = pointer_step(&p, &c, 0, 0);
+            }
+            if (r.x != 0 || r.y != 0 || r.h != 0 || r.v != 0) {
+                fprintf(out, "%u %d %d %d %d\n", (unsigned)t, r.x, r.y, r.h, r.v);
+            }
+            sum[0] += r.x;
+            sum[1] += r.y;
+            sum[2] += r.h;
+            sum[3] += r.v;
+        }
+    }
+    fprintf(out, "# total %lld %lld %lld %lld\n", (long long)sum[0], (long long)sum[1], (long long)sum[2], (long long)sum[3]);
+    fclose(in);
+    return 0;
+}
+
+
+/****************************************************************************
+ * replay_trace
+ *
+ * トレース記録のダンプ（trace_reader.h の形式）をデフォルト設定で通し直し、
+ * 記録と違うレコードを表示する。記録したときの設定がデフォルトと違えば一致しない。
+ * ****************************************************************************/
+static int replay_trace(const char *path) {
+    static mtk_trace_record_t records[1 << 16];
+    size_t                    count = trace_load(path, records, sizeof(records) / sizeof(records[0]));
+    if (count == 0) {
+        return 1;
+    }
+
+    mtk_pointer_t p = {0};
+    mtk_pointer_init(&p);
+    unsigned mismatches = trace_replay(&p, default_config(false), records, count, stdout);
+    printf("%s: %zu records, %u differ\n", path, count, mismatches);
+    return 0;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+// ベンチマーク
+
+/****************************************************************************
+ * bench_pointer_task
+ *
+ * mtk_pointer_task 1回あたりのサイクル数を計測する（カーソル移動とスクロール）。
+ * 入力は -256〜255 の範囲の移動量を事前に用意しておき、表の生成は計測から外す。
+ * ****************************************************************************/
+static void bench_pointer_task(void) {
+    static int16_t deltas[1024];
+    uint32_t       seed = 1;
+    for (int i = 0; i < 1024; i++) {
+        seed      = seed * 1103515245u + 12345u;
+        deltas[i] = (int16_t)((seed >> 16) % 512) - 256;
+    }
+
+    for (int scroll = 0; scroll <= 1; scroll++) {
+        mtk_pointer_config_t c = default_config(scroll);
+        mtk_pointer_t        p = {0};
+        mtk_pointer_init(&p);
+        pointer_step(&p, &c, 1, 1);
+
+        uint64_t best = UINT64_MAX;
+        for (int round = 0; round < BENCH_ROUNDS; round++) {
+            uint64_t start = host_cycles();
+            for (int i = 0; i < BENCH_CALLS; i++) {
+                report_mouse_t r = pointer_step(&p, &c, deltas[i & 1023], deltas[(i + 511) & 1023]);
+                HOST_KEEP(r.x + r.y + r.h + r.v);
+            }
+            uint64_t cycles = host_cycles() - start;
+            best            = cycles < best ? cycles : best;
+        }
+        printf("bench mtk_pointer_task (%s): %.1f cycles/call\n", scroll ? "scroll" : "move", (double)best / BENCH_CALLS);
+    }
+}
+
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--replay") == 0) {
+        return replay_file(argv[2], stdout);
+    }
+    if (argc == 3 && strcmp(argv[1], "--trace") == 0) {
+        return replay_trace(argv[2]);
+    }
+
+    test_accel_matches_pow();
+    test_carry_slow_motion();
+    test_carry_slow_replay();
+    test_carry_saturation();
+    test_flick_distance();
+    test_scroll_resolution();
+    test_inertia_decay();
+    test_inertia_release();
+    test_snap_breakout();
+    test_snap_resnap();
+
+    if (host_bench_enabled(argc, argv)) {
+        bench_accel();
+        bench_pointer_task();
+    }
+    return host_summary(MTK_XY_REPORT_MAX < 128 ? "test_pointer_8bit" : "test_pointer");
+}
@@ -0,0 +1,146 @@
+/*
+ * tests/test_trace.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * mtk_trace.c のホストテスト。
+ * 止まっている間のレポートが記録されないことと、raw HID で読み出したダンプを
+ * trace_reader で通し直すと記録と同じ出力になることを確かめる。
+ */
+
+#include "host.h"
+#include "trace_reader.h"
+#include <string.h>
+
+#define DUMP_PATH "build/test_trace.bin"  // 読み出したダンプの書き出し先
+
+
+/****************************************************************************
+ * trace_read
+ *
+ * raw HID の読み出しコマンド（0x03）で index 番目のレコードを取得する。
+ * ****************************************************************************/
+static bool trace_read(uint16_t index, mtk_trace_record_t *record) {
+    uint8_t data[32] = {MTK_TRACE_HID_ID, 0x03, index & 0xFF, index >> 8};
+    if (!mtk_trace_hid_command(data, sizeof(data)) || data[1] == 0xFF) {
+        return false;
+    }
+    memcpy(record, &data[4], sizeof(*record));
+    return true;
+}
+
+
+/****************************************************************************
+ * record_step
+ *
+ * ファームウェアと同じく、変換したレポートを毎回 mtk_trace_record に渡し、時刻を1ミリ秒進める。
+ * ****************************************************************************/
+static void record_step(mtk_pointer_t *p, mtk_pointer_config_t *c, int16_t dx, int16_t dy, uint8_t buttons) {
+    report_mouse_t report = {.buttons = buttons, .x = dx, .y = dy};
+    report                = mtk_pointer_task(p, c, report);
+    mtk_trace_record(dx, dy, &report, c->scroll_mode ? MTK_TRACE_FLAG_SCROLL : 0);
+    host_time_ms++;
+}
+
+
+/****************************************************************************
+ * test_idle_not_recorded
+ *
+ * 止まっている間は最初の1件だけが記録され、ボタンやフラグの変化は移動量が 0 でも記録される。
+ * ****************************************************************************/
+static void test_idle_not_recorded(void) {
+    report_mouse_t idle  = {0};
+    report_mouse_t click = {.buttons = 1};
+
+    mtk_trace_arm();
+    for (int i = 0; i < 100; i++) {
+        mtk_trace_record(0, 0, &idle, 0);
+    }
+    CHECK(mtk_trace_count() == 1, "idle reports recorded %u times", mtk_trace_count());
+
+    mtk_trace_record(0, 0, &click, 0);
+    mtk_trace_record(0, 0, &click, 0);
+    mtk_trace_record(0, 0, &idle, 0);
+    CHECK(mtk_trace_count() == 3, "button press/release recorded %u records", mtk_trace_count() - 1);
+
+    mtk_trace_record(0, 0, &idle, MTK_TRACE_FLAG_SCROLL);
+    mtk_trace_record(0, 0, &idle, MTK_TRACE_FLAG_SCROLL);
+    CHECK(mtk_trace_count() == 4, "flag change recorded %u records", mtk_trace_count() - 3);
+
+    mtk_trace_record(3, 0, &idle, MTK_TRACE_FLAG_SCROLL);
+    mtk_trace_record(3, 0, &idle, MTK_TRACE_FLAG_SCROLL);
+    CHECK(mtk_trace_count() == 6, "motion not recorded every time");
+    mtk_trace_disarm();
+}
+
+
+/****************************************************************************
+ * test_dump_replay
+ *
+ * カーソル移動・クリック・慣性スクロールを含む操作を記録し、raw HID で読み出したダンプを
+ * ファイル経由で読み込んで通し直す。止まっている間の呼び出しを埋めれば出力は記録と一致する。
+ * ****************************************************************************/
+static void test_dump_replay(void) {
+    mtk_pointer_t        p = {0};
+    mtk_pointer_config_t c = {
+        .cpi = 1000, .speed_adjust_enabled = true, .speed_adjust_value = 15,
+        .scroll_div = 10, .scroll_resolution = 120, .inertia_enabled = true, .inertia_friction = 235,
+    };
+    mtk_pointer_init(&p);
+    host_time_ms = 5000;
+    mtk_trace_arm();
+
+    unsigned calls = 0;
+    for (int i = 0; i < 40; i++, calls++) {
+        record_step(&p, &c, (i % 7) - 2, i / 4, 0);
+    }
+    for (int i = 0; i < 300; i++, calls++) {
+        record_step(&p, &c, 0, 0, (i >= 100 && i < 150) ? 1 : 0);
+    }
+    c.scroll_mode = true;
+    for (int i = 0; i < 30; i++, calls++) {
+        record_step(&p, &c, -20 - i, (i % 5) - 2, 0);
+    }
+    for (int i = 0; i < 1500; i++, calls++) {
+        record_step(&p, &c, 0, 0, 0);
+    }
+    mtk_trace_disarm();
+
+    uint16_t count = mtk_trace_count();
+    CHECK(count > 0 && count < calls / 4, "%u records for %u calls", count, calls);
+
+    // 古い順に読み出してダンプを作る
+    static mtk_trace_record_t dump[MTK_TRACE_SIZE];
+    for (uint16_t i = 0; i < count; i++) {
+        CHECK(trace_read(i, &dump[i]), "read %u failed", i);
+    }
+    mtk_trace_record_t extra;
+    CHECK(!trace_read(count, &extra), "read past the end succeeded");
+
+    FILE *out = fopen(DUMP_PATH, "wb");
+    CHECK(out != NULL, "cannot write %s", DUMP_PATH);
+    if (out == NULL) {
+        return;
+    }
+    fwrite(dump, sizeof(mtk_trace_record_t), count, out);
+    fclose(out);
+
+    static mtk_trace_record_t loaded[MTK_TRACE_SIZE];
+    size_t                    n = trace_load(DUMP_PATH, loaded, MTK_TRACE_SIZE);
+    CHECK(n == count, "loaded %zu of %u records", n, count);
+
+    // 記録したときと同じ初期状態・時刻から通し直す
+    mtk_pointer_t q = {0};
+    mtk_pointer_init(&q);
+    host_time_ms        = 5000;
+    c.scroll_mode       = false;
+    unsigned mismatches = trace_replay(&q, c, loaded, n, stderr);
+    CHECK(mismatches == 0, "%u records differ after replay", mismatches);
+}
+
+
+int main(void) {
+    test_idle_not_recorded();
+    test_dump_replay();
+    return host_summary("test_trace");
+}
@@ -0,0 +1,80 @@
+/*
+ * tests/trace_reader.c
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トレース記録のダンプの読み込みと通し直し（trace_reader.h を参照）。
+ */
+
+#include "trace_reader.h"
+#include "host.h"
+
+
+/****************************************************************************
+ * trace_load
+ *
+ * ダンプのファイルからレコードを読み込む。
+ * レコード長で割り切れないファイルは壊れているものとして 0 を返す。
+ * ****************************************************************************/
+size_t trace_load(const char *path, mtk_trace_record_t *records, size_t max) {
+    FILE *in = fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 0;
+    }
+
+    size_t count = fread(records, sizeof(mtk_trace_record_t), max, in);
+    bool   tail  = fgetc(in) != EOF || (count > 0 && ferror(in));
+    fclose(in);
+    if (tail) {
+        fprintf(stderr, "%s: not a sequence of %zu-byte records (max %zu)\n", path, sizeof(mtk_trace_record_t), max);
+        return 0;
+    }
+    return count;
+}
+
+
+/****************************************************************************
+ * trace_replay
+ *
+ * レコードの移動量を mtk_pointer_task に通し、出力を記録と比べる。
+ * 時刻は最初のレコードを基準にミリ秒単位で進め、レコードの間は移動量 0 で呼び出す。
+ * ****************************************************************************/
+unsigned trace_replay(mtk_pointer_t *pointer, mtk_pointer_config_t config, const mtk_trace_record_t *records, size_t count, FILE *log) {
+    unsigned mismatches = 0;
+    if (count == 0) {
+        return 0;
+    }
+
+    uint32_t start = records[0].time_us;
+    uint32_t base  = host_time_ms;
+    uint32_t last  = base;
+    bool     first = true;
+
+    for (size_t i = 0; i < count; i++) {
+        const mtk_trace_record_t *r = &records[i];
+        uint32_t                  t = base + (r->time_us - start) / 1000;
+
+        // 記録されなかった止まっている間の呼び出し（スクロールモードは直前のレコードのまま）
+        for (uint32_t ms = last + 1; !first && ms < t; ms++) {
+            host_time_ms          = ms;
+            report_mouse_t report = {.buttons = records[i - 1].buttons};
+            mtk_pointer_task(pointer, &config, report);
+        }
+
+        config.scroll_mode    = (r->flags & MTK_TRACE_FLAG_SCROLL) != 0;
+        host_time_ms          = t;
+        report_mouse_t report = {.buttons = r->buttons, .x = r->dx, .y = r->dy};
+        report                = mtk_pointer_task(pointer, &config, report);
+        last                  = t;
+        first                 = false;
+
+        if (report.x != r->x || report.y != r->y || report.h != r->h || report.v != r->v) {
+            mismatches++;
+            if (log != NULL) {
+                fprintf(log, "record %zu (%u us, d %d %d): recorded %d %d %d %d, replayed %d %d %d %d\n", i, (unsigned)r->time_us, r->dx, r->dy, r->x, r->y, r->h, r->v, report.x, report.y, report.h, report.v);
+            }
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,31 @@
+/*
+ * tests/trace_reader.h
+ * Copylight 2024 mentako_ya
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * トレース記録（mtk_trace.h）のダンプを読み込み、mtk_pointer_task に通し直す。
+ *
+ * ■ダンプの形式
+ *   raw HID の読み出し（0x03）で得たレコード（data[4..21]、18バイト）を
+ *   古い方から順につなげたバイナリ。
+ *
+ * ■通し直し
+ *   移動量も変化もないレポートは記録されないため、レコードの間の時間は
+ *   1ミリ秒ごとに移動量 0 で mtk_pointer_task を呼び出して埋める。
+ *   左右のトラックボールを同時に動かした記録は合計の移動量しか残らないため一致しない。
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include "mtk_trace.h"
+#include "mtk_pointer.h"
+
+// ダンプを読み込み、読んだレコード数を返す（失敗したら 0）
+size_t trace_load(const char *path, mtk_trace_record_t *records, size_t max);
+
+// 記録された移動量を通し直し、出力が記録と違うレコードの数を返す
+// スクロールモードはレコードの flags に従い、それ以外は config の設定を使う
+// log が NULL でなければ違うレコードを表示する
+unsigned trace_replay(mtk_pointer_t *pointer, mtk_pointer_config_t config, const mtk_trace_record_t *records, size_t count, FILE *log);